@@ -0,0 +1,114 @@
+/*
+ *  SPDX-FileCopyrightText: 2026 KScreen contributors
+ *
+ *  SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QSignalSpy>
+#include <QTest>
+
+#include "../src/backendmanager_p.h"
+#include "../src/brightnesschannel.h"
+#include "../src/config.h"
+#include "../src/getconfigoperation.h"
+#include "../src/metrics.h"
+#include "../src/mode.h"
+#include "../src/output.h"
+
+using namespace KScreen;
+
+class TestBrightnessChannel : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testInterval();
+    void testCoalescing();
+    void testUnknownOutput();
+
+private:
+    ConfigPtr currentConfig() const;
+};
+
+void TestBrightnessChannel::initTestCase()
+{
+    qputenv("KSCREEN_BACKEND", "Fake");
+    BackendManager::instance()->setBackendArgs({{QStringLiteral("TEST_DATA"), TEST_DATA "multipleoutput.json"}});
+}
+
+void TestBrightnessChannel::cleanupTestCase()
+{
+    BackendManager::instance()->shutdownBackend();
+}
+
+ConfigPtr TestBrightnessChannel::currentConfig() const
+{
+    return KScreen::getConfig(ConfigOperation::ReadOnly).result();
+}
+
+void TestBrightnessChannel::testInterval()
+{
+    const ConfigPtr config = currentConfig();
+    QVERIFY(config);
+    const OutputPtr output = config->outputs().first();
+    QVERIFY(output->currentMode());
+
+    BrightnessChannel channel(output);
+    QCOMPARE(channel.outputId(), output->id());
+    const auto frame = std::chrono::nanoseconds(qint64(1'000'000'000 / double(output->currentMode()->refreshRate())));
+    QCOMPARE(channel.interval(), frame);
+    QVERIFY(!channel.isBusy());
+}
+
+void TestBrightnessChannel::testCoalescing()
+{
+    const OutputPtr output = currentConfig()->outputs().first();
+    BrightnessChannel channel(output);
+    QSignalSpy settled(&channel, &BrightnessChannel::settled);
+    QSignalSpy failed(&channel, &BrightnessChannel::failed);
+
+    Metrics::reset();
+    QElapsedTimer timer;
+    timer.start();
+    // A slider being dragged
+    for (int i = 1; i <= 100; ++i) {
+        channel.setBrightness(i / 100.0);
+        channel.setDimming(1.0 - i / 200.0);
+    }
+    QVERIFY(channel.isBusy());
+    QTRY_VERIFY(!channel.isBusy());
+    QVERIFY(!settled.isEmpty());
+    QVERIFY(failed.isEmpty());
+
+    // The first value went out right away, all others were merged into one update a frame later
+    QCOMPARE(Metrics::count(Metrics::Counter::ConfigRebuilds), quint64(2));
+    QVERIFY(std::chrono::nanoseconds(timer.nsecsElapsed()) >= channel.interval());
+
+    const OutputPtr applied = currentConfig()->output(output->id());
+    QCOMPARE(applied->brightness(), 1.0);
+    QCOMPARE(applied->dimming(), 0.5);
+    // Nothing else was touched
+    QCOMPARE(applied->pos(), output->pos());
+    QCOMPARE(applied->currentModeId(), output->currentModeId());
+}
+
+void TestBrightnessChannel::testUnknownOutput()
+{
+    const OutputPtr output = currentConfig()->outputs().first()->clone();
+    output->setId(4242);
+    BrightnessChannel channel(output);
+    QSignalSpy failed(&channel, &BrightnessChannel::failed);
+
+    channel.setBrightness(0.5);
+    QTRY_COMPARE(failed.count(), 1);
+    QVERIFY(!channel.isBusy());
+}
+
+QTEST_GUILESS_MAIN(TestBrightnessChannel)
+
+#include "testbrightnesschannel.moc"
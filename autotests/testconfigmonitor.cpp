@@ -9,6 +9,10 @@
 #include <QSignalSpy>
 #include <QTest>
 
+#include <memory>
+#include <optional>
+
+#include "../src/abstractbackend.h"
 #include "../src/backendmanager_p.h"
 #include "../src/config.h"
 #include "../src/configmonitor.h"
@@ -85,6 +89,174 @@ private Q_SLOTS:
         QTRY_VERIFY(!spy.isEmpty());
         QCOMPARE(spy.size(), 2);
     }
+
+    void testCoalescing()
+    {
+        using namespace std::chrono_literals;
+
+        qputenv("KSCREEN_BACKEND_INPROCESS", "1");
+        KScreen::BackendManager::instance()->shutdownBackend();
+        KScreen::BackendManager::instance()->setBackendArgs({{QStringLiteral("TEST_DATA"), TEST_DATA "multipleoutput.json"}});
+
+        KScreen::ConfigMonitor *monitor = KScreen::ConfigMonitor::instance();
+        monitor->setCoalescingInterval(0ms);
+        QSignalSpy spy(monitor, &KScreen::ConfigMonitor::configurationChanged);
+
+        KScreen::ConfigPtr config = getConfig();
+        QVERIFY(config);
+        monitor->addConfig(config);
+        QCOMPARE(config->output(1)->rotation(), KScreen::Output::None);
+
+        // A burst of backend changes results in a single update with the last config
+        KScreen::AbstractBackend *backend = KScreen::BackendManager::instance()->loadBackendInProcess();
+        const KScreen::Output::Rotation rotations[] = {KScreen::Output::Left, KScreen::Output::Inverted, KScreen::Output::Right};
+        for (const KScreen::Output::Rotation rotation : rotations) {
+            KScreen::ConfigPtr changed = config->clone();
+            changed->output(1)->setRotation(rotation);
+            Q_EMIT backend->configChanged(changed);
+        }
+        QVERIFY(spy.isEmpty());
+
+        QTRY_COMPARE(spy.size(), 1);
+        QCOMPARE(config->output(1)->rotation(), KScreen::Output::Right);
+        QTest::qWait(50);
+        QCOMPARE(spy.size(), 1);
+
+        // Disabling coalescing delivers changes immediately again
+        monitor->setCoalescingInterval(-1ms);
+        KScreen::ConfigPtr changed = config->clone();
+        changed->output(1)->setRotation(KScreen::Output::None);
+        Q_EMIT backend->configChanged(changed);
+        QCOMPARE(spy.size(), 2);
+        QCOMPARE(config->output(1)->rotation(), KScreen::Output::None);
+    }
+
+    void testSubscriptions()
+    {
+        using OutputChange = KScreen::ConfigMonitor::OutputChange;
+
+        qputenv("KSCREEN_BACKEND_INPROCESS", "1");
+        KScreen::BackendManager::instance()->shutdownBackend();
+        KScreen::BackendManager::instance()->setBackendArgs({{QStringLiteral("TEST_DATA"), TEST_DATA "multipleoutput.json"}});
+
+        KScreen::ConfigMonitor *monitor = KScreen::ConfigMonitor::instance();
+        KScreen::ConfigPtr config = getConfig();
+        QVERIFY(config);
+        KScreen::ConfigPtr enabledOnly = getConfig();
+        monitor->addConfig(enabledOnly, OutputChange::Enabled);
+
+        QList<KScreen::ConfigMonitor::OutputChanges> received;
+        auto context = std::make_unique<QObject>();
+        monitor->subscribe(1, OutputChange::Enabled | OutputChange::Brightness, context.get(), [&received](const KScreen::OutputPtr &output, KScreen::ConfigMonitor::OutputChanges changes) {
+            QCOMPARE(output->id(), 1);
+            received.append(changes);
+        });
+
+        KScreen::AbstractBackend *backend = KScreen::BackendManager::instance()->loadBackendInProcess();
+
+        // Neither the subscription nor the masked config care about rotation
+        KScreen::ConfigPtr changed = config->clone();
+        changed->output(1)->setRotation(KScreen::Output::Left);
+        Q_EMIT backend->configChanged(changed);
+        QVERIFY(received.isEmpty());
+        QCOMPARE(enabledOnly->output(1)->rotation(), KScreen::Output::None);
+
+        // Disabling both outputs is reported for the subscribed one only
+        changed = changed->clone();
+        changed->output(1)->setEnabled(false);
+        changed->output(2)->setEnabled(false);
+        Q_EMIT backend->configChanged(changed);
+        QCOMPARE(received.size(), 1);
+        QCOMPARE(received.first(), KScreen::ConfigMonitor::OutputChanges(OutputChange::Enabled));
+        QVERIFY(!enabledOnly->output(1)->isEnabled());
+        QCOMPARE(enabledOnly->output(1)->rotation(), KScreen::Output::Left);
+
+        // The subscription ends with its context
+        context.reset();
+        changed = changed->clone();
+        changed->output(1)->setEnabled(true);
+        Q_EMIT backend->configChanged(changed);
+        QCOMPARE(received.size(), 1);
+        QVERIFY(enabledOnly->output(1)->isEnabled());
+    }
+
+    void testEveryPropertyIsTracked()
+    {
+        using OutputChange = KScreen::ConfigMonitor::OutputChange;
+
+        qputenv("KSCREEN_BACKEND_INPROCESS", "1");
+        KScreen::BackendManager::instance()->shutdownBackend();
+        KScreen::BackendManager::instance()->setBackendArgs({{QStringLiteral("TEST_DATA"), TEST_DATA "multipleoutput.json"}});
+
+        KScreen::ConfigMonitor *monitor = KScreen::ConfigMonitor::instance();
+        KScreen::ConfigPtr config = getConfig();
+        QVERIFY(config);
+        monitor->addConfig(config);
+
+        QList<KScreen::ConfigMonitor::OutputChanges> received;
+        auto context = std::make_unique<QObject>();
+        monitor->subscribe(-1, OutputChange::All, context.get(), [&received](const KScreen::OutputPtr &, KScreen::ConfigMonitor::OutputChanges changes) {
+            received.append(changes);
+        });
+
+        KScreen::AbstractBackend *backend = KScreen::BackendManager::instance()->loadBackendInProcess();
+
+        // Only a custom mode is added
+        KScreen::ConfigPtr changed = config->clone();
+        KScreen::ModeInfo mode;
+        mode.size = QSize(1234, 567);
+        mode.refreshRate = 50;
+        changed->output(1)->setCustomModes({mode});
+        Q_EMIT backend->configChanged(changed);
+        QCOMPARE(received.size(), 1);
+        QCOMPARE(received.last(), KScreen::ConfigMonitor::OutputChanges(OutputChange::Modes));
+        QCOMPARE(config->output(1)->customModes().size(), 1);
+
+        // Brightness overrides and read-only properties are reported as well
+        changed = changed->clone();
+        changed->output(1)->setMaxPeakBrightnessOverride(400);
+        changed->output(2)->setSizeMm(QSize(123, 45));
+        Q_EMIT backend->configChanged(changed);
+        QCOMPARE(received.size(), 3);
+        QVERIFY(received.contains(KScreen::ConfigMonitor::OutputChanges(OutputChange::Brightness)));
+        QVERIFY(received.contains(KScreen::ConfigMonitor::OutputChanges(OutputChange::Other)));
+        QCOMPARE(config->output(1)->maxPeakBrightnessOverride(), std::optional<double>(400));
+        QCOMPARE(config->output(2)->sizeMm(), QSize(123, 45));
+    }
+
+    void testManyWatchedConfigs()
+    {
+        qputenv("KSCREEN_BACKEND_INPROCESS", "1");
+        KScreen::BackendManager::instance()->shutdownBackend();
+        KScreen::BackendManager::instance()->setBackendArgs({{QStringLiteral("TEST_DATA"), TEST_DATA "multipleoutput.json"}});
+
+        KScreen::ConfigMonitor *monitor = KScreen::ConfigMonitor::instance();
+        KScreen::ConfigPtr config = getConfig();
+        QVERIFY(config);
+
+        // Short-lived configs come and go without ever being removed explicitly
+        QList<KScreen::ConfigPtr> watched;
+        for (int i = 0; i < 1000; ++i) {
+            KScreen::ConfigPtr clone = config->clone();
+            monitor->addConfig(clone);
+            monitor->addConfig(clone);
+            if (i % 2) {
+                watched.append(clone);
+            }
+        }
+        const KScreen::ConfigPtr removed = watched.takeLast();
+        monitor->removeConfig(removed);
+
+        KScreen::AbstractBackend *backend = KScreen::BackendManager::instance()->loadBackendInProcess();
+        KScreen::ConfigPtr changed = config->clone();
+        changed->output(1)->setRotation(KScreen::Output::Left);
+        Q_EMIT backend->configChanged(changed);
+
+        for (const KScreen::ConfigPtr &clone : std::as_const(watched)) {
+            QCOMPARE(clone->output(1)->rotation(), KScreen::Output::Left);
+        }
+        QCOMPARE(removed->output(1)->rotation(), KScreen::Output::None);
+    }
 };
 
 QTEST_MAIN(TestConfigMonitor)
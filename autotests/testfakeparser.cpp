@@ -0,0 +1,205 @@
+/*
+ *  SPDX-FileCopyrightText: 2026 KScreen contributors
+ *
+ *  SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMetaEnum>
+#include <QObject>
+#include <QTest>
+
+#include "../backends/fake/parser.h"
+#include "../src/config.h"
+#include "../src/configserializer_p.h"
+#include "../src/mode.h"
+#include "../src/output.h"
+#include "../src/screen.h"
+
+using namespace KScreen;
+
+class TestFakeParser : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testFixtures_data();
+    void testFixtures();
+    void testRejectInvalid_data();
+    void testRejectInvalid();
+    void testSerializerRoundTrip();
+    void testOutputTypes_data();
+    void testOutputTypes();
+    void benchmarkManyOutputs();
+
+private:
+    static QByteArray manyOutputs(int outputCount, int modeCount);
+};
+
+void TestFakeParser::testFixtures_data()
+{
+    QTest::addColumn<QString>("path");
+
+    const QDir configs(QStringLiteral(TEST_DATA));
+    const QStringList fixtures = configs.entryList({QStringLiteral("*.json")}, QDir::Files);
+    QVERIFY(!fixtures.isEmpty());
+    for (const QString &fixture : fixtures) {
+        QTest::newRow(qPrintable(fixture)) << configs.filePath(fixture);
+    }
+}
+
+void TestFakeParser::testFixtures()
+{
+    QFETCH(QString, path);
+
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+
+    const auto config = Parser::parse(file.readAll());
+    QVERIFY2(config.has_value(), qPrintable(config.error()));
+    QVERIFY((*config)->screen());
+}
+
+void TestFakeParser::testRejectInvalid_data()
+{
+    QTest::addColumn<QByteArray>("json");
+    QTest::addColumn<QString>("error");
+
+    QTest::newRow("syntax") << QByteArray("{\"outputs\": [") << QStringLiteral("offset");
+    QTest::newRow("top-level") << QByteArray(R"({"output": []})") << QStringLiteral("<root>: unknown key \"output\"");
+    QTest::newRow("output") << QByteArray(R"({"outputs": [{"id": 1}, {"id": 2, "nmae": "DP-1"}]})")
+                            << QStringLiteral("outputs[1]: unknown key \"nmae\"");
+    QTest::newRow("mode") << QByteArray(R"({"outputs": [{"id": 1, "modes": [{"id": 1}, {"id": 2, "refreshrate": 60}]}]})")
+                          << QStringLiteral("outputs[0].modes[1]: unknown key \"refreshrate\"");
+    QTest::newRow("size") << QByteArray(R"({"screen": {"maxSize": {"width": 1, "hieght": 2}}})")
+                          << QStringLiteral("screen.maxSize: unknown key \"hieght\"");
+    QTest::newRow("not an array") << QByteArray(R"({"outputs": {"id": 1}})") << QStringLiteral("outputs: expected an array");
+    QTest::newRow("not an object") << QByteArray(R"({"outputs": [{"id": 1, "pos": 5}]})") << QStringLiteral("outputs[0].pos: expected an object");
+}
+
+void TestFakeParser::testRejectInvalid()
+{
+    QFETCH(QByteArray, json);
+    QFETCH(QString, error);
+
+    const auto config = Parser::parse(json);
+    QVERIFY(!config.has_value());
+    QVERIFY2(config.error().startsWith(error), qPrintable(config.error()));
+    QVERIFY(!Parser::validate(json));
+}
+
+void TestFakeParser::testSerializerRoundTrip()
+{
+    const ConfigPtr config = Parser::fromJson(QStringLiteral(TEST_DATA "multipleoutput.json"));
+    QVERIFY(config);
+
+    const QByteArray json = QJsonDocument(ConfigSerializer::serializeConfig(config)).toJson();
+    const auto parsed = Parser::parse(json);
+    QVERIFY2(parsed.has_value(), qPrintable(parsed.error()));
+
+    const ConfigPtr copy = *parsed;
+    QCOMPARE(copy->outputs().count(), config->outputs().count());
+    QCOMPARE(copy->screen()->currentSize(), config->screen()->currentSize());
+    for (const OutputPtr &output : config->outputs()) {
+        const OutputPtr other = copy->output(output->id());
+        QVERIFY(other);
+        QCOMPARE(other->name(), output->name());
+        QCOMPARE(other->pos(), output->pos());
+        QCOMPARE(other->priority(), output->priority());
+        QCOMPARE(other->currentModeId(), output->currentModeId());
+        QCOMPARE(other->modes().count(), output->modes().count());
+    }
+}
+
+void TestFakeParser::testOutputTypes_data()
+{
+    QTest::addColumn<QJsonValue>("type");
+    QTest::addColumn<Output::Type>("expected");
+
+    const QMetaEnum types = QMetaEnum::fromType<Output::Type>();
+    for (int i = 0; i < types.keyCount(); ++i) {
+        const auto type = static_cast<Output::Type>(types.value(i));
+        QTest::newRow(types.key(i)) << QJsonValue(types.value(i)) << type;
+    }
+
+    QTest::newRow("out of range") << QJsonValue(Output::DisplayPort + 1) << Output::Unknown;
+    QTest::newRow("eDP-1") << QJsonValue(QStringLiteral("eDP-1")) << Output::Panel;
+    QTest::newRow("Panel") << QJsonValue(QStringLiteral("Panel")) << Output::Panel;
+    QTest::newRow("DVI-D-1") << QJsonValue(QStringLiteral("DVI-D-1")) << Output::DVID;
+    QTest::newRow("TV-SVideo") << QJsonValue(QStringLiteral("TV-SVideo")) << Output::TVSVideo;
+    QTest::newRow("DisplayPort") << QJsonValue(QStringLiteral("DisplayPort")) << Output::DisplayPort;
+    QTest::newRow("DP-2") << QJsonValue(QStringLiteral("DP-2")) << Output::DisplayPort;
+}
+
+void TestFakeParser::testOutputTypes()
+{
+    QFETCH(QJsonValue, type);
+    QFETCH(Output::Type, expected);
+
+    const QJsonObject output{{QStringLiteral("id"), 1}, {QStringLiteral("type"), type}};
+    const QByteArray json = QJsonDocument(QJsonObject{{QStringLiteral("outputs"), QJsonArray{output}}}).toJson();
+    const auto config = Parser::parse(json);
+    QVERIFY2(config.has_value(), qPrintable(config.error()));
+    QCOMPARE((*config)->output(1)->type(), expected);
+
+    // What the serializer writes comes back unchanged
+    const auto copy = Parser::parse(QJsonDocument(ConfigSerializer::serializeConfig(*config)).toJson());
+    QVERIFY2(copy.has_value(), qPrintable(copy.error()));
+    QCOMPARE((*copy)->output(1)->type(), expected);
+}
+
+QByteArray TestFakeParser::manyOutputs(int outputCount, int modeCount)
+{
+    QJsonArray outputs;
+    for (int i = 1; i <= outputCount; ++i) {
+        QJsonArray modes;
+        for (int j = 1; j <= modeCount; ++j) {
+            modes.append(QJsonObject{
+                {QStringLiteral("id"), j},
+                {QStringLiteral("name"), QStringLiteral("%1x%2").arg(640 + j * 64).arg(480 + j * 48)},
+                {QStringLiteral("refreshRate"), 60.0},
+                {QStringLiteral("size"), QJsonObject{{QStringLiteral("width"), 640 + j * 64}, {QStringLiteral("height"), 480 + j * 48}}},
+            });
+        }
+        outputs.append(QJsonObject{
+            {QStringLiteral("id"), i},
+            {QStringLiteral("name"), QStringLiteral("DP-%1").arg(i)},
+            {QStringLiteral("type"), QStringLiteral("DisplayPort")},
+            {QStringLiteral("connected"), true},
+            {QStringLiteral("enabled"), true},
+            {QStringLiteral("priority"), i},
+            {QStringLiteral("currentModeId"), modeCount},
+            {QStringLiteral("preferredModes"), QJsonArray{modeCount}},
+            {QStringLiteral("pos"), QJsonObject{{QStringLiteral("x"), i * 1920}, {QStringLiteral("y"), 0}}},
+            {QStringLiteral("scale"), 1.0},
+            {QStringLiteral("rotation"), 1},
+            {QStringLiteral("modes"), modes},
+        });
+    }
+
+    const QJsonObject screen{
+        {QStringLiteral("id"), 1},
+        {QStringLiteral("maxActiveOutputsCount"), outputCount},
+        {QStringLiteral("currentSize"), QJsonObject{{QStringLiteral("width"), outputCount * 1920}, {QStringLiteral("height"), 1080}}},
+    };
+    return QJsonDocument(QJsonObject{{QStringLiteral("screen"), screen}, {QStringLiteral("outputs"), outputs}}).toJson();
+}
+
+void TestFakeParser::benchmarkManyOutputs()
+{
+    const QByteArray json = manyOutputs(128, 24);
+
+    QBENCHMARK {
+        const auto config = Parser::parse(json);
+        QVERIFY(config.has_value());
+        QCOMPARE((*config)->outputs().count(), 128);
+    }
+}
+
+QTEST_GUILESS_MAIN(TestFakeParser)
+
+#include "testfakeparser.moc"
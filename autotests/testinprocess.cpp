@@ -6,15 +6,19 @@
 
 #include <QCoreApplication>
 #include <QElapsedTimer>
+#include <QFile>
 #include <QLoggingCategory>
 #include <QObject>
 #include <QSignalSpy>
+#include <QStandardPaths>
 #include <QTest>
 
+#include "../src/abstractbackend.h"
 #include "../src/backendmanager_p.h"
 #include "../src/config.h"
 #include "../src/configmonitor.h"
 #include "../src/getconfigoperation.h"
+#include "../src/metrics.h"
 #include "../src/mode.h"
 #include "../src/output.h"
 #include "../src/setconfigoperation.h"
@@ -40,6 +44,12 @@ private Q_SLOTS:
 
     void testCreateJob();
     void testBackendCaching();
+    void testSnapshot();
+    void testExpectedGeneration();
+    void testFutures();
+    void testPartialApply();
+    void testAsyncStartup();
+    void testCachedStartup();
 
     void testConfigApply();
     void testConfigMonitor();
@@ -56,6 +66,7 @@ TestInProcess::TestInProcess(QObject *parent)
 
 void TestInProcess::initTestCase()
 {
+    QStandardPaths::setTestModeEnabled(true);
 }
 
 void TestInProcess::init()
@@ -70,6 +81,7 @@ void TestInProcess::init()
 void TestInProcess::cleanup()
 {
     KScreen::BackendManager::instance()->shutdownBackend();
+    qunsetenv("KSCREEN_BACKEND_ASYNC");
 }
 
 void TestInProcess::loadConfig()
@@ -124,6 +136,226 @@ void TestInProcess::testBackendCaching()
     KScreen::BackendManager::instance()->shutdownBackend();
 }
 
+void TestInProcess::testSnapshot()
+{
+    auto readOnly = []() {
+        auto op = new GetConfigOperation(GetConfigOperation::ReadOnly);
+        return op->exec() ? op->config() : ConfigPtr();
+    };
+
+    const ConfigPtr snapshot = readOnly();
+    QVERIFY(snapshot);
+    QVERIFY(snapshot->generation() > 0);
+    QVERIFY(snapshot->outputs().first()->edid());
+
+    // Read-only requests share the snapshot while nothing changes
+    QCOMPARE(readOnly(), snapshot);
+
+    // Callers not interested in EDIDs don't pay for loading them
+    auto noEdid = new GetConfigOperation(GetConfigOperation::Options(GetConfigOperation::ReadOnly) | GetConfigOperation::NoEDID);
+    QVERIFY(noEdid->exec());
+    QVERIFY(noEdid->config() != snapshot);
+    QVERIFY(!noEdid->config()->outputs().first()->edid());
+    QCOMPARE(noEdid->config()->generation(), snapshot->generation());
+    noEdid = new GetConfigOperation(GetConfigOperation::NoEDID);
+    QVERIFY(noEdid->exec());
+    QVERIFY(!noEdid->config()->outputs().first()->edid());
+
+    // Everybody else gets a private copy of it
+    auto op = new GetConfigOperation();
+    QVERIFY(op->exec());
+    const ConfigPtr copy = op->config();
+    QVERIFY(copy != snapshot);
+    QCOMPARE(copy->generation(), snapshot->generation());
+    QCOMPARE(copy->outputs().count(), snapshot->outputs().count());
+
+    // A backend change starts a new generation
+    AbstractBackend *backend = BackendManager::instance()->loadBackendInProcess();
+    const ConfigPtr changed = copy->clone();
+    changed->outputs().first()->setRotation(Output::Left);
+    Q_EMIT backend->configChanged(changed);
+    QVERIFY(BackendManager::instance()->generation() > snapshot->generation());
+
+    const ConfigPtr newSnapshot = readOnly();
+    QVERIFY(newSnapshot != snapshot);
+    QCOMPARE(newSnapshot->generation(), BackendManager::instance()->generation());
+}
+
+void TestInProcess::testExpectedGeneration()
+{
+    auto getConfig = []() {
+        auto op = new GetConfigOperation();
+        return op->exec() ? op->config() : ConfigPtr();
+    };
+
+    const ConfigPtr config = getConfig();
+    QVERIFY(config);
+
+    auto setop = new SetConfigOperation(config);
+    setop->setExpectedGeneration(config->generation());
+    QVERIFY(setop->exec());
+    QVERIFY(!setop->isStale());
+
+    // Applying moved the backend to the next generation, so the config is stale now
+    QVERIFY(BackendManager::instance()->generation() > config->generation());
+    config->outputs().first()->setRotation(Output::Left);
+    setop = new SetConfigOperation(config);
+    setop->setExpectedGeneration(config->generation());
+    QVERIFY(!setop->exec());
+    QVERIFY(setop->hasError());
+    QVERIFY(setop->isStale());
+    QCOMPARE(getConfig()->outputs().first()->rotation(), Output::None);
+
+    // Redoing the change on top of the current state succeeds
+    const ConfigPtr current = getConfig();
+    current->outputs().first()->setRotation(Output::Left);
+    setop = new SetConfigOperation(current);
+    setop->setExpectedGeneration(current->generation());
+    QVERIFY(setop->exec());
+    QCOMPARE(getConfig()->outputs().first()->rotation(), Output::Left);
+}
+
+void TestInProcess::testFutures()
+{
+    // Once the backend is up, no event loop is needed
+    const QFuture<ConfigPtr> pendingConfig = KScreen::getConfig();
+    QVERIFY(pendingConfig.isFinished());
+    const ConfigPtr config = pendingConfig.result();
+    QVERIFY(config);
+
+    config->outputs().first()->setRotation(Output::Left);
+    const QFuture<SetConfigResult> pendingResult = KScreen::setConfig(config, config->generation());
+    QVERIFY(pendingResult.isFinished());
+    QVERIFY(pendingResult.result().has_value());
+    QCOMPARE(KScreen::getConfig(ConfigOperation::ReadOnly).result()->outputs().first()->rotation(), Output::Left);
+
+    // The config is outdated after applying it
+    QVERIFY(!KScreen::setConfig(config, config->generation()).result().has_value());
+}
+
+void TestInProcess::testPartialApply()
+{
+    const ConfigPtr config = KScreen::getConfig().result();
+    QVERIFY(config);
+    const OutputPtr output = config->outputs().first();
+    const OutputPtr other = config->outputs().last();
+    output->setRotation(Output::Left);
+    output->setBrightness(0.5);
+    other->setPos(QPoint(4242, 0));
+
+    // Only the brightness of the named output is applied
+    auto setop = new SetConfigOperation(config, {{output->id(), ConfigMonitor::OutputChange::Brightness}});
+    QVERIFY(setop->exec());
+    ConfigPtr current = KScreen::getConfig(ConfigOperation::ReadOnly).result();
+    QCOMPARE(current->output(output->id())->brightness(), 0.5);
+    QCOMPARE(current->output(output->id())->rotation(), Output::None);
+    QVERIFY(current->output(other->id())->pos() != QPoint(4242, 0));
+
+    // Groups can be combined
+    const ConfigMonitor::OutputChanges changes = ConfigMonitor::OutputChange::Geometry | ConfigMonitor::OutputChange::Brightness;
+    QVERIFY(KScreen::setConfig(config, {{output->id(), changes}}).result().has_value());
+    current = KScreen::getConfig(ConfigOperation::ReadOnly).result();
+    QCOMPARE(current->output(output->id())->rotation(), Output::Left);
+
+    // Only the named outputs are needed, the others keep the backend's state
+    const ConfigPtr single(new Config);
+    single->addOutput(output->clone());
+    single->output(output->id())->setBrightness(0.25);
+    QVERIFY(KScreen::setConfig(single, {{output->id(), ConfigMonitor::OutputChange::Brightness}}).result().has_value());
+    current = KScreen::getConfig(ConfigOperation::ReadOnly).result();
+    QCOMPARE(current->outputs().count(), config->outputs().count());
+    QCOMPARE(current->output(output->id())->brightness(), 0.25);
+    QCOMPARE(current->output(output->id())->rotation(), Output::Left);
+
+    // Naming an output that does not exist fails without touching anything
+    setop = new SetConfigOperation(config, {{4242, ConfigMonitor::OutputChange::Geometry}});
+    QVERIFY(!setop->exec());
+    QVERIFY(setop->hasError());
+    QVERIFY(!setop->isStale());
+}
+
+void TestInProcess::testAsyncStartup()
+{
+    // The roundtrips the Wayland backend waits for are covered by testwaylandroundtrips
+    qputenv("KSCREEN_BACKEND_ASYNC", "1");
+    Metrics::reset();
+
+    const QFuture<ConfigPtr> pendingConfig = KScreen::getConfig();
+    const QFuture<void> backendReady = BackendManager::instance()->loadBackendInProcess()->ready();
+    // The caller gets control back before the backend finished initializing
+    QVERIFY(!backendReady.isFinished());
+    QVERIFY(!pendingConfig.isFinished());
+    // and the config arrives once it did
+    QTRY_VERIFY(backendReady.isFinished());
+    QTRY_VERIFY(pendingConfig.isFinished());
+
+    // How long it took is recorded once
+    const Metrics::Histogram startup = Metrics::histogram(Metrics::Stage::Startup);
+    QCOMPARE(startup.count(), quint64(1));
+    QVERIFY(startup.max() > std::chrono::nanoseconds(0));
+
+    const ConfigPtr config = pendingConfig.result();
+    QVERIFY(config);
+    QVERIFY(config->isValid());
+    QCOMPARE(config->outputs().count(), 2);
+
+    // Once initialized, no waiting is involved anymore
+    QVERIFY(KScreen::getConfig().isFinished());
+
+    // Operations started right after the backend was created wait for it as well
+    BackendManager::instance()->shutdownBackend();
+    auto op = new GetConfigOperation();
+    QVERIFY(op->exec());
+    QVERIFY(op->config());
+    QCOMPARE(op->config()->outputs().count(), 2);
+}
+
+void TestInProcess::testCachedStartup()
+{
+    QFile::remove(BackendManager::configCachePath());
+    qputenv("KSCREEN_BACKEND_ASYNC", "1");
+
+    // Without a cache, there is nothing to show before the backend is ready
+    QFuture<ConfigPtr> pendingConfig = KScreen::getConfig(ConfigOperation::AllowCached);
+    QVERIFY(!pendingConfig.isFinished());
+    QTRY_VERIFY(pendingConfig.isFinished());
+    QVERIFY(pendingConfig.result());
+    QVERIFY(!pendingConfig.result()->isCached());
+    QTRY_VERIFY(QFile::exists(BackendManager::configCachePath()));
+
+    // The next start shows the last known state right away
+    BackendManager::instance()->shutdownBackend();
+    pendingConfig = KScreen::getConfig(ConfigOperation::AllowCached);
+    QVERIFY(pendingConfig.isFinished());
+    const ConfigPtr config = pendingConfig.result();
+    QVERIFY(config);
+    QVERIFY(config->isCached());
+    QCOMPARE(config->outputs().count(), 2);
+    QVERIFY(config->clone()->isCached());
+    // It may be outdated, so it cannot be applied
+    QVERIFY(!KScreen::setConfig(config).result().has_value());
+    const ConfigPtr cached = config->clone();
+
+    // The live state follows once the backend is ready
+    const quint64 cachedGeneration = config->generation();
+    ConfigMonitor::instance()->addConfig(config);
+    QSignalSpy spy(ConfigMonitor::instance(), &ConfigMonitor::configurationChanged);
+    QVERIFY(spy.wait());
+    QVERIFY(!config->isCached());
+    QVERIFY(config->generation() > cachedGeneration);
+    QCOMPARE(config->outputs().count(), 2);
+    ConfigMonitor::instance()->removeConfig(config);
+
+    // The operation tells the rejected cached config apart from other failures
+    auto setop = new SetConfigOperation(cached);
+    QVERIFY(!setop->exec());
+    QVERIFY(setop->isStale());
+
+    // Without the option, callers keep waiting for the live state
+    BackendManager::instance()->shutdownBackend();
+    QVERIFY(!KScreen::getConfig().isFinished());
+}
+
 void TestInProcess::testCreateJob()
 {
     KScreen::BackendManager::instance()->shutdownBackend();
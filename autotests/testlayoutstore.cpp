@@ -0,0 +1,153 @@
+/*
+ *  SPDX-FileCopyrightText: 2026 KScreen contributors
+ *
+ *  SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include <QFile>
+#include <QObject>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <memory>
+
+#include "../backends/fake/parser.h"
+#include "../src/config.h"
+#include "../src/layoutstore.h"
+#include "../src/mode.h"
+#include "../src/output.h"
+
+using namespace KScreen;
+
+class TestLayoutStore : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+
+    void testFingerprint();
+    void testSaveRestore();
+    void testSharedBetweenStores();
+    void testRemove();
+    void testCorruptFile();
+
+private:
+    QString storePath() const;
+
+    std::unique_ptr<QTemporaryDir> m_dir;
+};
+
+void TestLayoutStore::init()
+{
+    m_dir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_dir->isValid());
+}
+
+QString TestLayoutStore::storePath() const
+{
+    return m_dir->filePath(QStringLiteral("layouts"));
+}
+
+void TestLayoutStore::testFingerprint()
+{
+    const ConfigPtr config = Parser::fromJson(QStringLiteral(TEST_DATA "multipleoutput.json"));
+    QVERIFY(config);
+    const quint64 fingerprint = LayoutStore::fingerprint(config);
+
+    // State and order don't matter, only which outputs are connected
+    const ConfigPtr moved = config->clone();
+    moved->outputs().first()->setPos(QPoint(4000, 0));
+    moved->outputs().first()->setEnabled(false);
+    QCOMPARE(LayoutStore::fingerprint(moved), fingerprint);
+
+    const ConfigPtr unplugged = config->clone();
+    unplugged->outputs().last()->setConnected(false);
+    QVERIFY(LayoutStore::fingerprint(unplugged) != fingerprint);
+}
+
+void TestLayoutStore::testSaveRestore()
+{
+    LayoutStore store(storePath());
+    const ConfigPtr config = Parser::fromJson(QStringLiteral(TEST_DATA "multipleoutput.json"));
+    QVERIFY(config);
+    QVERIFY(!store.contains(LayoutStore::fingerprint(config)));
+    QVERIFY(!store.restore(config));
+
+    const OutputPtr output = config->outputs().first();
+    const QString modeId = output->modes().last()->id();
+    output->setPos(QPoint(100, 200));
+    output->setScale(1.5);
+    output->setRotation(Output::Left);
+    output->setCurrentModeId(modeId);
+    QVERIFY(store.save(config));
+    QVERIFY(store.contains(LayoutStore::fingerprint(config)));
+    QCOMPARE(store.fingerprints(), QList<quint64>{LayoutStore::fingerprint(config)});
+
+    const ConfigPtr current = Parser::fromJson(QStringLiteral(TEST_DATA "multipleoutput.json"));
+    QVERIFY(store.restore(current));
+    const OutputPtr restored = current->output(output->id());
+    QCOMPARE(restored->pos(), QPoint(100, 200));
+    QCOMPARE(restored->scale(), 1.5);
+    QCOMPARE(restored->rotation(), Output::Left);
+    QCOMPARE(restored->currentModeId(), modeId);
+
+    // Another set of outputs has no layout yet
+    current->outputs().last()->setConnected(false);
+    QVERIFY(!store.restore(current));
+}
+
+void TestLayoutStore::testSharedBetweenStores()
+{
+    LayoutStore reader(storePath());
+    const ConfigPtr config = Parser::fromJson(QStringLiteral(TEST_DATA "multipleoutput.json"));
+    QVERIFY(config);
+    QVERIFY(!reader.contains(LayoutStore::fingerprint(config)));
+
+    LayoutStore writer(storePath());
+    QVERIFY(writer.save(config));
+    QVERIFY(reader.contains(LayoutStore::fingerprint(config)));
+
+    const ConfigPtr unplugged = config->clone();
+    unplugged->outputs().last()->setConnected(false);
+    QVERIFY(writer.save(unplugged));
+    QCOMPARE(reader.fingerprints().count(), 2);
+    QVERIFY(reader.contains(LayoutStore::fingerprint(config)));
+    QVERIFY(reader.contains(LayoutStore::fingerprint(unplugged)));
+}
+
+void TestLayoutStore::testRemove()
+{
+    LayoutStore store(storePath());
+    const ConfigPtr config = Parser::fromJson(QStringLiteral(TEST_DATA "multipleoutput.json"));
+    QVERIFY(config);
+    const quint64 fingerprint = LayoutStore::fingerprint(config);
+
+    QVERIFY(!store.remove(fingerprint));
+    QVERIFY(store.save(config));
+    QVERIFY(store.remove(fingerprint));
+    QVERIFY(!store.contains(fingerprint));
+    QVERIFY(store.fingerprints().isEmpty());
+}
+
+void TestLayoutStore::testCorruptFile()
+{
+    QFile file(storePath());
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(QByteArray(64, 'x'));
+    file.close();
+
+    LayoutStore store(storePath());
+    const ConfigPtr config = Parser::fromJson(QStringLiteral(TEST_DATA "multipleoutput.json"));
+    QVERIFY(config);
+    QVERIFY(!store.contains(LayoutStore::fingerprint(config)));
+    QVERIFY(!store.restore(config));
+
+    // Saving starts over
+    QVERIFY(store.save(config));
+    QVERIFY(store.contains(LayoutStore::fingerprint(config)));
+}
+
+QTEST_GUILESS_MAIN(TestLayoutStore)
+
+#include "testlayoutstore.moc"
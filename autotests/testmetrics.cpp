@@ -0,0 +1,138 @@
+/*
+ *  SPDX-FileCopyrightText: 2026 KScreen contributors
+ *
+ *  SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include <QObject>
+#include <QSignalSpy>
+#include <QTest>
+
+#include "../src/backendmanager_p.h"
+#include "../src/config.h"
+#include "../src/configmonitor.h"
+#include "../src/getconfigoperation.h"
+#include "../src/metrics.h"
+#include "../src/setconfigoperation.h"
+
+using namespace KScreen;
+using namespace std::chrono_literals;
+
+class TestMetrics : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void testBuckets();
+    void testPercentiles();
+    void testEmpty();
+    void testReset();
+    void testApply();
+};
+
+void TestMetrics::init()
+{
+    qputenv("KSCREEN_BACKEND", "Fake");
+    BackendManager::instance()->shutdownBackend();
+    BackendManager::instance()->setBackendArgs({{QStringLiteral("TEST_DATA"), TEST_DATA "multipleoutput.json"}});
+    Metrics::reset();
+}
+
+void TestMetrics::cleanup()
+{
+    BackendManager::instance()->shutdownBackend();
+}
+
+void TestMetrics::testBuckets()
+{
+    Metrics::Histogram histogram;
+    histogram.add(500ns);
+    histogram.add(1us);
+    histogram.add(3us);
+    histogram.add(-1ms);
+    histogram.add(24h);
+
+    QCOMPARE(histogram.count(), quint64(5));
+    QCOMPARE(histogram.bucket(0), quint64(2)); // 500ns and the negative duration, clamped to zero
+    QCOMPARE(histogram.bucket(1), quint64(1));
+    QCOMPARE(histogram.bucket(2), quint64(1));
+    QCOMPARE(histogram.bucket(Metrics::Histogram::BucketCount - 1), quint64(1));
+    QCOMPARE(histogram.min(), std::chrono::nanoseconds(0ns));
+    QCOMPARE(histogram.max(), std::chrono::nanoseconds(24h));
+
+    QCOMPARE(Metrics::Histogram::bucketUpperBound(0), std::chrono::nanoseconds(1us));
+    QCOMPARE(Metrics::Histogram::bucketUpperBound(10), std::chrono::nanoseconds(1024us));
+}
+
+void TestMetrics::testPercentiles()
+{
+    Metrics::Histogram histogram;
+    for (int i = 0; i < 99; ++i) {
+        histogram.add(100us);
+    }
+    histogram.add(50ms);
+
+    // Estimates are only as precise as the bucket the sample fell into
+    const auto p50 = histogram.percentile(0.5);
+    QVERIFY(p50 >= 64us && p50 <= 128us);
+    const auto p99 = histogram.percentile(0.99);
+    QVERIFY(p99 >= 64us && p99 <= 128us);
+    QCOMPARE(histogram.percentile(1.0), std::chrono::nanoseconds(50ms));
+    QCOMPARE(histogram.percentile(0.0), std::chrono::nanoseconds(100us));
+    QVERIFY(histogram.mean() > 100us);
+}
+
+void TestMetrics::testEmpty()
+{
+    const Metrics::Histogram histogram = Metrics::histogram(Metrics::Stage::Hotplug);
+    QCOMPARE(histogram.count(), quint64(0));
+    QCOMPARE(histogram.percentile(0.5), std::chrono::nanoseconds(0ns));
+    QCOMPARE(histogram.mean(), std::chrono::nanoseconds(0ns));
+}
+
+void TestMetrics::testReset()
+{
+    Metrics::record(Metrics::Stage::Submission, 2ms);
+    Metrics::record(Metrics::Stage::Submission, 4ms);
+    QCOMPARE(Metrics::histogram(Metrics::Stage::Submission).count(), quint64(2));
+    QCOMPARE(Metrics::histogram(Metrics::Stage::Submission).max(), std::chrono::nanoseconds(4ms));
+    QCOMPARE(Metrics::histogram(Metrics::Stage::Acknowledgement).count(), quint64(0));
+
+    Metrics::increment(Metrics::Counter::ProtocolRequests, 3);
+    QCOMPARE(Metrics::count(Metrics::Counter::ProtocolRequests), quint64(3));
+
+    Metrics::reset();
+    QCOMPARE(Metrics::histogram(Metrics::Stage::Submission).count(), quint64(0));
+    QCOMPARE(Metrics::count(Metrics::Counter::ProtocolRequests), quint64(0));
+}
+
+void TestMetrics::testApply()
+{
+    auto op = new GetConfigOperation();
+    QVERIFY(op->exec());
+    const ConfigPtr config = op->config();
+    QVERIFY(config);
+
+    QSignalSpy monitorSpy(ConfigMonitor::instance(), &ConfigMonitor::configurationChanged);
+    ConfigMonitor::instance()->addConfig(config);
+
+    auto setop = new SetConfigOperation(config);
+    QVERIFY(setop->exec());
+    QVERIFY(monitorSpy.count() > 0 || monitorSpy.wait(500));
+
+    QCOMPARE(Metrics::histogram(Metrics::Stage::Preparation).count(), quint64(1));
+    QCOMPARE(Metrics::histogram(Metrics::Stage::Apply).count(), quint64(1));
+    QVERIFY(Metrics::histogram(Metrics::Stage::Propagation).count() >= 1);
+    QVERIFY(Metrics::histogram(Metrics::Stage::Apply).max() >= Metrics::histogram(Metrics::Stage::Preparation).max());
+
+    // The Fake backend reports every applied config, but talks to no compositor
+    QVERIFY(Metrics::count(Metrics::Counter::ConfigRebuilds) >= 1);
+    QCOMPARE(Metrics::count(Metrics::Counter::ProtocolRequests), quint64(0));
+}
+
+QTEST_GUILESS_MAIN(TestMetrics)
+
+#include "testmetrics.moc"
@@ -38,6 +38,7 @@ private Q_SLOTS:
     void cleanupTestCase();
 
     void modeListChange();
+    void applyKeepsModes();
 };
 
 ConfigPtr TestModeListChange::getConfig()
@@ -157,6 +158,34 @@ void TestModeListChange::modeListChange()
     QCOMPARE(outputChangedSpy.count(), modesChangedSpy.count());
 }
 
+void TestModeListChange::applyKeepsModes()
+{
+    OutputPtr output(new Output);
+    output->setModes(createModeList());
+    const ModeList modes = output->modes();
+
+    // Unchanged modes are neither cloned nor reported
+    OutputPtr other = output->clone();
+    other->setPos(QPoint(100, 0));
+    QSignalSpy modesChangedSpy(output.data(), &Output::modesChanged);
+    output->apply(other);
+    QCOMPARE(output->pos(), QPoint(100, 0));
+    QCOMPARE(modesChangedSpy.count(), 0);
+    for (const ModePtr &mode : modes) {
+        QCOMPARE(output->mode(mode->id()), mode);
+    }
+
+    // Only the changed mode is replaced
+    other = output->clone();
+    other->mode(QStringLiteral("22"))->setRefreshRate(75);
+    output->apply(other);
+    QCOMPARE(modesChangedSpy.count(), 1);
+    QCOMPARE(output->mode(QStringLiteral("11")), modes.value(QStringLiteral("11")));
+    QVERIFY(output->mode(QStringLiteral("22")) != modes.value(QStringLiteral("22")));
+    QVERIFY(output->mode(QStringLiteral("22")) != other->mode(QStringLiteral("22")));
+    QCOMPARE(output->mode(QStringLiteral("22"))->refreshRate(), 75.0f);
+}
+
 QTEST_MAIN(TestModeListChange)
 
 #include "testmodelistchange.moc"
@@ -0,0 +1,378 @@
+/*
+ *  SPDX-FileCopyrightText: 2026 KScreen contributors
+ *
+ *  SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include <QObject>
+#include <QPromise>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "../backends/fake/parser.h"
+#include "../backends/shared/sharedbackend.h"
+#include "../backends/shared/sharedsnapshot.h"
+#include "../src/config.h"
+#include "../src/edid.h"
+#include "../src/mode.h"
+#include "../src/output.h"
+
+using namespace KScreen;
+
+// Stands in for the backend talking to the compositor
+class CompositorBackend : public AbstractBackend
+{
+public:
+    explicit CompositorBackend(const ConfigPtr &config)
+        : m_config(config)
+    {
+    }
+
+    ConfigPtr config() const override
+    {
+        return m_config;
+    }
+
+    QFuture<SetConfigResult> setConfig(const ConfigPtr &) override
+    {
+        return QtFuture::makeReadyValueFuture(SetConfigResult());
+    }
+
+private:
+    ConfigPtr m_config;
+};
+
+class TestSharedSnapshot : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+
+    void testEncodeDecode();
+    void testCompleteState();
+    void testPublishSubscribe();
+    void testSkipsOutdatedStates();
+    void testNoPublisher();
+    void testPublisherRestart();
+    void testApply();
+    void testApplyInFlight();
+    void testSilentPublisher();
+
+private:
+    QString socketPath() const;
+    ConfigPtr config() const;
+
+    std::unique_ptr<QTemporaryDir> m_dir;
+};
+
+static const QByteArray s_edid = QByteArray::fromBase64(
+    "AP///////wAN8iw0AAAAABwVAQOAHRB4CoPVlFdSjCccUFQAAAABAQEBAQEBAQEBAQEBAQEBEhtWWlAAGTAwIDYAJaQQAAAYEhtWWlAAGTAwIDYAJaQQAAAYAAAA/gBBVU8KICAgICAgICAgAAAA/"
+    "gBCMTMzWFcwMyBWNCAKAIc=");
+
+void TestSharedSnapshot::init()
+{
+    m_dir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_dir->isValid());
+}
+
+QString TestSharedSnapshot::socketPath() const
+{
+    return m_dir->filePath(QStringLiteral("snapshot"));
+}
+
+ConfigPtr TestSharedSnapshot::config() const
+{
+    const ConfigPtr config = Parser::fromJson(QStringLiteral(TEST_DATA "multipleoutput.json"));
+    if (config) {
+        config->outputs().first()->setEdid(s_edid);
+    }
+    return config;
+}
+
+void TestSharedSnapshot::testEncodeDecode()
+{
+    const ConfigPtr original = config();
+    QVERIFY(original);
+    const QByteArray data = SharedSnapshot::encode(original);
+
+    const auto snapshot = SharedSnapshot::decode(data);
+    QVERIFY(snapshot.has_value());
+    QCOMPARE(snapshot->config->outputs().keys(), original->outputs().keys());
+    QCOMPARE(snapshot->config->outputs().first()->currentModeId(), original->outputs().first()->currentModeId());
+    QCOMPARE(snapshot->edids.count(), 1);
+    QCOMPARE(snapshot->edids.value(original->outputs().first()->id()), s_edid);
+
+    QVERIFY(!SharedSnapshot::decode(data.left(data.size() - 1)).has_value());
+    QVERIFY(!SharedSnapshot::decode(QByteArray()).has_value());
+}
+
+void TestSharedSnapshot::testCompleteState()
+{
+    const ConfigPtr original = config();
+    QVERIFY(original);
+    const OutputPtr output = original->outputs().first();
+    output->setCapabilities(Output::Capability::BrightnessControl | Output::Capability::HighDynamicRange);
+    output->setExplicitLogicalSize(QSizeF(1280.5, 800));
+    output->setCustomModes({ModeInfo{.size = QSize(1920, 1080), .refreshRate = 75, .flags = ModeInfo::Flag::Custom, .cvt = std::nullopt}});
+    output->setBrightness(0.4);
+    output->setDimming(0.8);
+    output->setAutomaticBrightness(true);
+    output->setMaxPeakBrightnessOverride(600);
+    output->setMinBrightnessOverride(0.05);
+    output->setHdrIccProfilePath(QStringLiteral("/tmp/hdr.icc"));
+    output->setColorProfileSource(Output::ColorProfileSource::EDID);
+    output->setHdrColorProfileSource(Output::ColorProfileSource::ICC);
+    output->setSdrGamutWideness(0.3);
+    output->setColorPowerPreference(Output::ColorPowerTradeoff::PreferAccuracy);
+    output->setSharpness(0.6);
+    output->setAbmLevel(2);
+
+    // Everything applying a group of properties takes over survives, not only what used to be printed
+    const auto snapshot = SharedSnapshot::decode(SharedSnapshot::encode(original));
+    QVERIFY(snapshot.has_value());
+    const OutputPtr decoded = snapshot->config->output(output->id());
+    QCOMPARE(decoded->capabilities(), output->capabilities());
+    QCOMPARE(decoded->explicitLogicalSize(), output->explicitLogicalSize());
+    QCOMPARE(decoded->customModes(), output->customModes());
+    QCOMPARE(decoded->brightness(), 0.4);
+    QCOMPARE(decoded->dimming(), 0.8);
+    QVERIFY(decoded->automaticBrightness());
+    QCOMPARE(decoded->maxPeakBrightnessOverride(), std::optional<double>(600));
+    QCOMPARE(decoded->maxAverageBrightnessOverride(), std::nullopt);
+    QCOMPARE(decoded->minBrightnessOverride(), std::optional<double>(0.05));
+    QCOMPARE(decoded->hdrIccProfilePath(), QStringLiteral("/tmp/hdr.icc"));
+    QCOMPARE(decoded->colorProfileSource(), Output::ColorProfileSource::EDID);
+    QCOMPARE(decoded->hdrColorProfileSource(), Output::ColorProfileSource::ICC);
+    QCOMPARE(decoded->sdrGamutWideness(), 0.3);
+    QCOMPARE(decoded->colorPowerPreference(), Output::ColorPowerTradeoff::PreferAccuracy);
+    QCOMPARE(decoded->sharpness(), 0.6);
+    QCOMPARE(decoded->abmLevel(), uint32_t(2));
+}
+
+void TestSharedSnapshot::testPublishSubscribe()
+{
+    SnapshotPublisher publisher(socketPath());
+    QVERIFY(publisher.isListening());
+    const ConfigPtr published = config();
+    QVERIFY(published);
+    published->setGeneration(5);
+    publisher.publish(published);
+
+    SharedBackend backend(socketPath());
+    QVERIFY(backend.isConnected());
+    // New subscribers get the current state right away
+    QTRY_VERIFY(backend.ready().isFinished());
+    QCOMPARE(publisher.subscriberCount(), 1);
+    QCOMPARE(backend.generation(), quint64(5));
+    QCOMPARE(backend.config()->outputs().count(), 2);
+    QCOMPARE(backend.edid(published->outputs().first()->id()), s_edid);
+
+    QSignalSpy spy(&backend, &AbstractBackend::configChanged);
+    published->outputs().first()->setRotation(Output::Left);
+    published->setGeneration(6);
+    publisher.publish(published);
+    QVERIFY(spy.wait());
+    QCOMPARE(backend.generation(), quint64(6));
+    QCOMPARE(backend.config()->outputs().first()->rotation(), Output::Left);
+}
+
+void TestSharedSnapshot::testSkipsOutdatedStates()
+{
+    SnapshotPublisher publisher(socketPath());
+    SharedBackend backend(socketPath());
+    QVERIFY(backend.isConnected());
+    QTRY_COMPARE(publisher.subscriberCount(), 1);
+
+    // States piling up are only deserialized once
+    QSignalSpy spy(&backend, &AbstractBackend::configChanged);
+    const ConfigPtr published = config();
+    for (int i = 0; i < 3; ++i) {
+        published->outputs().first()->setPos(QPoint(i, 0));
+        publisher.publish(published);
+    }
+    QVERIFY(spy.wait());
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(backend.config()->outputs().first()->pos(), QPoint(2, 0));
+    QCOMPARE(backend.generation(), quint64(3));
+}
+
+void TestSharedSnapshot::testNoPublisher()
+{
+    SharedBackend backend(socketPath());
+    QVERIFY(!backend.isConnected());
+    QVERIFY(!backend.ready().isFinished());
+
+    // There is only one publisher per socket
+    SnapshotPublisher publisher(socketPath());
+    QVERIFY(publisher.isListening());
+    SnapshotPublisher second(socketPath());
+    QVERIFY(!second.isListening());
+}
+
+void TestSharedSnapshot::testPublisherRestart()
+{
+    auto publisher = std::make_unique<SnapshotPublisher>(socketPath());
+    const ConfigPtr published = config();
+    published->setGeneration(10);
+    publisher->publish(published);
+
+    SharedBackend backend(socketPath());
+    QTRY_VERIFY(backend.ready().isFinished());
+    QCOMPARE(backend.generation(), quint64(10));
+
+    // The last state is kept while the publisher is gone
+    publisher.reset();
+    QTRY_VERIFY(!backend.isConnected());
+    QCOMPARE(backend.config()->outputs().count(), 2);
+
+    // A new publisher starts counting from the beginning
+    QSignalSpy spy(&backend, &AbstractBackend::configChanged);
+    publisher = std::make_unique<SnapshotPublisher>(socketPath());
+    published->setGeneration(1);
+    published->outputs().first()->setEnabled(false);
+    publisher->publish(published);
+    QVERIFY(spy.wait(5000));
+    QCOMPARE(backend.generation(), quint64(1));
+    QVERIFY(!backend.config()->outputs().first()->isEnabled());
+}
+
+void TestSharedSnapshot::testApply()
+{
+    SnapshotPublisher publisher(socketPath());
+    const ConfigPtr published = config();
+    publisher.publish(published);
+    QList<SharedSnapshot::Request> requests;
+    publisher.setApplyHandler([&requests](const SharedSnapshot::Request &request) {
+        requests.append(request);
+        return QtFuture::makeReadyValueFuture(SetConfigResult());
+    });
+
+    bool compositorUsed = false;
+    SharedBackend backend(socketPath(), [&compositorUsed, published]() {
+        compositorUsed = true;
+        return new CompositorBackend(published);
+    });
+    backend.init({});
+    QVERIFY(backend.ready().isFinished());
+    QVERIFY(!backend.hasFallenBack());
+
+    const ConfigPtr changed = backend.config()->clone();
+    const OutputPtr output = changed->outputs().first();
+    const auto mode = std::ranges::find_if(output->modes(), [&output](const ModePtr &mode) {
+        return mode->id() != output->currentModeId();
+    });
+    QVERIFY(mode != output->modes().cend());
+    output->setCurrentModeId((*mode)->id());
+    output->setPos(QPoint(4242, 0));
+
+    // Only what differs from the published state is forwarded, by the ids the publisher uses
+    QFuture<SetConfigResult> result = backend.setConfig(changed);
+    QTRY_VERIFY(result.isFinished());
+    QVERIFY(result.result().has_value());
+    QCOMPARE(requests.count(), 1);
+    QCOMPARE(requests.last().changes, (QHash<int, ConfigMonitor::OutputChanges>{{output->id(), ConfigMonitor::OutputChange::Geometry}}));
+    const OutputPtr applied = requests.last().config->output(output->id());
+    QVERIFY(applied);
+    QCOMPARE(applied->pos(), QPoint(4242, 0));
+    QCOMPARE(applied->currentModeId(), (*mode)->id());
+
+    // An unchanged config has nothing to forward
+    result = backend.setConfig(backend.config()->clone());
+    QVERIFY(result.isFinished());
+    QVERIFY(result.result().has_value());
+    QCOMPARE(requests.count(), 1);
+
+    result = backend.setPartialConfig(changed, {{output->id(), ConfigMonitor::OutputChange::Color}});
+    QTRY_VERIFY(result.isFinished());
+    QVERIFY(result.result().has_value());
+    QCOMPARE(requests.count(), 2);
+    QCOMPARE(requests.last().changes, (QHash<int, ConfigMonitor::OutputChanges>{{output->id(), ConfigMonitor::OutputChange::Color}}));
+
+    result = backend.setPartialConfig(changed, {{4242, ConfigMonitor::OutputChange::Geometry}});
+    QTRY_VERIFY(result.isFinished());
+    QVERIFY(!result.result().has_value());
+    QCOMPARE(requests.count(), 2);
+
+    result = backend.setBrightness(output->id(), 0.5, std::nullopt);
+    QTRY_VERIFY(result.isFinished());
+    QVERIFY(result.result().has_value());
+    QCOMPARE(requests.count(), 3);
+    QVERIFY(!requests.last().config);
+    QCOMPARE(requests.last().outputId, output->id());
+    QCOMPARE(requests.last().brightness, std::optional<double>(0.5));
+    QCOMPARE(requests.last().dimming, std::nullopt);
+
+    // Applying never needs a connection to the compositor of its own
+    QVERIFY(!compositorUsed);
+}
+
+void TestSharedSnapshot::testApplyInFlight()
+{
+    auto publisher = std::make_unique<SnapshotPublisher>(socketPath());
+    publisher->publish(config());
+    QList<SharedSnapshot::Request> requests;
+    std::vector<std::shared_ptr<QPromise<SetConfigResult>>> results;
+    publisher->setApplyHandler([&requests, &results](const SharedSnapshot::Request &request) {
+        requests.append(request);
+        auto result = std::make_shared<QPromise<SetConfigResult>>();
+        result->start();
+        results.push_back(result);
+        return result->future();
+    });
+
+    SharedBackend backend(socketPath());
+    backend.init({});
+    QVERIFY(backend.ready().isFinished());
+
+    const ConfigPtr original = backend.config()->clone();
+    const ConfigPtr moved = original->clone();
+    const int outputId = moved->outputs().first()->id();
+    moved->output(outputId)->setPos(QPoint(4242, 0));
+    QFuture<SetConfigResult> first = backend.setConfig(moved);
+    QTRY_COMPARE(requests.count(), 1);
+
+    // Going back to the published state undoes the request not answered yet
+    QFuture<SetConfigResult> second = backend.setConfig(original);
+    QTRY_COMPARE(requests.count(), 2);
+    QCOMPARE(requests.last().changes, (QHash<int, ConfigMonitor::OutputChanges>{{outputId, ConfigMonitor::OutputChange::Geometry}}));
+    QCOMPARE(requests.last().config->output(outputId)->pos(), original->output(outputId)->pos());
+
+    results.front()->addResult(std::unexpected(QStringLiteral("Failed")));
+    results.front()->finish();
+    QTRY_VERIFY(first.isFinished());
+    QCOMPARE(first.result().error(), QStringLiteral("Failed"));
+
+    // Requests still waiting fail when the publisher goes away
+    QVERIFY(!second.isFinished());
+    publisher.reset();
+    QTRY_VERIFY(second.isFinished());
+    QVERIFY(!second.result().has_value());
+}
+
+void TestSharedSnapshot::testSilentPublisher()
+{
+    // Accepts subscribers, but never has a state to send
+    SnapshotPublisher publisher(socketPath());
+    const ConfigPtr compositor = config();
+    SharedBackend backend(socketPath(), [compositor]() {
+        return new CompositorBackend(compositor);
+    });
+    QVERIFY(backend.isConnected());
+
+    backend.init({});
+    // Instead of waiting forever, the compositor is asked directly
+    QVERIFY(backend.hasFallenBack());
+    QVERIFY(backend.ready().isFinished());
+    QCOMPARE(backend.config(), compositor);
+}
+
+QTEST_GUILESS_MAIN(TestSharedSnapshot)
+
+#include "testsharedsnapshot.moc"
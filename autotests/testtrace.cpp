@@ -0,0 +1,114 @@
+/*
+ *  SPDX-FileCopyrightText: 2026 KScreen contributors
+ *
+ *  SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QObject>
+#include <QSet>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include "../src/backendmanager_p.h"
+#include "../src/config.h"
+#include "../src/configmonitor.h"
+#include "../src/edid.h"
+#include "../src/getconfigoperation.h"
+#include "../src/setconfigoperation.h"
+#include "../src/trace_p.h"
+
+using namespace KScreen;
+
+class TestTrace : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testSpans();
+
+private:
+    QJsonArray readEvents() const;
+
+    QTemporaryDir m_dir;
+    QString m_path;
+};
+
+void TestTrace::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+    m_path = m_dir.filePath(QStringLiteral("trace.json"));
+    // Read once, when the library records its first span
+    qputenv("KSCREEN_TRACE_FILE", m_path.toUtf8());
+
+    qputenv("KSCREEN_BACKEND", "Fake");
+    BackendManager::instance()->setBackendArgs({{QStringLiteral("TEST_DATA"), TEST_DATA "multipleoutput.json"}});
+}
+
+void TestTrace::cleanupTestCase()
+{
+    BackendManager::instance()->shutdownBackend();
+}
+
+QJsonArray TestTrace::readEvents() const
+{
+    Trace::flush();
+
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+    // The file is left open ended, close the array for QJsonDocument
+    QByteArray data = file.readAll().trimmed();
+    if (data.endsWith(',')) {
+        data.chop(1);
+    }
+    data.append(']');
+    return QJsonDocument::fromJson(data).array();
+}
+
+void TestTrace::testSpans()
+{
+    QVERIFY(Trace::isEnabled());
+
+    auto op = new GetConfigOperation();
+    QVERIFY(op->exec());
+    const ConfigPtr config = op->config();
+    QVERIFY(config);
+    ConfigMonitor::instance()->addConfig(config);
+
+    auto setop = new SetConfigOperation(config);
+    QVERIFY(setop->exec());
+
+    Edid edid(QByteArray(128, '\0'));
+    QVERIFY(!edid.isValid());
+
+    const QJsonArray events = readEvents();
+    QVERIFY(!events.isEmpty());
+
+    QSet<QString> names;
+    for (const QJsonValue &value : events) {
+        const QJsonObject event = value.toObject();
+        if (event[QLatin1String("ph")].toString() != QLatin1String("X")) {
+            continue;
+        }
+        QVERIFY(event.contains(QLatin1String("ts")));
+        QVERIFY(event[QLatin1String("dur")].toInteger() >= 0);
+        names.insert(event[QLatin1String("name")].toString());
+    }
+    QVERIFY(names.contains(QStringLiteral("GetConfigOperation")));
+    QVERIFY(names.contains(QStringLiteral("SetConfigOperation")));
+    QVERIFY(names.contains(QStringLiteral("Config::apply")));
+    QVERIFY(names.contains(QStringLiteral("ConfigMonitor propagation")));
+    QVERIFY(names.contains(QStringLiteral("Edid::parse")));
+}
+
+QTEST_GUILESS_MAIN(TestTrace)
+
+#include "testtrace.moc"
@@ -0,0 +1,99 @@
+/*
+ *  SPDX-FileCopyrightText: 2026 KScreen contributors
+ *
+ *  SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include <QCoreApplication>
+#include <QObject>
+#include <QSignalSpy>
+#include <QTest>
+
+#include "../backends/kwayland/waylandchangenotifier.h"
+#include "../src/metrics.h"
+
+using namespace KScreen;
+
+class TestWaylandChangeNotifier : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+
+    void testCoalesces();
+    void testNotify();
+    void testBlocked();
+};
+
+void TestWaylandChangeNotifier::init()
+{
+    Metrics::reset();
+}
+
+void TestWaylandChangeNotifier::testCoalesces()
+{
+    WaylandChangeNotifier notifier;
+    QSignalSpy spy(&notifier, &WaylandChangeNotifier::changed);
+
+    // As if the done events of several output devices were read in one dispatch
+    for (int i = 0; i < 5; ++i) {
+        notifier.schedule();
+    }
+    QCOMPARE(spy.count(), 0);
+    QCoreApplication::processEvents();
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(Metrics::count(Metrics::Counter::ConfigChanges), quint64(1));
+
+    // The next dispatch gets its own announcement
+    notifier.schedule();
+    notifier.schedule();
+    QCoreApplication::processEvents();
+    QCOMPARE(spy.count(), 2);
+    QCOMPARE(Metrics::count(Metrics::Counter::ConfigChanges), quint64(2));
+}
+
+void TestWaylandChangeNotifier::testNotify()
+{
+    WaylandChangeNotifier notifier;
+    QSignalSpy spy(&notifier, &WaylandChangeNotifier::changed);
+
+    // Announcing right away covers what was scheduled before
+    notifier.schedule();
+    notifier.notify();
+    QCOMPARE(spy.count(), 1);
+    QCoreApplication::processEvents();
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(Metrics::count(Metrics::Counter::ConfigChanges), quint64(1));
+}
+
+void TestWaylandChangeNotifier::testBlocked()
+{
+    WaylandChangeNotifier notifier;
+    QSignalSpy spy(&notifier, &WaylandChangeNotifier::changed);
+
+    // Changes arriving while a configuration is applied are announced with its outcome
+    notifier.block();
+    QVERIFY(notifier.isBlocked());
+    notifier.schedule();
+    notifier.schedule();
+    QCoreApplication::processEvents();
+    QCOMPARE(spy.count(), 0);
+
+    notifier.unblock();
+    notifier.notify();
+    QCoreApplication::processEvents();
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(Metrics::count(Metrics::Counter::ConfigChanges), quint64(1));
+
+    // Blocking drops an announcement already scheduled
+    notifier.schedule();
+    notifier.block();
+    QCoreApplication::processEvents();
+    QCOMPARE(spy.count(), 1);
+    notifier.unblock();
+}
+
+QTEST_GUILESS_MAIN(TestWaylandChangeNotifier)
+
+#include "testwaylandchangenotifier.moc"
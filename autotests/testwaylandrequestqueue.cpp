@@ -0,0 +1,155 @@
+/*
+ *  SPDX-FileCopyrightText: 2026 KScreen contributors
+ *
+ *  SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include <QObject>
+#include <QTest>
+
+#include "../backends/fake/parser.h"
+#include "../backends/kwayland/waylandrequestqueue.h"
+#include "../src/config.h"
+#include "../src/output.h"
+
+using namespace KScreen;
+using OutputChange = ConfigMonitor::OutputChange;
+
+class TestWaylandRequestQueue : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testMergesChangedProperties();
+    void testMasks();
+    void testRevertsInFlight();
+    void testUnknownOutputs();
+
+private:
+    static ConfigPtr config();
+};
+
+ConfigPtr TestWaylandRequestQueue::config()
+{
+    return Parser::fromJson(QStringLiteral(TEST_DATA "multipleoutput.json"));
+}
+
+void TestWaylandRequestQueue::testMergesChangedProperties()
+{
+    const ConfigPtr current = config();
+    QVERIFY(current);
+    WaylandRequestQueue queue;
+    QVERIFY(queue.isEmpty());
+
+    // The second request builds on the first one, which the compositor has not seen yet
+    const ConfigPtr scaled = current->clone();
+    scaled->output(1)->setScale(2);
+    const QFuture<SetConfigResult> first = queue.enqueue(scaled, std::nullopt, current);
+    const ConfigPtr dimmed = scaled->clone();
+    dimmed->output(1)->setBrightness(0.5);
+    const QFuture<SetConfigResult> second = queue.enqueue(dimmed, std::nullopt, current);
+    QVERIFY(!queue.isEmpty());
+
+    WaylandTransaction transaction = queue.take();
+    QVERIFY(queue.isEmpty());
+    const WaylandTransaction::Request request = transaction.merged();
+    QCOMPARE(request.config->output(1)->scale(), 2.0);
+    QCOMPARE(request.config->output(1)->brightness(), 0.5);
+    QVERIFY(request.changes);
+    QCOMPARE(request.changes->value(1), OutputChange::Geometry | OutputChange::Brightness);
+    QVERIFY(!request.changes->value(2));
+
+    // Every caller gets the outcome of the transaction
+    QVERIFY(!first.isFinished());
+    transaction.finish(std::unexpected(QStringLiteral("rejected")));
+    QVERIFY(first.isFinished() && second.isFinished());
+    QCOMPARE(first.result().error(), QStringLiteral("rejected"));
+    QCOMPARE(second.result().error(), QStringLiteral("rejected"));
+}
+
+void TestWaylandRequestQueue::testMasks()
+{
+    const ConfigPtr current = config();
+    WaylandRequestQueue queue;
+
+    const ConfigPtr first = current->clone();
+    first->output(1)->setRotation(Output::Left);
+    first->output(1)->setBrightness(0.2);
+    queue.enqueue(first, WaylandRequestQueue::OutputChangeMasks{{1, OutputChange::Geometry}}, ConfigPtr());
+
+    // Later requests win for the groups they name, the others are left alone
+    const ConfigPtr second = current->clone();
+    second->output(1)->setBrightness(0.7);
+    second->output(2)->setEnabled(false);
+    queue.enqueue(second, WaylandRequestQueue::OutputChangeMasks{{1, OutputChange::Brightness}, {2, OutputChange::Enabled}}, ConfigPtr());
+
+    const WaylandTransaction::Request request = queue.take().merged();
+    QCOMPARE(request.config->output(1)->rotation(), Output::Left);
+    QCOMPARE(request.config->output(1)->brightness(), 0.7);
+    QVERIFY(!request.config->output(2)->isEnabled());
+    QCOMPARE(request.changes->value(1), OutputChange::Geometry | OutputChange::Brightness);
+    QCOMPARE(request.changes->value(2), ConfigMonitor::OutputChanges(OutputChange::Enabled));
+}
+
+void TestWaylandRequestQueue::testRevertsInFlight()
+{
+    const ConfigPtr current = config();
+    WaylandRequestQueue queue;
+
+    const ConfigPtr scaled = current->clone();
+    scaled->output(1)->setScale(2);
+    queue.setInFlight({.config = scaled, .changes = std::nullopt});
+
+    // Asking for the state the compositor still reports undoes the request in flight
+    queue.enqueue(current->clone(), std::nullopt, current);
+    const WaylandTransaction::Request request = queue.take().merged();
+    QCOMPARE(request.changes->value(1), ConfigMonitor::OutputChanges(OutputChange::Geometry));
+    QCOMPARE(request.config->output(1)->scale(), current->output(1)->scale());
+    QVERIFY(!request.changes->value(2));
+
+    // Once it is answered, the reported state is all there is to compare against
+    queue.clearInFlight();
+    queue.enqueue(current->clone(), std::nullopt, current);
+    QVERIFY(!queue.take().merged().changes->value(1));
+}
+
+void TestWaylandRequestQueue::testUnknownOutputs()
+{
+    const ConfigPtr current = config();
+    WaylandRequestQueue queue;
+
+    const ConfigPtr gone = current->clone();
+    gone->output(2)->setScale(2);
+    const OutputPtr extra = gone->output(2)->clone();
+    extra->setId(42);
+    gone->addOutput(extra);
+    const QFuture<SetConfigResult> failing = queue.enqueue(gone, std::nullopt, current);
+    const ConfigPtr dimmed = current->clone();
+    dimmed->output(2)->setBrightness(0.5);
+    const QFuture<SetConfigResult> succeeding = queue.enqueue(dimmed, WaylandRequestQueue::OutputChangeMasks{{2, OutputChange::Brightness}}, ConfigPtr());
+
+    // Only the caller naming the unknown output fails, the other one is sent
+    WaylandTransaction transaction = queue.take();
+    const QSet<int> requested = transaction.failUnknownOutputs([](int outputId) {
+        return outputId != 42;
+    });
+    QVERIFY(failing.isFinished());
+    QVERIFY(!failing.result().has_value());
+    QVERIFY(!succeeding.isFinished());
+    QVERIFY(transaction.hasCallers());
+    QCOMPARE(requested, QSet<int>{2});
+
+    // Nothing of the failed request is sent along with the other one
+    const WaylandTransaction::Request request = transaction.merged();
+    QCOMPARE(request.config->output(2)->brightness(), 0.5);
+    QCOMPARE(request.config->output(2)->scale(), current->output(2)->scale());
+    QCOMPARE(request.changes->value(2), ConfigMonitor::OutputChanges(OutputChange::Brightness));
+
+    transaction.finish(SetConfigResult());
+    QVERIFY(succeeding.isFinished());
+    QVERIFY(succeeding.result().has_value());
+}
+
+QTEST_GUILESS_MAIN(TestWaylandRequestQueue)
+
+#include "testwaylandrequestqueue.moc"
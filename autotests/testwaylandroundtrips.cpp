@@ -0,0 +1,92 @@
+/*
+ *  SPDX-FileCopyrightText: 2026 KScreen contributors
+ *
+ *  SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include <QObject>
+#include <QSocketNotifier>
+#include <QTest>
+
+#include "../backends/kwayland/waylandroundtrips.h"
+
+#include <wayland-client.h>
+#include <wayland-server.h>
+
+#include <memory>
+
+#include <sys/socket.h>
+
+using namespace KScreen;
+
+class TestWaylandRoundtrips : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void testRoundtrips();
+    void testWithoutDisplay();
+
+private:
+    wl_display *m_server = nullptr;
+    wl_display *m_client = nullptr;
+    std::unique_ptr<QSocketNotifier> m_serverNotifier;
+    std::unique_ptr<QSocketNotifier> m_clientNotifier;
+    int m_syncs = 0;
+};
+
+void TestWaylandRoundtrips::init()
+{
+    // A compositor of our own, answering the sync requests on this thread
+    int fds[2];
+    QCOMPARE(socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds), 0);
+    m_server = wl_display_create();
+    QVERIFY(wl_client_create(m_server, fds[0]));
+    m_client = wl_display_connect_to_fd(fds[1]);
+    QVERIFY(m_client);
+
+    m_syncs = 0;
+    wl_event_loop *loop = wl_display_get_event_loop(m_server);
+    m_serverNotifier = std::make_unique<QSocketNotifier>(wl_event_loop_get_fd(loop), QSocketNotifier::Read);
+    connect(m_serverNotifier.get(), &QSocketNotifier::activated, this, [this, loop]() {
+        ++m_syncs;
+        wl_event_loop_dispatch(loop, 0);
+        wl_display_flush_clients(m_server);
+    });
+    m_clientNotifier = std::make_unique<QSocketNotifier>(wl_display_get_fd(m_client), QSocketNotifier::Read);
+    connect(m_clientNotifier.get(), &QSocketNotifier::activated, this, [this]() {
+        wl_display_dispatch(m_client);
+    });
+}
+
+void TestWaylandRoundtrips::cleanup()
+{
+    m_clientNotifier.reset();
+    m_serverNotifier.reset();
+    wl_display_disconnect(m_client);
+    wl_display_destroy(m_server);
+}
+
+void TestWaylandRoundtrips::testRoundtrips()
+{
+    WaylandRoundtrips roundtrips;
+    const QFuture<void> finished = roundtrips.start(m_client, 2);
+    // The caller gets control back right away
+    QVERIFY(!finished.isFinished());
+    QTRY_VERIFY(finished.isFinished());
+    // and the second roundtrip was only sent once the first one was answered
+    QVERIFY(m_syncs >= 2);
+}
+
+void TestWaylandRoundtrips::testWithoutDisplay()
+{
+    WaylandRoundtrips roundtrips;
+    QVERIFY(roundtrips.start(nullptr, 2).isFinished());
+}
+
+QTEST_GUILESS_MAIN(TestWaylandRoundtrips)
+
+#include "testwaylandroundtrips.moc"
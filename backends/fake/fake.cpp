@@ -41,6 +41,21 @@ void Fake::init(const QVariantMap &arguments)
     mConfigFile = arguments[QStringLiteral("TEST_DATA")].toString();
 
     qCDebug(KSCREEN_FAKE) << "Fake profile file:" << mConfigFile;
+
+    mReady.start();
+    if (qgetenv("KSCREEN_BACKEND_ASYNC") == QByteArray("1")) {
+        // Mimic a backend waiting for the system to answer
+        QTimer::singleShot(0, this, [this]() {
+            mReady.finish();
+        });
+    } else {
+        mReady.finish();
+    }
+}
+
+QFuture<void> Fake::ready() const
+{
+    return mReady.future();
 }
 
 void Fake::delayedInit()
@@ -11,6 +11,7 @@
 
 #include <QLoggingCategory>
 #include <QObject>
+#include <QPromise>
 
 class Fake : public KScreen::AbstractBackend
 {
@@ -22,6 +23,8 @@ public:
 
     void init(const QVariantMap &arguments) override;
 
+    QFuture<void> ready() const override;
+
     KScreen::ConfigPtr config() const override;
     QFuture<KScreen::SetConfigResult> setConfig(const KScreen::ConfigPtr &config) override;
     QByteArray edid(int outputId) const override;
@@ -39,5 +42,6 @@ private Q_SLOTS:
 private:
     QString mConfigFile;
     mutable KScreen::ConfigPtr mConfig;
+    QPromise<void> mReady;
 };
 Q_DECLARE_LOGGING_CATEGORY(KSCREEN_FAKE)
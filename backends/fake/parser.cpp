@@ -17,254 +17,689 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QLoggingCategory>
-#include <QMetaObject>
-#include <QMetaProperty>
+#include <QVarLengthArray>
+
+#include <algorithm>
+#include <iterator>
+#include <string_view>
 
 using namespace KScreen;
+using namespace Qt::StringLiterals;
 
-ConfigPtr Parser::fromJson(const QByteArray &data)
+static constexpr QLatin1StringView latin1(std::string_view key)
 {
-    ConfigPtr config(new Config);
+    return QLatin1StringView(key.data(), qsizetype(key.size()));
+}
 
-    const QJsonObject json = QJsonDocument::fromJson(data).object();
+// Keeps track of where in the document we currently are, so that errors can
+// point at the offending object. The keys are views into the static field
+// tables, so descending into an object does not allocate.
+class Parser::Context
+{
+public:
+    void push(std::string_view key)
+    {
+        m_path.append({key, -1});
+    }
 
-    ScreenPtr screen = Parser::screenFromJson(json[QStringLiteral("screen")].toObject().toVariantMap());
-    config->setScreen(screen);
+    void pop()
+    {
+        m_path.removeLast();
+    }
 
-    const QVariantList outputs = json[QStringLiteral("outputs")].toArray().toVariantList();
-    if (outputs.isEmpty()) {
-        return config;
+    void setIndex(qsizetype index)
+    {
+        m_path.last().index = index;
     }
 
-    OutputList outputList;
-    for (const QVariant &value : outputs) {
-        const OutputPtr output = Parser::outputFromJson(value.toMap());
-        outputList.insert(output->id(), output);
+    void fail(const QString &message)
+    {
+        // Only the first error is interesting, the rest are consequences of it
+        if (failed()) {
+            return;
+        }
+        m_error = path() + u": "_s + message;
     }
 
-    config->setOutputs(outputList);
-    return config;
-}
+    bool failed() const
+    {
+        return !m_error.isEmpty();
+    }
 
-ConfigPtr Parser::fromJson(const QString &path)
-{
-    QFile file(path);
-    if (!file.open(QIODevice::ReadOnly)) {
-        qWarning() << file.errorString();
-        qWarning() << "File: " << path;
-        return ConfigPtr();
+    QString error() const
+    {
+        return m_error;
     }
 
-    return Parser::fromJson(file.readAll());
+private:
+    QString path() const
+    {
+        if (m_path.isEmpty()) {
+            return u"<root>"_s;
+        }
+        QString path;
+        for (const Segment &segment : m_path) {
+            if (!path.isEmpty()) {
+                path += u'.';
+            }
+            path += latin1(segment.key);
+            if (segment.index >= 0) {
+                path += u"[%1]"_s.arg(segment.index);
+            }
+        }
+        return path;
+    }
+
+    struct Segment {
+        std::string_view key;
+        qsizetype index;
+    };
+    QVarLengthArray<Segment, 8> m_path;
+    QString m_error;
+};
+
+namespace
+{
+template<typename T>
+struct Field {
+    std::string_view key;
+    void (*apply)(T &target, const QJsonValue &value, Parser::Context &context);
+};
+
+// Field tables must be sorted by key, so they can be binary searched
+template<typename T, std::size_t N>
+constexpr bool isSortedByKey(const Field<T> (&table)[N])
+{
+    return std::ranges::adjacent_find(table, std::ranges::greater_equal{}, &Field<T>::key) == std::end(table);
 }
 
-ScreenPtr Parser::screenFromJson(const QVariantMap &data)
+template<typename T, std::size_t N>
+const Field<T> *findField(const Field<T> (&table)[N], const QString &key)
 {
-    ScreenPtr screen(new Screen);
-    screen->setId(data[QStringLiteral("id")].toInt());
-    screen->setMinSize(Parser::sizeFromJson(data[QStringLiteral("minSize")].toMap()));
-    screen->setMaxSize(Parser::sizeFromJson(data[QStringLiteral("maxSize")].toMap()));
-    screen->setCurrentSize(Parser::sizeFromJson(data[QStringLiteral("currentSize")].toMap()));
-    screen->setMaxActiveOutputsCount(data[QStringLiteral("maxActiveOutputsCount")].toInt());
-
-    return screen;
+    const auto it = std::lower_bound(std::begin(table), std::end(table), key, [](const Field<T> &field, const QString &key) {
+        return key.compare(latin1(field.key)) > 0;
+    });
+    if (it == std::end(table) || key != latin1(it->key)) {
+        return nullptr;
+    }
+    return it;
 }
 
-void Parser::qvariant2qobject(const QVariantMap &variant, QObject *object)
+template<typename T, std::size_t N>
+void applyFields(const Field<T> (&table)[N], T &target, const QJsonValue &value, Parser::Context &context)
 {
-    const QMetaObject *metaObject = object->metaObject();
-    for (QVariantMap::const_iterator iter = variant.begin(); iter != variant.end(); ++iter) {
-        const int propertyIndex = metaObject->indexOfProperty(qPrintable(iter.key()));
-        if (propertyIndex == -1) {
-            // qWarning() << "Skipping non-existent property" << iter.key();
-            continue;
-        }
-        const QMetaProperty metaProperty = metaObject->property(propertyIndex);
-        if (!metaProperty.isWritable()) {
-            // qWarning() << "Skipping read-only property" << iter.key();
-            continue;
-        }
+    if (!value.isObject()) {
+        context.fail(u"expected an object"_s);
+        return;
+    }
 
-        const QVariant property = object->property(iter.key().toLatin1().constData());
-        Q_ASSERT(property.isValid());
-        if (property.isValid()) {
-            QVariant value = iter.value();
-            if (value.canConvert(property.type())) {
-                value.convert(property.type());
-                object->setProperty(iter.key().toLatin1().constData(), value);
-            } else if (QLatin1String("QVariant") == QLatin1String(property.typeName())) {
-                object->setProperty(iter.key().toLatin1().constData(), value);
-            }
+    const QJsonObject object = value.toObject();
+    for (auto it = object.constBegin(); it != object.constEnd() && !context.failed(); ++it) {
+        const Field<T> *field = findField(table, it.key());
+        if (!field) {
+            context.fail(u"unknown key \"%1\""_s.arg(it.key()));
+            return;
         }
+        context.push(field->key);
+        field->apply(target, it.value(), context);
+        context.pop();
     }
 }
 
-OutputPtr Parser::outputFromJson(QMap<QString, QVariant> map)
+template<typename Function>
+void forEachElement(const QJsonValue &value, Parser::Context &context, Function &&function)
 {
-    OutputPtr output(new Output);
-    output->setId(map[QStringLiteral("id")].toInt());
+    if (!value.isArray()) {
+        context.fail(u"expected an array"_s);
+        return;
+    }
 
-    QStringList preferredModes;
-    const QVariantList prefModes = map[QStringLiteral("preferredModes")].toList();
-    for (const QVariant &mode : prefModes) {
-        preferredModes.append(mode.toString());
+    const QJsonArray array = value.toArray();
+    for (qsizetype i = 0; i < array.size() && !context.failed(); ++i) {
+        context.setIndex(i);
+        function(array.at(i));
     }
-    output->setPreferredModes(preferredModes);
-    map.remove(QStringLiteral("preferredModes"));
-
-    ModeList modelist;
-    const QVariantList modes = map[QStringLiteral("modes")].toList();
-    for (const QVariant &modeValue : modes) {
-        const ModePtr mode = Parser::modeFromJson(modeValue);
-        modelist.insert(mode->id(), mode);
+}
+
+// Ids are strings in KScreen, but the fixtures are free to use plain numbers
+QString idFromJson(const QJsonValue &value)
+{
+    if (value.isDouble()) {
+        return QString::number(value.toInteger());
     }
-    output->setModes(modelist);
-    map.remove(QStringLiteral("modes"));
+    return value.toString();
+}
 
-    if (map.contains(QStringLiteral("clones"))) {
-        QList<int> clones;
-        for (const QVariant &id : map[QStringLiteral("clones")].toList()) {
-            clones.append(id.toInt());
+Output::Type typeFromJson(const QJsonValue &value)
+{
+    // ConfigSerializer writes the enum value, hand written fixtures use connector names
+    if (value.isDouble()) {
+        const qint64 type = value.toInteger(-1);
+        if (type < Output::Unknown || type > Output::DisplayPort) {
+            qCWarning(KSCREEN_FAKE) << "Output Type not translated:" << type;
+            return Output::Unknown;
         }
-
-        output->setClones(clones);
-        map.remove(QStringLiteral("clones"));
+        return static_cast<Output::Type>(type);
     }
 
-    const QByteArray type = map[QStringLiteral("type")].toByteArray().toUpper();
-    if (type.contains("LVDS") || type.contains("EDP") || type.contains("IDP") || type.contains("7")) {
-        output->setType(Output::Panel);
+    const QByteArray type = value.toString().toLatin1().toUpper();
+    if (type.contains("LVDS") || type.contains("EDP") || type.contains("IDP") || type.contains("PANEL")) {
+        return Output::Panel;
     } else if (type.contains("VGA")) {
-        output->setType(Output::VGA);
+        return Output::VGA;
     } else if (type.contains("DVI-I")) {
-        output->setType(Output::DVII);
+        return Output::DVII;
     } else if (type.contains("DVI-A")) {
-        output->setType(Output::DVIA);
+        return Output::DVIA;
     } else if (type.contains("DVI-D")) {
-        output->setType(Output::DVID);
+        return Output::DVID;
     } else if (type.contains("DVI")) {
-        output->setType(Output::DVI);
-    } else if (type.contains("HDMI") || type.contains("6")) {
-        output->setType(Output::HDMI);
-    } else if (type.contains("Panel")) {
-        output->setType(Output::Panel);
-    } else if (type.contains("TV-Composite")) {
-        output->setType(Output::TVComposite);
-    } else if (type.contains("TV-SVideo")) {
-        output->setType(Output::TVSVideo);
-    } else if (type.contains("TV-Component")) {
-        output->setType(Output::TVComponent);
+        return Output::DVI;
+    } else if (type.contains("HDMI")) {
+        return Output::HDMI;
+    } else if (type.contains("TV-COMPOSITE")) {
+        return Output::TVComposite;
+    } else if (type.contains("TV-SVIDEO")) {
+        return Output::TVSVideo;
+    } else if (type.contains("TV-COMPONENT")) {
+        return Output::TVComponent;
     } else if (type.contains("TV-SCART")) {
-        output->setType(Output::TVSCART);
+        return Output::TVSCART;
     } else if (type.contains("TV-C4")) {
-        output->setType(Output::TVC4);
+        return Output::TVC4;
     } else if (type.contains("TV")) {
-        output->setType(Output::TV);
-    } else if (type.contains("DisplayPort") || type.contains("14")) {
-        output->setType(Output::DisplayPort);
-    } else if (type.contains("Unknown")) {
-        output->setType(Output::Unknown);
-    } else {
+        return Output::TV;
+    } else if (type.contains("DISPLAYPORT") || type.startsWith("DP")) {
+        return Output::DisplayPort;
+    } else if (!type.contains("UNKNOWN")) {
         qCWarning(KSCREEN_FAKE) << "Output Type not translated:" << type;
     }
-    map.remove(QStringLiteral("type"));
-
-    if (map.contains(QStringLiteral("pos"))) {
-        output->setPos(Parser::pointFromJson(map[QStringLiteral("pos")].toMap()));
-        map.remove(QStringLiteral("pos"));
-    }
-
-    if (map.contains(QStringLiteral("size"))) {
-        output->setSize(Parser::sizeFromJson(map[QStringLiteral("size")].toMap()));
-        map.remove(QStringLiteral("size"));
-    }
-
-    // This is not supported in real configs; only set this value in fake test
-    // configs and don't add logic to kscreen to set this data in real configs.
-    if (map.contains(QStringLiteral("sizeMM"))) {
-        output->setSizeMm(Parser::sizeFromJson(map[QStringLiteral("sizeMM")].toMap()));
-        map.remove(QStringLiteral("sizeMM"));
-    }
-
-    auto scale = QStringLiteral("scale");
-    if (map.contains(scale)) {
-        qDebug() << "Scale found:" << map[scale].toReal();
-        output->setScale(map[scale].toReal());
-        map.remove(scale);
-    }
-
-    // the deprecated "primary" property may exist for compatibility, but "priority" should override it whenever present.
-    if (map.contains(QStringLiteral("primary"))) {
-        output->setPriority(map[QStringLiteral("primary")].toBool() ? 1 : 2);
-        map.remove(QStringLiteral("primary"));
-    }
-    if (map.contains(QStringLiteral("priority"))) {
-        output->setPriority(map[QStringLiteral("priority")].toUInt());
-        map.remove(QStringLiteral("priority"));
-    }
-
-    if (map.contains(QStringLiteral("rotation"))) {
-        output->setRotation(static_cast<KScreen::Output::Rotation>(map[QStringLiteral("rotation")].toUInt()));
-        map.remove(QStringLiteral("rotation"));
-    }
-
-    // Remove some extra properties that we do not want or need special treatment
-    map.remove(QStringLiteral("edid"));
+    return Output::Unknown;
+}
 
-    Parser::qvariant2qobject(map, output.data());
-    return output;
+constexpr Field<QSize> s_sizeFields[] = {
+    {"height",
+     [](QSize &size, const QJsonValue &value, Parser::Context &) {
+         size.setHeight(value.toInt());
+     }},
+    {"width",
+     [](QSize &size, const QJsonValue &value, Parser::Context &) {
+         size.setWidth(value.toInt());
+     }},
+};
+static_assert(isSortedByKey(s_sizeFields));
+
+constexpr Field<QPoint> s_pointFields[] = {
+    {"x",
+     [](QPoint &point, const QJsonValue &value, Parser::Context &) {
+         point.setX(value.toInt());
+     }},
+    {"y",
+     [](QPoint &point, const QJsonValue &value, Parser::Context &) {
+         point.setY(value.toInt());
+     }},
+};
+static_assert(isSortedByKey(s_pointFields));
+
+QSize sizeFromJson(const QJsonValue &value, Parser::Context &context)
+{
+    QSize size;
+    applyFields(s_sizeFields, size, value, context);
+    return size;
 }
 
-ModePtr Parser::modeFromJson(const QVariant &data)
+QPoint pointFromJson(const QJsonValue &value, Parser::Context &context)
 {
-    const QVariantMap map = data.toMap();
-    ModePtr mode(new Mode);
-    Parser::qvariant2qobject(map, mode.data());
+    QPoint point;
+    applyFields(s_pointFields, point, value, context);
+    return point;
+}
 
-    mode->setSize(Parser::sizeFromJson(map[QStringLiteral("size")].toMap()));
+constexpr Field<QSizeF> s_sizeFFields[] = {
+    {"height",
+     [](QSizeF &size, const QJsonValue &value, Parser::Context &) {
+         size.setHeight(value.toDouble());
+     }},
+    {"width",
+     [](QSizeF &size, const QJsonValue &value, Parser::Context &) {
+         size.setWidth(value.toDouble());
+     }},
+};
+static_assert(isSortedByKey(s_sizeFFields));
+
+QSizeF sizeFFromJson(const QJsonValue &value, Parser::Context &context)
+{
+    QSizeF size;
+    applyFields(s_sizeFFields, size, value, context);
+    return size;
+}
 
-    return mode;
+constexpr Field<Cvt> s_cvtFields[] = {
+    {"clock",
+     [](Cvt &cvt, const QJsonValue &value, Parser::Context &) {
+         cvt.clock = value.toInteger();
+     }},
+    {"flags",
+     [](Cvt &cvt, const QJsonValue &value, Parser::Context &) {
+         cvt.flags = value.toInteger();
+     }},
+    {"hdisplay",
+     [](Cvt &cvt, const QJsonValue &value, Parser::Context &) {
+         cvt.hdisplay = value.toInt();
+     }},
+    {"hskew",
+     [](Cvt &cvt, const QJsonValue &value, Parser::Context &) {
+         cvt.hskew = value.toInt();
+     }},
+    {"hsyncEnd",
+     [](Cvt &cvt, const QJsonValue &value, Parser::Context &) {
+         cvt.hsyncEnd = value.toInt();
+     }},
+    {"hsyncStart",
+     [](Cvt &cvt, const QJsonValue &value, Parser::Context &) {
+         cvt.hsyncStart = value.toInt();
+     }},
+    {"htotal",
+     [](Cvt &cvt, const QJsonValue &value, Parser::Context &) {
+         cvt.htotal = value.toInt();
+     }},
+    {"vdisplay",
+     [](Cvt &cvt, const QJsonValue &value, Parser::Context &) {
+         cvt.vdisplay = value.toInt();
+     }},
+    {"vscan",
+     [](Cvt &cvt, const QJsonValue &value, Parser::Context &) {
+         cvt.vscan = value.toInt();
+     }},
+    {"vsyncEnd",
+     [](Cvt &cvt, const QJsonValue &value, Parser::Context &) {
+         cvt.vsyncEnd = value.toInt();
+     }},
+    {"vsyncStart",
+     [](Cvt &cvt, const QJsonValue &value, Parser::Context &) {
+         cvt.vsyncStart = value.toInt();
+     }},
+    {"vtotal",
+     [](Cvt &cvt, const QJsonValue &value, Parser::Context &) {
+         cvt.vtotal = value.toInt();
+     }},
+};
+static_assert(isSortedByKey(s_cvtFields));
+
+constexpr Field<ModeInfo> s_modeInfoFields[] = {
+    {"cvt",
+     [](ModeInfo &mode, const QJsonValue &value, Parser::Context &context) {
+         Cvt cvt = {};
+         applyFields(s_cvtFields, cvt, value, context);
+         mode.cvt = cvt;
+     }},
+    {"flags",
+     [](ModeInfo &mode, const QJsonValue &value, Parser::Context &) {
+         mode.flags = ModeInfo::Flags::fromInt(value.toInt());
+     }},
+    {"refreshRate",
+     [](ModeInfo &mode, const QJsonValue &value, Parser::Context &) {
+         mode.refreshRate = value.toDouble();
+     }},
+    {"size",
+     [](ModeInfo &mode, const QJsonValue &value, Parser::Context &context) {
+         mode.size = sizeFromJson(value, context);
+     }},
+};
+static_assert(isSortedByKey(s_modeInfoFields));
+
+constexpr Field<Screen> s_screenFields[] = {
+    {"currentSize",
+     [](Screen &screen, const QJsonValue &value, Parser::Context &context) {
+         screen.setCurrentSize(sizeFromJson(value, context));
+     }},
+    {"id",
+     [](Screen &screen, const QJsonValue &value, Parser::Context &) {
+         screen.setId(value.toInt());
+     }},
+    {"maxActiveOutputsCount",
+     [](Screen &screen, const QJsonValue &value, Parser::Context &) {
+         screen.setMaxActiveOutputsCount(value.toInt());
+     }},
+    {"maxSize",
+     [](Screen &screen, const QJsonValue &value, Parser::Context &context) {
+         screen.setMaxSize(sizeFromJson(value, context));
+     }},
+    {"minSize",
+     [](Screen &screen, const QJsonValue &value, Parser::Context &context) {
+         screen.setMinSize(sizeFromJson(value, context));
+     }},
+};
+static_assert(isSortedByKey(s_screenFields));
+
+constexpr Field<Mode> s_modeFields[] = {
+    {"id",
+     [](Mode &mode, const QJsonValue &value, Parser::Context &) {
+         mode.setId(idFromJson(value));
+     }},
+    {"name",
+     [](Mode &mode, const QJsonValue &value, Parser::Context &) {
+         mode.setName(value.toString());
+     }},
+    {"refreshRate",
+     [](Mode &mode, const QJsonValue &value, Parser::Context &) {
+         mode.setRefreshRate(value.toDouble());
+     }},
+    {"size",
+     [](Mode &mode, const QJsonValue &value, Parser::Context &context) {
+         mode.setSize(sizeFromJson(value, context));
+     }},
+};
+static_assert(isSortedByKey(s_modeFields));
+
+// Keys follow what ConfigSerializer writes, so that a config dumped with
+// `kscreen-doctor --json` can be used as a fixture directly.
+constexpr Field<Output> s_outputFields[] = {
+    {"abmLevel",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setAbmLevel(value.toInt());
+     }},
+    {"autoRotatePolicy",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setAutoRotatePolicy(static_cast<Output::AutoRotatePolicy>(value.toInt()));
+     }},
+    {"automaticBrightness",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setAutomaticBrightness(value.toBool());
+     }},
+    {"brightness",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setBrightness(value.toDouble());
+     }},
+    {"capabilities",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setCapabilities(Output::Capabilities::fromInt(value.toInt()));
+     }},
+    {"clones",
+     [](Output &output, const QJsonValue &value, Parser::Context &context) {
+         QList<int> clones;
+         forEachElement(value, context, [&clones](const QJsonValue &id) {
+             clones.append(id.toInt());
+         });
+         output.setClones(clones);
+     }},
+    {"colorPowerPreference",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setColorPowerPreference(static_cast<Output::ColorPowerTradeoff>(value.toInt()));
+     }},
+    {"colorProfileSource",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setColorProfileSource(static_cast<Output::ColorProfileSource>(value.toInt()));
+     }},
+    {"connected",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setConnected(value.toBool());
+     }},
+    {"currentModeId",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setCurrentModeId(idFromJson(value));
+     }},
+    {"customModes",
+     [](Output &output, const QJsonValue &value, Parser::Context &context) {
+         QList<ModeInfo> modes;
+         forEachElement(value, context, [&modes, &context](const QJsonValue &element) {
+             ModeInfo mode;
+             applyFields(s_modeInfoFields, mode, element, context);
+             modes.append(mode);
+         });
+         output.setCustomModes(modes);
+     }},
+    {"ddcCiAllowed",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setDdcCiAllowed(value.toBool());
+     }},
+    {"dimming",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setDimming(value.toDouble());
+     }},
+    // EDID is served separately through Fake::edid()
+    {"edid", [](Output &, const QJsonValue &, Parser::Context &) {}},
+    {"edrPolicy",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setEdrPolicy(static_cast<Output::EdrPolicy>(value.toInt()));
+     }},
+    {"enabled",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setEnabled(value.toBool());
+     }},
+    {"explicitLogicalSize",
+     [](Output &output, const QJsonValue &value, Parser::Context &context) {
+         output.setExplicitLogicalSize(sizeFFromJson(value, context));
+     }},
+    {"followPreferredMode",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setFollowPreferredMode(value.toBool());
+     }},
+    {"hdr",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setHdrEnabled(value.toBool());
+     }},
+    {"hdrColorProfileSource",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setHdrColorProfileSource(static_cast<Output::ColorProfileSource>(value.toInt()));
+     }},
+    {"hdrIccProfilePath",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setHdrIccProfilePath(value.toString());
+     }},
+    {"iccProfilePath",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setIccProfilePath(value.toString());
+     }},
+    {"icon",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setIcon(value.toString());
+     }},
+    {"id",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setId(value.toInt());
+     }},
+    {"manufacturer",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setVendor(value.toString());
+     }},
+    {"maxAverageBrightnessOverride",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setMaxAverageBrightnessOverride(value.toDouble());
+     }},
+    {"maxBpc",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setMaxBitsPerColor(value.toInt());
+     }},
+    {"maxPeakBrightnessOverride",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setMaxPeakBrightnessOverride(value.toDouble());
+     }},
+    {"minBrightnessOverride",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setMinBrightnessOverride(value.toDouble());
+     }},
+    {"model",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setModel(value.toString());
+     }},
+    {"modes",
+     [](Output &output, const QJsonValue &value, Parser::Context &context) {
+         ModeList modes;
+         forEachElement(value, context, [&modes, &context](const QJsonValue &element) {
+             ModePtr mode(new Mode);
+             applyFields(s_modeFields, *mode, element, context);
+             modes.insert(mode->id(), mode);
+         });
+         output.setModes(modes);
+     }},
+    {"name",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setName(value.toString());
+     }},
+    {"overscan",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setOverscan(value.toInt());
+     }},
+    {"pos",
+     [](Output &output, const QJsonValue &value, Parser::Context &context) {
+         output.setPos(pointFromJson(value, context));
+     }},
+    {"preferredModes",
+     [](Output &output, const QJsonValue &value, Parser::Context &context) {
+         QStringList preferredModes;
+         forEachElement(value, context, [&preferredModes](const QJsonValue &id) {
+             preferredModes.append(idFromJson(id));
+         });
+         output.setPreferredModes(preferredModes);
+     }},
+    // The deprecated "primary" property may exist for compatibility, but "priority" should
+    // override it whenever present. QJsonObject iterates its keys in sorted order, so
+    // "priority" is always applied after "primary".
+    {"primary",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setPriority(value.toBool() ? 1 : 2);
+     }},
+    {"priority",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setPriority(value.toInt());
+     }},
+    {"replicationSource",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setReplicationSource(value.toInt());
+     }},
+    {"rgbRange",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setRgbRange(static_cast<Output::RgbRange>(value.toInt()));
+     }},
+    {"rotation",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setRotation(static_cast<Output::Rotation>(value.toInt()));
+     }},
+    {"scale",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setScale(value.toDouble());
+     }},
+    {"sdr-brightness",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setSdrBrightness(value.toInt());
+     }},
+    {"sdrGamutWideness",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setSdrGamutWideness(value.toDouble());
+     }},
+    {"sharpness",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setSharpness(value.toDouble());
+     }},
+    {"size",
+     [](Output &output, const QJsonValue &value, Parser::Context &context) {
+         output.setSize(sizeFromJson(value, context));
+     }},
+    // This is not supported in real configs; only set this value in fake test
+    // configs and don't add logic to kscreen to set this data in real configs.
+    {"sizeMM",
+     [](Output &output, const QJsonValue &value, Parser::Context &context) {
+         output.setSizeMm(sizeFromJson(value, context));
+     }},
+    {"type",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setType(typeFromJson(value));
+     }},
+    {"vendor",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setVendor(value.toString());
+     }},
+    {"vrrPolicy",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setVrrPolicy(static_cast<Output::VrrPolicy>(value.toInt()));
+     }},
+    {"wcg",
+     [](Output &output, const QJsonValue &value, Parser::Context &) {
+         output.setWcgEnabled(value.toBool());
+     }},
+};
+static_assert(isSortedByKey(s_outputFields));
+
+constexpr Field<Config> s_configFields[] = {
+    {"outputs",
+     [](Config &config, const QJsonValue &value, Parser::Context &context) {
+         OutputList outputs;
+         forEachElement(value, context, [&outputs, &context](const QJsonValue &element) {
+             OutputPtr output(new Output);
+             applyFields(s_outputFields, *output, element, context);
+             outputs.insert(output->id(), output);
+         });
+         config.setOutputs(outputs);
+     }},
+    {"screen",
+     [](Config &config, const QJsonValue &value, Parser::Context &context) {
+         applyFields(s_screenFields, *config.screen(), value, context);
+     }},
+    {"tabletModeAvailable",
+     [](Config &config, const QJsonValue &value, Parser::Context &) {
+         config.setTabletModeAvailable(value.toBool());
+     }},
+    {"tabletModeEngaged",
+     [](Config &config, const QJsonValue &value, Parser::Context &) {
+         config.setTabletModeEngaged(value.toBool());
+     }},
+};
+static_assert(isSortedByKey(s_configFields));
 }
 
-QSize Parser::sizeFromJson(const QVariant &data)
+std::expected<ConfigPtr, QString> Parser::parse(const QByteArray &data)
 {
-    const QVariantMap map = data.toMap();
+    QJsonParseError error;
+    const QJsonDocument document = QJsonDocument::fromJson(data, &error);
+    if (error.error != QJsonParseError::NoError) {
+        return std::unexpected(u"offset %1: %2"_s.arg(error.offset).arg(error.errorString()));
+    }
 
-    QSize size;
-    size.setWidth(map[QStringLiteral("width")].toInt());
-    size.setHeight(map[QStringLiteral("height")].toInt());
+    ConfigPtr config(new Config);
+    config->setScreen(ScreenPtr(new Screen));
 
-    return size;
+    Context context;
+    applyFields(s_configFields, *config, QJsonValue(document.object()), context);
+    if (context.failed()) {
+        return std::unexpected(context.error());
+    }
+    return config;
 }
 
-QPoint Parser::pointFromJson(const QVariant &data)
+ConfigPtr Parser::fromJson(const QByteArray &data)
 {
-    const QVariantMap map = data.toMap();
-
-    QPoint point;
-    point.setX(map[QStringLiteral("x")].toInt());
-    point.setY(map[QStringLiteral("y")].toInt());
-
-    return point;
+    const auto config = Parser::parse(data);
+    if (!config) {
+        qCWarning(KSCREEN_FAKE) << "Invalid config:" << config.error();
+        return ConfigPtr();
+    }
+    return *config;
 }
 
-QRect Parser::rectFromJson(const QVariant &data)
+ConfigPtr Parser::fromJson(const QString &path)
 {
-    QRect rect;
-    rect.setSize(Parser::sizeFromJson(data));
-    rect.setBottomLeft(Parser::pointFromJson(data));
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << file.errorString();
+        qWarning() << "File: " << path;
+        return ConfigPtr();
+    }
 
-    return rect;
+    return Parser::fromJson(file.readAll());
 }
 
 bool Parser::validate(const QByteArray &data)
 {
-    Q_UNUSED(data);
-    return true;
+    return Parser::parse(data).has_value();
 }
 
-bool Parser::validate(const QString &data)
+bool Parser::validate(const QString &path)
 {
-    Q_UNUSED(data);
-    return true;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    return Parser::validate(file.readAll());
 }
@@ -11,24 +11,31 @@
 #include <QRect>
 #include <QSize>
 #include <QString>
-#include <QVariant>
 
+#include <expected>
+
+#include "kscreen_export.h"
 #include "types.h"
 
-class Parser
+/**
+ * Deserializes the JSON fixtures used by the Fake backend.
+ *
+ * Every object in a fixture is matched against a compile-time table of known
+ * keys; unknown keys are rejected and reported together with the JSON path
+ * of the object they were found in (e.g. "outputs[1].modes[0]").
+ *
+ * WARNING: This class is *not* part of public API, it is only exported for
+ * the unit-tests.
+ */
+class KSCREEN_EXPORT Parser
 {
 public:
+    class Context;
+
+    static std::expected<KScreen::ConfigPtr, QString> parse(const QByteArray &data);
+
     static KScreen::ConfigPtr fromJson(const QByteArray &data);
     static KScreen::ConfigPtr fromJson(const QString &path);
     static bool validate(const QByteArray &data);
     static bool validate(const QString &data);
-
-private:
-    static void qvariant2qobject(const QVariantMap &variant, QObject *object);
-    static KScreen::ScreenPtr screenFromJson(const QMap<QString, QVariant> &data);
-    static KScreen::OutputPtr outputFromJson(QMap<QString, QVariant> data /* sic */);
-    static KScreen::ModePtr modeFromJson(const QVariant &data);
-    static QSize sizeFromJson(const QVariant &data);
-    static QRect rectFromJson(const QVariant &data);
-    static QPoint pointFromJson(const QVariant &data);
 };
@@ -9,86 +9,223 @@
 #include "waylandbackend.h"
 
 #include "waylandconfig.h"
+#include "waylandeventqueue.h"
 #include "waylandoutputdevice.h"
 
 #include "kscreen_kwayland_logging.h"
 
 #include <configmonitor.h>
+#include <edid.h>
 #include <mode.h>
 #include <output.h>
+#include <screen.h>
 
+#include <QGuiApplication>
 #include <QProcess>
 #include <QSettings>
 #include <QStandardPaths>
+#include <QThread>
 
 using namespace KScreen;
 
-// This class scopes the connections to the internal config changes signals to the matching request
-// TODO it would be better if WaylandConfig::applyConfig handled the QFuture itself.
-class SetConfigJob : public QObject
+static WaylandConfig::Initialization initialization()
 {
-    Q_OBJECT
-public:
-    explicit SetConfigJob(QObject *parent = nullptr)
-        : QObject(parent)
-    {
-        m_pendingResult.start();
+    if (qgetenv("KSCREEN_BACKEND_ASYNC") == QByteArray("1")) {
+        return WaylandConfig::Initialization::Asynchronous;
     }
-    void fail(const QString &error)
-    {
-        deleteLater();
-        m_pendingResult.addResult(std::unexpected(error));
-        m_pendingResult.finish();
-    }
-    void finish()
-    {
-        deleteLater();
-        m_pendingResult.addResult(SetConfigResult());
-        m_pendingResult.finish();
+    return WaylandConfig::Initialization::Synchronous;
+}
+
+// Configs crossing to the other thread have to belong to the thread using them
+static void moveConfigToThread(const ConfigPtr &config, QThread *thread)
+{
+    config->moveToThread(thread);
+    if (const ScreenPtr screen = config->screen()) {
+        screen->moveToThread(thread);
     }
-    QFuture<SetConfigResult> future()
-    {
-        return m_pendingResult.future();
+    for (const OutputPtr &output : config->outputs()) {
+        output->moveToThread(thread);
+        if (Edid *edid = output->edid()) {
+            edid->moveToThread(thread);
+        }
+        for (const ModePtr &mode : output->modes()) {
+            mode->moveToThread(thread);
+        }
     }
-
-private:
-    QPromise<SetConfigResult> m_pendingResult;
-};
+}
 
 WaylandBackend::WaylandBackend()
     : KScreen::AbstractBackend()
-    , m_internalConfig(new WaylandConfig(this))
 {
     qCDebug(KSCREEN_WAYLAND) << "Loading Wayland backend.";
+
+    auto waylandApp = qGuiApp->nativeInterface<QNativeInterface::QWaylandApplication>();
+    if (waylandApp && qgetenv("KSCREEN_WAYLAND_THREAD") == QByteArray("1")) {
+        startThread(waylandApp->display());
+        return;
+    }
+
+    m_internalConfig = new WaylandConfig(initialization(), nullptr, this);
     connect(m_internalConfig, &WaylandConfig::configChanged, this, [this] {
         Q_EMIT configChanged(m_internalConfig->currentConfig());
     });
 }
 
+WaylandBackend::~WaylandBackend()
+{
+    if (!m_thread) {
+        return;
+    }
+
+    // The Wayland objects have to go away on the thread dispatching them, and before their queue
+    QMetaObject::invokeMethod(
+        m_eventQueue,
+        [this]() {
+            delete m_internalConfig;
+            m_eventQueue->deleteLater();
+        },
+        Qt::BlockingQueuedConnection);
+    m_thread->quit();
+    m_thread->wait();
+}
+
+void WaylandBackend::startThread(wl_display *display)
+{
+    qCDebug(KSCREEN_WAYLAND) << "Handling output management on a dedicated thread";
+
+    m_ready.start();
+
+    m_thread = new QThread(this);
+    m_thread->setObjectName(QStringLiteral("KScreenWayland"));
+    m_eventQueue = new WaylandEventQueue(display);
+    m_eventQueue->moveToThread(m_thread);
+    m_thread->start();
+
+    // From here on m_internalConfig is only touched on the backend thread
+    QMetaObject::invokeMethod(m_eventQueue, [this]() {
+        m_internalConfig = new WaylandConfig(WaylandConfig::Initialization::Synchronous, m_eventQueue);
+        connect(m_internalConfig, &WaylandConfig::configChanged, m_internalConfig, [this]() {
+            publishConfig();
+        });
+        m_eventQueue->start();
+        publishConfig();
+    });
+}
+
+void WaylandBackend::publishConfig()
+{
+    // Runs on the backend thread, the main thread gets a copy it has for itself
+    const ConfigPtr config = m_internalConfig->currentConfig()->clone();
+    moveConfigToThread(config, thread());
+    QMetaObject::invokeMethod(
+        this,
+        [this, config]() {
+            setSnapshot(config);
+        },
+        Qt::QueuedConnection);
+}
+
+void WaylandBackend::setSnapshot(const ConfigPtr &config)
+{
+    m_snapshot = config;
+    Q_EMIT configChanged(m_snapshot);
+    if (!m_ready.future().isFinished()) {
+        m_ready.finish();
+    }
+}
+
+QFuture<void> WaylandBackend::ready() const
+{
+    if (m_thread) {
+        return m_ready.future();
+    }
+    return m_internalConfig->ready();
+}
+
 ConfigPtr WaylandBackend::config() const
 {
     // Note: This should ONLY be called from GetConfigOperation!
+    if (m_thread) {
+        return m_snapshot;
+    }
     return m_internalConfig->currentConfig();
 }
 
 QFuture<SetConfigResult> WaylandBackend::setConfig(const KScreen::ConfigPtr &newconfig)
+{
+    return applyConfig(newconfig, std::nullopt);
+}
+
+QFuture<SetConfigResult> WaylandBackend::setPartialConfig(const KScreen::ConfigPtr &config, const QHash<int, ConfigMonitor::OutputChanges> &changes)
+{
+    return applyConfig(config, changes);
+}
+
+QFuture<SetConfigResult> WaylandBackend::applyConfig(const KScreen::ConfigPtr &newconfig, const std::optional<QHash<int, ConfigMonitor::OutputChanges>> &changes)
 {
     if (!newconfig) {
         return QtFuture::makeReadyFuture<SetConfigResult>(std::unexpected(QStringLiteral("config is nullptr!")));
     }
 
-    SetConfigJob *job = new SetConfigJob(this);
-    connect(m_internalConfig, &WaylandConfig::configChanged, job, &SetConfigJob::finish);
-    connect(m_internalConfig, &WaylandConfig::configFailed, job, &SetConfigJob::fail);
-    if (!m_internalConfig->applyConfig(newconfig)) {
-        // nothing changed
-        job->finish();
+    if (!m_thread) {
+        return m_internalConfig->applyConfig(newconfig, changes);
     }
-    return job->future();
+
+    auto promise = std::make_shared<QPromise<SetConfigResult>>();
+    QFuture<SetConfigResult> future = promise->future();
+    promise->start();
+
+    const ConfigPtr config = newconfig->clone();
+    moveConfigToThread(config, m_thread);
+    QMetaObject::invokeMethod(m_eventQueue, [this, config, changes, promise]() {
+        m_internalConfig->applyConfig(config, changes).then(m_internalConfig, [this, promise](const SetConfigResult &result) {
+            // Queued behind the snapshot of the applied state
+            QMetaObject::invokeMethod(
+                this,
+                [promise, result]() {
+                    promise->addResult(result);
+                    promise->finish();
+                },
+                Qt::QueuedConnection);
+        });
+    });
+    return future;
+}
+
+QFuture<SetConfigResult> WaylandBackend::setBrightness(int outputId, std::optional<double> brightness, std::optional<double> dimming)
+{
+    if (!m_thread) {
+        return m_internalConfig->applyBrightness(outputId, brightness, dimming);
+    }
+
+    auto promise = std::make_shared<QPromise<SetConfigResult>>();
+    QFuture<SetConfigResult> future = promise->future();
+    promise->start();
+
+    QMetaObject::invokeMethod(m_eventQueue, [this, outputId, brightness, dimming, promise]() {
+        m_internalConfig->applyBrightness(outputId, brightness, dimming).then(m_internalConfig, [this, promise](const SetConfigResult &result) {
+            QMetaObject::invokeMethod(
+                this,
+                [promise, result]() {
+                    promise->addResult(result);
+                    promise->finish();
+                },
+                Qt::QueuedConnection);
+        });
+    });
+    return future;
 }
 
 QByteArray WaylandBackend::edid(int outputId) const
 {
+    if (m_thread) {
+        const OutputPtr output = m_snapshot ? m_snapshot->output(outputId) : OutputPtr();
+        if (!output || !output->edid()) {
+            return QByteArray();
+        }
+        return output->edid()->rawData();
+    }
+
     WaylandOutputDevice *output = m_internalConfig->outputMap().value(outputId);
     if (!output) {
         return QByteArray();
@@ -97,4 +234,3 @@ QByteArray WaylandBackend::edid(int outputId) const
 }
 
 #include "moc_waylandbackend.cpp"
-#include "waylandbackend.moc"
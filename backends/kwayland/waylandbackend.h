@@ -10,10 +10,16 @@
 #include "abstractbackend.h"
 
 #include <QLoggingCategory>
+#include <QPromise>
+
+struct wl_display;
+
+class QThread;
 
 namespace KScreen
 {
 class WaylandConfig;
+class WaylandEventQueue;
 
 class WaylandBackend : public KScreen::AbstractBackend
 {
@@ -21,14 +27,29 @@ class WaylandBackend : public KScreen::AbstractBackend
 
 public:
     explicit WaylandBackend();
-    ~WaylandBackend() override = default;
+    ~WaylandBackend() override;
 
+    QFuture<void> ready() const override;
     KScreen::ConfigPtr config() const override;
     QFuture<SetConfigResult> setConfig(const KScreen::ConfigPtr &config) override;
+    QFuture<SetConfigResult> setPartialConfig(const KScreen::ConfigPtr &config, const QHash<int, KScreen::ConfigMonitor::OutputChanges> &changes) override;
+    QFuture<SetConfigResult> setBrightness(int outputId, std::optional<double> brightness, std::optional<double> dimming) override;
     QByteArray edid(int outputId) const override;
 
 private:
-    WaylandConfig *m_internalConfig;
+    void startThread(wl_display *display);
+    void publishConfig();
+    void setSnapshot(const KScreen::ConfigPtr &config);
+    QFuture<SetConfigResult> applyConfig(const KScreen::ConfigPtr &config, const std::optional<QHash<int, KScreen::ConfigMonitor::OutputChanges>> &changes);
+
+    WaylandConfig *m_internalConfig = nullptr;
+
+    // With KSCREEN_WAYLAND_THREAD=1 the output management runs on its own queue and thread,
+    // and the main thread only sees the snapshots published from there
+    QThread *m_thread = nullptr;
+    WaylandEventQueue *m_eventQueue = nullptr;
+    KScreen::ConfigPtr m_snapshot;
+    QPromise<void> m_ready;
 };
 
 }
@@ -0,0 +1,60 @@
+/*
+ *  SPDX-FileCopyrightText: 2026 KScreen contributors
+ *
+ *  SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+#include "waylandchangenotifier.h"
+
+#include <metrics.h>
+
+using namespace KScreen;
+
+WaylandChangeNotifier::WaylandChangeNotifier(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void WaylandChangeNotifier::schedule()
+{
+    if (m_blocked || m_scheduled) {
+        return;
+    }
+    // Wait for the rest of the events read in the same dispatch, e.g. the done of other output devices
+    m_scheduled = true;
+    QMetaObject::invokeMethod(
+        this,
+        [this]() {
+            // Dropped if the change was announced meanwhile or an apply is in progress, which announces it when done
+            if (m_scheduled && !m_blocked) {
+                notify();
+            }
+            m_scheduled = false;
+        },
+        Qt::QueuedConnection);
+}
+
+void WaylandChangeNotifier::notify()
+{
+    m_scheduled = false;
+    Metrics::increment(Metrics::Counter::ConfigChanges);
+    Q_EMIT changed();
+}
+
+void WaylandChangeNotifier::block()
+{
+    Q_ASSERT(!m_blocked);
+    m_blocked = true;
+}
+
+void WaylandChangeNotifier::unblock()
+{
+    Q_ASSERT(m_blocked);
+    m_blocked = false;
+}
+
+bool WaylandChangeNotifier::isBlocked() const
+{
+    return m_blocked;
+}
+
+#include "moc_waylandchangenotifier.cpp"
@@ -0,0 +1,59 @@
+/*
+ *  SPDX-FileCopyrightText: 2026 KScreen contributors
+ *
+ *  SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+#pragma once
+
+#include "kscreen_export.h"
+
+#include <QObject>
+
+namespace KScreen
+{
+/**
+ * Announces the changes the compositor reported, once for all of them.
+ *
+ * Changes scheduled while the events of one dispatch are handled, such as
+ * the done events of several output devices, are announced together once
+ * control returns to the event loop. Every announcement is counted as
+ * Metrics::Counter::ConfigChanges.
+ *
+ * WARNING: This class is *not* part of public API, it is only exported for
+ * the unit-tests.
+ */
+class KSCREEN_EXPORT WaylandChangeNotifier : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit WaylandChangeNotifier(QObject *parent = nullptr);
+
+    /**
+     * Announces a change once control returns to the event loop, unless it
+     * was announced or blocked meanwhile.
+     */
+    void schedule();
+
+    /**
+     * Announces the changes right away, the scheduled announcement is dropped.
+     */
+    void notify();
+
+    /**
+     * Holds back scheduled announcements, e.g. while a configuration is
+     * applied, which announces its outcome with notify() when done.
+     */
+    void block();
+    void unblock();
+    bool isBlocked() const;
+
+Q_SIGNALS:
+    void changed();
+
+private:
+    bool m_blocked = false;
+    bool m_scheduled = false;
+};
+
+}
@@ -10,49 +10,82 @@
 #include "kscreen_kwayland_logging.h"
 
 #include "waylandbackend.h"
+#include "waylandeventqueue.h"
 #include "waylandoutputdevice.h"
 #include "waylandoutputmanagement.h"
 #include "waylandscreen.h"
 
 #include "tabletmodemanager_interface.h"
 
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+#include <QElapsedTimer>
 #include <QGuiApplication>
 #include <QThread>
 #include <QTimer>
 #include <configmonitor.h>
+#include <metrics.h>
 #include <mode.h>
 #include <output.h>
+#include <outputchanges_p.h>
+#include <trace_p.h>
 
 #include <wayland-client-protocol.h>
 
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <utility>
+
 using namespace KScreen;
 
-WaylandConfig::WaylandConfig(QObject *parent)
+WaylandConfig::WaylandConfig(Initialization initialization, WaylandEventQueue *eventQueue, QObject *parent)
     : QObject(parent)
-    , m_outputManagement(std::make_unique<WaylandOutputManagement>(22))
-    , m_outputRegistry(std::make_unique<WaylandOutputDeviceRegistry>())
-    , m_blockSignals(false)
+    , m_outputManagement(std::make_unique<WaylandOutputManagement>(22, eventQueue))
+    , m_outputRegistry(std::make_unique<WaylandOutputDeviceRegistry>(eventQueue))
     , m_kscreenConfig(new Config)
-    , m_kscreenPendingConfig(nullptr)
     , m_screen(new WaylandScreen(this))
     , m_tabletModeAvailable(false)
     , m_tabletModeEngaged(false)
+    , m_eventQueue(eventQueue)
 {
     connect(m_outputManagement.get(), &WaylandOutputManagement::activeChanged, this, &WaylandConfig::handleActiveChanged);
     connect(m_outputRegistry.get(), &WaylandOutputDeviceRegistry::outputAdded, this, &WaylandConfig::addOutput);
     connect(m_outputRegistry.get(), &WaylandOutputDeviceRegistry::outputRemoved, this, &WaylandConfig::removeOutput);
+    connect(&m_changeNotifier, &WaylandChangeNotifier::changed, this, &WaylandConfig::emitConfigChanged);
+
+    m_ready.start();
+
+    if (initialization == Initialization::Asynchronous) {
+        Q_ASSERT(!m_eventQueue);
+        // Hold back changes and applies until the initial state is complete, it is announced at once
+        m_changeNotifier.block();
+        m_pendingInitializationSteps = 2;
+        requestKWinTabletMode();
+        requestOutputDevices();
+        return;
+    }
 
     initKWinTabletMode();
 
-    if (auto waylandApp = qGuiApp->nativeInterface<QNativeInterface::QWaylandApplication>()) {
+    if (m_eventQueue) {
+        m_eventQueue->roundtrip(); // list output devices
+        m_eventQueue->roundtrip(); // get output device properties
+    } else if (auto waylandApp = qGuiApp->nativeInterface<QNativeInterface::QWaylandApplication>()) {
         auto display = waylandApp->display();
         wl_display_roundtrip(display); // list output devices
         wl_display_roundtrip(display); // get output device properties
     }
+    m_ready.finish();
 }
 
-WaylandConfig::~WaylandConfig()
+WaylandConfig::~WaylandConfig() = default;
+
+QFuture<void> WaylandConfig::ready() const
 {
+    return m_ready.future();
 }
 
 void WaylandConfig::initKWinTabletMode()
@@ -68,36 +101,77 @@ void WaylandConfig::initKWinTabletMode()
     m_tabletModeAvailable = interface->tabletModeAvailable();
     m_tabletModeEngaged = interface->tabletMode();
 
-    connect(interface, &OrgKdeKWinTabletModeManagerInterface::tabletModeChanged, this, [this](bool tabletMode) {
-        if (m_tabletModeEngaged == tabletMode) {
-            return;
-        }
-        m_tabletModeEngaged = tabletMode;
-        if (!m_blockSignals) {
-            Q_EMIT configChanged();
+    connect(interface, &OrgKdeKWinTabletModeManagerInterface::tabletModeChanged, this, &WaylandConfig::setTabletModeEngaged);
+    connect(interface, &OrgKdeKWinTabletModeManagerInterface::tabletModeAvailableChanged, this, &WaylandConfig::setTabletModeAvailable);
+}
+
+void WaylandConfig::requestKWinTabletMode()
+{
+    // Creating the generated interface or reading its properties blocks on the bus, so talk to KWin directly
+    const QString service = QStringLiteral("org.kde.KWin");
+    const QString path = QStringLiteral("/org/kde/KWin");
+    const QString interface = QString::fromLatin1(OrgKdeKWinTabletModeManagerInterface::staticInterfaceName());
+
+    QDBusConnection bus = QDBusConnection::sessionBus();
+    bus.connect(service, path, interface, QStringLiteral("tabletModeChanged"), this, SLOT(setTabletModeEngaged(bool)));
+    bus.connect(service, path, interface, QStringLiteral("tabletModeAvailableChanged"), this, SLOT(setTabletModeAvailable(bool)));
+
+    QDBusMessage message = QDBusMessage::createMethodCall(service, path, QStringLiteral("org.freedesktop.DBus.Properties"), QStringLiteral("GetAll"));
+    message << interface;
+    auto watcher = new QDBusPendingCallWatcher(bus.asyncCall(message), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this](QDBusPendingCallWatcher *watcher) {
+        watcher->deleteLater();
+        const QDBusPendingReply<QVariantMap> reply = *watcher;
+        if (reply.isError()) {
+            qCDebug(KSCREEN_WAYLAND) << "Tablet mode is not available:" << reply.error().message();
+        } else {
+            const QVariantMap properties = reply.value();
+            m_tabletModeAvailable = properties.value(QStringLiteral("tabletModeAvailable")).toBool();
+            m_tabletModeEngaged = properties.value(QStringLiteral("tabletMode")).toBool();
         }
+        finishInitializationStep();
     });
-    connect(interface, &OrgKdeKWinTabletModeManagerInterface::tabletModeAvailableChanged, this, [this](bool available) {
-        if (m_tabletModeAvailable == available) {
-            return;
-        }
-        m_tabletModeAvailable = available;
-        if (!m_blockSignals) {
-            Q_EMIT configChanged();
-        }
+}
+
+void WaylandConfig::requestOutputDevices()
+{
+    auto waylandApp = qGuiApp->nativeInterface<QNativeInterface::QWaylandApplication>();
+    // The same two roundtrips the synchronous initialization does, just without waiting for them:
+    // the first one lists the output devices, the second one gets their properties
+    m_outputDeviceRoundtrips.start(waylandApp ? waylandApp->display() : nullptr, 2).then(this, [this]() {
+        finishInitializationStep();
     });
 }
 
-void WaylandConfig::blockSignals()
+void WaylandConfig::finishInitializationStep()
 {
-    Q_ASSERT(m_blockSignals == false);
-    m_blockSignals = true;
+    if (--m_pendingInitializationSteps > 0) {
+        return;
+    }
+
+    qCDebug(KSCREEN_WAYLAND) << "Initialized with" << m_outputMap.count() << "outputs";
+    m_changeNotifier.unblock();
+    m_changeNotifier.notify();
+    m_ready.finish();
+    tryPendingConfig();
+}
+
+void WaylandConfig::setTabletModeAvailable(bool available)
+{
+    if (m_tabletModeAvailable == available) {
+        return;
+    }
+    m_tabletModeAvailable = available;
+    m_changeNotifier.schedule();
 }
 
-void WaylandConfig::unblockSignals()
+void WaylandConfig::setTabletModeEngaged(bool engaged)
 {
-    Q_ASSERT(m_blockSignals == true);
-    m_blockSignals = false;
+    if (m_tabletModeEngaged == engaged) {
+        return;
+    }
+    m_tabletModeEngaged = engaged;
+    m_changeNotifier.schedule();
 }
 
 void WaylandConfig::handleActiveChanged()
@@ -110,9 +184,7 @@ void WaylandConfig::handleActiveChanged()
     m_initializingOutputs.clear();
     m_screen->setOutputs({});
 
-    if (!m_blockSignals) {
-        Q_EMIT configChanged();
-    }
+    m_changeNotifier.schedule();
 }
 
 void WaylandConfig::addOutput(WaylandOutputDevice *output)
@@ -120,15 +192,22 @@ void WaylandConfig::addOutput(WaylandOutputDevice *output)
     qCDebug(KSCREEN_WAYLAND) << "adding output" << output;
 
     m_initializingOutputs << output;
-    connect(output, &WaylandOutputDevice::done, this, [this, output]() {
+    // Outputs present at startup aren't plugged in
+    QElapsedTimer hotplug;
+    if (m_ready.future().isFinished()) {
+        hotplug.start();
+    }
+    connect(output, &WaylandOutputDevice::done, this, [this, output, hotplug]() {
         if (m_initializingOutputs.removeOne(output)) {
+            if (hotplug.isValid()) {
+                m_pendingHotplugs << hotplug;
+            }
             m_outputMap.insert(output->id(), output);
             m_screen->setOutputs(m_outputMap.values());
+            markReplicationSourcesChanged();
         }
 
-        if (!m_blockSignals) {
-            Q_EMIT configChanged();
-        }
+        m_changeNotifier.schedule();
     });
 }
 
@@ -144,14 +223,15 @@ void WaylandConfig::removeOutput(WaylandOutputDevice *output)
     Q_ASSERT(removedOutput == output);
     Q_UNUSED(removedOutput);
     m_screen->setOutputs(m_outputMap.values());
+    markReplicationSourcesChanged();
 
-    if (!m_blockSignals) {
-        Q_EMIT configChanged();
-    }
+    m_changeNotifier.schedule();
 }
 
 KScreen::ConfigPtr WaylandConfig::currentConfig()
 {
+    KScreen::Trace::Span span("WaylandConfig::currentConfig");
+
     m_kscreenConfig->setScreen(m_screen->toKScreenScreen(m_kscreenConfig));
 
     m_kscreenConfig->setValid(m_outputManagement->isActive());
@@ -167,12 +247,21 @@ KScreen::ConfigPtr WaylandConfig::currentConfig()
         }
     }
 
-    // Add KScreen::Outputs that aren't in the list yet
-    for (const auto &output : m_outputMap) {
-        if (m_kscreenConfig->outputs().contains(output->id())) {
-            output->updateKScreenOutput(m_kscreenConfig->outputs()[output->id()], m_outputMap);
-        } else {
+    // Replication sources are referenced by uuid, so a changed uuid affects every output
+    const bool uuidChanged = std::ranges::any_of(m_outputMap, [](const WaylandOutputDevice *output) {
+        return output->pendingChanges().testFlag(WaylandOutputDevice::Change::Uuid);
+    });
+    if (uuidChanged) {
+        markReplicationSourcesChanged();
+    }
+
+    // Add KScreen::Outputs that aren't in the list yet, update only the ones that changed
+    for (const auto &output : std::as_const(m_outputMap)) {
+        KScreen::OutputPtr kscreenOutput = m_kscreenConfig->output(output->id());
+        if (!kscreenOutput) {
             m_kscreenConfig->addOutput(output->toKScreenOutput(m_outputMap));
+        } else if (output->pendingChanges()) {
+            output->updateKScreenOutput(kscreenOutput, m_outputMap);
         }
     }
 
@@ -182,6 +271,27 @@ KScreen::ConfigPtr WaylandConfig::currentConfig()
     return m_kscreenConfig;
 }
 
+void WaylandConfig::emitConfigChanged()
+{
+    for (const QElapsedTimer &hotplug : std::as_const(m_pendingHotplugs)) {
+        KScreen::Metrics::record(KScreen::Metrics::Stage::Hotplug, std::chrono::nanoseconds(hotplug.nsecsElapsed()));
+    }
+    m_pendingHotplugs.clear();
+    Q_EMIT configChanged();
+}
+
+int WaylandConfig::lastRequestCount() const
+{
+    return m_lastRequestCount;
+}
+
+void WaylandConfig::markReplicationSourcesChanged()
+{
+    for (WaylandOutputDevice *output : std::as_const(m_outputMap)) {
+        output->markChanged(WaylandOutputDevice::Change::ReplicationSource);
+    }
+}
+
 QMap<int, WaylandOutputDevice *> WaylandConfig::outputMap() const
 {
     return m_outputMap;
@@ -189,66 +299,197 @@ QMap<int, WaylandOutputDevice *> WaylandConfig::outputMap() const
 
 void WaylandConfig::tryPendingConfig()
 {
-    if (!m_kscreenPendingConfig) {
+    if (m_pendingRequests.isEmpty()) {
         return;
     }
-    applyConfig(m_kscreenPendingConfig);
-    m_kscreenPendingConfig = nullptr;
+    sendConfig(m_pendingRequests.take());
 }
 
-bool WaylandConfig::applyConfig(const KScreen::ConfigPtr &newConfig)
+QFuture<SetConfigResult> WaylandConfig::applyConfig(const KScreen::ConfigPtr &newConfig, const std::optional<OutputChangeMasks> &changes)
 {
-    for (const auto &output : newConfig->outputs()) {
-        if (!m_outputMap.contains(output->id())) {
-            qCWarning(KSCREEN_WAYLAND) << "Cannot find output with id" << output->id();
-            return false;
+    if (m_changeNotifier.isBlocked()) {
+        // Last apply still pending, remember new changes and apply afterwards
+        return m_pendingRequests.enqueue(newConfig, changes, changes ? KScreen::ConfigPtr() : currentConfig());
+    }
+
+    WaylandTransaction transaction;
+    QFuture<SetConfigResult> future = transaction.addRequest({.config = newConfig, .changes = changes});
+    sendConfig(std::move(transaction));
+    return future;
+}
+
+QFuture<SetConfigResult> WaylandConfig::applyBrightness(int outputId, std::optional<double> brightness, std::optional<double> dimming)
+{
+    WaylandOutputDevice *device = m_outputMap.value(outputId);
+    if (!device) {
+        qCWarning(KSCREEN_WAYLAND) << "Cannot find output with id" << outputId;
+        return QtFuture::makeReadyValueFuture<SetConfigResult>(std::unexpected(QStringLiteral("Cannot find output with id %1").arg(outputId)));
+    }
+    auto wlConfig = m_outputManagement->createConfiguration();
+    if (!wlConfig) {
+        return QtFuture::makeReadyValueFuture<SetConfigResult>(std::unexpected(QStringLiteral("Output management is not available")));
+    }
+
+    const WaylandConfigurationRequests &supported = m_outputManagement->supportedRequests();
+    int requests = 0;
+    if (brightness && supported.brightness) {
+        wlConfig->set_brightness(device->object(), std::round(*brightness * 10'000));
+        ++requests;
+    }
+    if (dimming && supported.dimming) {
+        wlConfig->set_dimming(device->object(), std::round(*dimming * 10'000));
+        ++requests;
+    }
+    KScreen::Metrics::increment(KScreen::Metrics::Counter::ProtocolRequests, requests);
+    if (requests == 0) {
+        delete wlConfig;
+        return QtFuture::makeReadyValueFuture(SetConfigResult());
+    }
+
+    auto promise = std::make_shared<QPromise<SetConfigResult>>();
+    QFuture<SetConfigResult> future = promise->future();
+    promise->start();
+    // The new values arrive as output device events like any other change
+    connect(wlConfig, &WaylandOutputConfiguration::applied, this, [wlConfig, promise]() {
+        wlConfig->deleteLater();
+        promise->addResult(SetConfigResult());
+        promise->finish();
+    });
+    connect(wlConfig, &WaylandOutputConfiguration::failed, this, [wlConfig, promise](const QString &errorMessage) {
+        wlConfig->deleteLater();
+        promise->addResult(SetConfigResult(std::unexpected(errorMessage)));
+        promise->finish();
+    });
+    wlConfig->apply();
+    return future;
+}
+
+void WaylandConfig::completePriorities(const KScreen::ConfigPtr &config, const OutputChangeMasks &changes) const
+{
+    using OutputChange = KScreen::ConfigMonitor::OutputChange;
+
+    // A partial request only carries the outputs it names, the rest keeps the state of its device.
+    // Priorities are only consistent as a whole though, so every output takes part with its own.
+    for (auto it = m_outputMap.cbegin(); it != m_outputMap.cend(); ++it) {
+        const WaylandOutputDevice *device = it.value();
+        KScreen::OutputPtr output = config->output(it.key());
+        if (!output) {
+            output = KScreen::OutputPtr(new KScreen::Output);
+            output->setId(it.key());
+            output->setName(device->name());
+            config->addOutput(output);
+        }
+        const KScreen::ConfigMonitor::OutputChanges outputChanges = changes.value(it.key());
+        if (!outputChanges.testFlag(OutputChange::Enabled)) {
+            output->setEnabled(device->enabled());
+        }
+        if (!outputChanges.testFlag(OutputChange::Priority)) {
+            output->setPriority(device->priority());
         }
     }
+}
 
-    newConfig->adjustPriorities(); // never trust input
-    if (m_blockSignals) {
-        // Last apply still pending, remember new changes and apply afterwards
-        m_kscreenPendingConfig = newConfig;
-        return true;
+void WaylandConfig::sendConfig(WaylandTransaction &&transaction)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // Only the callers naming an output that is gone fail, the others are sent
+    const QSet<int> requestedOutputs = transaction.failUnknownOutputs([this](int outputId) {
+        return m_outputMap.contains(outputId);
+    });
+    if (!transaction.hasCallers()) {
+        return;
+    }
+    const WaylandTransaction::Request request = transaction.merged();
+    const KScreen::ConfigPtr config = request.config;
+    const std::optional<OutputChangeMasks> changes = request.changes;
+
+    if (changes) {
+        completePriorities(config, *changes);
     }
+    config->adjustPriorities(); // never trust input
 
     // Create a new configuration object
     auto wlConfig = m_outputManagement->createConfiguration();
     if (!wlConfig) {
-        return false;
+        transaction.finish(std::unexpected(QStringLiteral("Output management is not available")));
+        return;
+    }
+    using OutputChange = KScreen::ConfigMonitor::OutputChange;
+    const auto outputChanges = [&changes, &requestedOutputs](int outputId) {
+        if (!requestedOutputs.contains(outputId)) {
+            return KScreen::ConfigMonitor::OutputChanges();
+        }
+        return changes ? changes->value(outputId) : KScreen::ConfigMonitor::OutputChanges(OutputChange::All);
+    };
+
+    // Priorities only make sense as a whole, once one of them changes the compositor gets all of them
+    KScreen::OutputList outputs;
+    for (const KScreen::OutputPtr &output : config->outputs()) {
+        if (m_outputMap.contains(output->id())) {
+            outputs.insert(output->id(), output);
+        }
     }
-    bool changed = false;
+    const bool prioritiesChanged = std::ranges::any_of(outputs, [this, &outputChanges](const KScreen::OutputPtr &output) {
+        return outputChanges(output->id()).testFlag(OutputChange::Priority) && output->priority() != m_outputMap[output->id()]->priority();
+    });
 
-    for (const auto &output : newConfig->outputs()) {
-        changed |= m_outputMap[output->id()]->setWlConfig(m_outputManagement.get(), wlConfig, output, m_outputMap);
+    int requests = 0;
+    for (const auto &output : std::as_const(outputs)) {
+        KScreen::ConfigMonitor::OutputChanges outputChange = outputChanges(output->id());
+        if (prioritiesChanged) {
+            outputChange |= OutputChange::Priority;
+        }
+        // Outputs nobody asked to change are not even compared
+        if (outputChange.toInt()) {
+            requests += m_outputMap[output->id()]->setWlConfig(m_outputManagement.get(), wlConfig, output, m_outputMap, prioritiesChanged, outputChange);
+        }
     }
+    m_lastRequestCount = requests;
+    KScreen::Metrics::increment(KScreen::Metrics::Counter::ProtocolRequests, requests);
+    qCDebug(KSCREEN_WAYLAND) << "Sending" << requests << "requests for" << outputs.count() << "outputs";
 
-    if (!changed) {
+    if (requests == 0) {
         delete wlConfig;
-        return false;
+        transaction.finish(SetConfigResult());
+        return;
     }
 
+    // Every request merged into this configuration gets its outcome
+    auto callers = std::make_shared<WaylandTransaction>(std::move(transaction));
+
+    KScreen::Metrics::record(KScreen::Metrics::Stage::Submission, std::chrono::nanoseconds(timer.nsecsElapsed()));
+    QElapsedTimer acknowledgement;
+    acknowledgement.start();
+
     // We now block changes in order to compress events while the compositor is doing its thing
     // once it's done or failed, we'll trigger configChanged() only once, and not per individual
     // property change.
-    connect(wlConfig, &WaylandOutputConfiguration::applied, this, [this, wlConfig] {
+    connect(wlConfig, &WaylandOutputConfiguration::applied, this, [this, wlConfig, callers, acknowledgement] {
+        KScreen::Metrics::record(KScreen::Metrics::Stage::Acknowledgement, std::chrono::nanoseconds(acknowledgement.nsecsElapsed()));
         wlConfig->deleteLater();
-        unblockSignals();
-        Q_EMIT configChanged();
+        m_changeNotifier.unblock();
+        m_changeNotifier.notify();
+        callers->finish(SetConfigResult());
+        m_pendingRequests.clearInFlight();
         tryPendingConfig();
     });
-    connect(wlConfig, &WaylandOutputConfiguration::failed, this, [this, wlConfig](const QString &errorMessage) {
+    connect(wlConfig, &WaylandOutputConfiguration::failed, this, [this, wlConfig, callers, acknowledgement](const QString &errorMessage) {
+        KScreen::Metrics::record(KScreen::Metrics::Stage::Acknowledgement, std::chrono::nanoseconds(acknowledgement.nsecsElapsed()));
         wlConfig->deleteLater();
-        unblockSignals();
+        m_changeNotifier.unblock();
         Q_EMIT configFailed(errorMessage);
-        Q_EMIT configChanged();
+        m_changeNotifier.notify();
+        callers->finish(std::unexpected(errorMessage));
+        m_pendingRequests.clearInFlight();
         tryPendingConfig();
     });
 
     // Now block signals and ask the compositor to apply the changes.
-    blockSignals();
+    m_changeNotifier.block();
+    m_pendingRequests.setInFlight(request);
     wlConfig->apply();
-    return true;
 }
 
 #include "moc_waylandconfig.cpp"
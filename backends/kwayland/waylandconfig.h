@@ -7,16 +7,26 @@
 
 #include "abstractbackend.h"
 #include "config.h"
+#include "waylandchangenotifier.h"
+#include "waylandrequestqueue.h"
+#include "waylandroundtrips.h"
 
 #include <QDir>
+#include <QElapsedTimer>
+#include <QFuture>
 #include <QLoggingCategory>
+#include <QPromise>
 #include <QScreen>
 #include <QSize>
 #include <QSocketNotifier>
 
+#include <optional>
+#include <vector>
+
 namespace KScreen
 {
 class Output;
+class WaylandEventQueue;
 class WaylandOutputDevice;
 class WaylandScreen;
 class WaylandOutputDeviceRegistry;
@@ -27,30 +37,90 @@ class WaylandConfig : public QObject
     Q_OBJECT
 
 public:
-    explicit WaylandConfig(QObject *parent = nullptr);
+    enum class Initialization {
+        Synchronous, ///< the constructor blocks until the initial state is known
+        Asynchronous, ///< the initial state is requested, ready() finishes once it arrived
+    };
+    using OutputChangeMasks = QHash<int, KScreen::ConfigMonitor::OutputChanges>;
+
+    /**
+     * With an @p eventQueue, all output management objects deliver their events
+     * through it, on the thread dispatching it. Only synchronous initialization
+     * is supported then; the thread constructing the config is the one blocking.
+     */
+    explicit WaylandConfig(Initialization initialization = Initialization::Synchronous,
+                           WaylandEventQueue *eventQueue = nullptr,
+                           QObject *parent = nullptr);
     ~WaylandConfig();
 
+    /**
+     * Finishes once the output devices and the tablet mode state are known.
+     */
+    QFuture<void> ready() const;
+
     KScreen::ConfigPtr currentConfig();
     QMap<int, WaylandOutputDevice *> outputMap() const;
 
-    bool applyConfig(const KScreen::ConfigPtr &newConfig);
+    /**
+     * Sends @p newConfig to the compositor.
+     *
+     * Only one configuration is in flight at a time. Requests made meanwhile
+     * are merged, the latest request winning for each property, and sent
+     * together once the compositor answered. Of a queued whole config, only
+     * the groups of properties that differ from the current state are merged,
+     * so it does not revert requests queued before it. The returned future
+     * resolves with the outcome of the transaction that carried the request's
+     * changes, or fails right away if the request names an unknown output.
+     *
+     * With @p changes, only the listed properties of the listed outputs are
+     * compared and sent, see AbstractBackend::setPartialConfig().
+     */
+    QFuture<SetConfigResult> applyConfig(const KScreen::ConfigPtr &newConfig, const std::optional<OutputChangeMasks> &changes = std::nullopt);
+
+    /**
+     * Sends only the brightness and dimming of one output to the compositor.
+     *
+     * Unlike applyConfig() this does not wait for a configuration in flight,
+     * nor hold back change notifications until it is applied.
+     */
+    QFuture<SetConfigResult> applyBrightness(int outputId, std::optional<double> brightness, std::optional<double> dimming);
+
+    /**
+     * Number of requests the last configuration sent to the compositor
+     * consisted of, not counting the final apply.
+     */
+    int lastRequestCount() const;
 
 Q_SIGNALS:
+    /**
+     * Emitted once for all changes the compositor reported in one dispatch,
+     * such as the done events of several output devices, see
+     * WaylandChangeNotifier.
+     */
     void configChanged();
     void globalRemoved(uint32_t name);
     void configFailed(const QString &reason);
 
+private Q_SLOTS:
+    void setTabletModeAvailable(bool available);
+    void setTabletModeEngaged(bool engaged);
+
 private:
     void handleActiveChanged();
 
     void initKWinTabletMode();
+    void requestKWinTabletMode();
+    void requestOutputDevices();
+    void finishInitializationStep();
 
     void addOutput(WaylandOutputDevice *output);
     void removeOutput(WaylandOutputDevice *output);
 
-    void blockSignals();
-    void unblockSignals();
+    void sendConfig(WaylandTransaction &&transaction);
+    void completePriorities(const KScreen::ConfigPtr &config, const OutputChangeMasks &changes) const;
     void tryPendingConfig();
+    void markReplicationSourcesChanged();
+    void emitConfigChanged();
 
     std::unique_ptr<WaylandOutputManagement> m_outputManagement;
     std::unique_ptr<WaylandOutputDeviceRegistry> m_outputRegistry;
@@ -62,13 +132,26 @@ private:
     QList<WaylandOutputDevice *> m_initializingOutputs;
     int m_lastOutputId = -1;
 
-    bool m_blockSignals;
+    // Blocked while initializing or applying a configuration
+    WaylandChangeNotifier m_changeNotifier;
     KScreen::ConfigPtr m_kscreenConfig;
-    KScreen::ConfigPtr m_kscreenPendingConfig;
+    // Requests made while a configuration is in flight, merged into one
+    WaylandRequestQueue m_pendingRequests;
     WaylandScreen *m_screen;
 
     bool m_tabletModeAvailable;
     bool m_tabletModeEngaged;
+
+    WaylandEventQueue *m_eventQueue;
+
+    // Outputs plugged in since the last configChanged(), timed from their announcement
+    QList<QElapsedTimer> m_pendingHotplugs;
+    int m_lastRequestCount = 0;
+
+    QPromise<void> m_ready;
+    // Asynchronous initialization: pending D-Bus reply and display roundtrips
+    int m_pendingInitializationSteps = 0;
+    WaylandRoundtrips m_outputDeviceRoundtrips;
 };
 
 }
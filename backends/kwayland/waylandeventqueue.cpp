@@ -0,0 +1,94 @@
+/*
+ *  SPDX-FileCopyrightText: 2026 KScreen contributors
+ *
+ *  SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+#include "waylandeventqueue.h"
+
+#include "kscreen_kwayland_logging.h"
+
+#include <QAbstractEventDispatcher>
+#include <QSocketNotifier>
+#include <QThread>
+
+#include <wayland-client-core.h>
+
+using namespace KScreen;
+
+WaylandEventQueue::WaylandEventQueue(wl_display *display)
+    : QObject()
+    , m_display(display)
+    , m_queue(wl_display_create_queue(display))
+{
+}
+
+WaylandEventQueue::~WaylandEventQueue()
+{
+    if (m_reading) {
+        wl_display_cancel_read(m_display);
+    }
+    wl_event_queue_destroy(m_queue);
+}
+
+wl_display *WaylandEventQueue::display() const
+{
+    return m_display;
+}
+
+wl_registry *WaylandEventQueue::wrap(wl_registry *registry) const
+{
+    auto wrapper = static_cast<wl_proxy *>(wl_proxy_create_wrapper(registry));
+    wl_proxy_set_queue(wrapper, m_queue);
+    return reinterpret_cast<wl_registry *>(wrapper);
+}
+
+void WaylandEventQueue::roundtrip()
+{
+    // Reading from within the roundtrip while holding a prepared read would wait for ourselves
+    if (m_reading) {
+        wl_display_cancel_read(m_display);
+        m_reading = false;
+    }
+    if (wl_display_roundtrip_queue(m_display, m_queue) < 0) {
+        qCWarning(KSCREEN_WAYLAND) << "Roundtrip on the output management queue failed";
+    }
+}
+
+void WaylandEventQueue::start()
+{
+    Q_ASSERT(thread() == QThread::currentThread());
+
+    m_notifier = new QSocketNotifier(wl_display_get_fd(m_display), QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &WaylandEventQueue::readEvents);
+    connect(QAbstractEventDispatcher::instance(thread()), &QAbstractEventDispatcher::aboutToBlock, this, &WaylandEventQueue::prepareRead);
+
+    wl_display_dispatch_queue_pending(m_display, m_queue);
+}
+
+void WaylandEventQueue::prepareRead()
+{
+    if (!m_reading) {
+        // Fails as long as other threads already queued events for us, dispatch those first
+        while (wl_display_prepare_read_queue(m_display, m_queue) != 0) {
+            wl_display_dispatch_queue_pending(m_display, m_queue);
+        }
+        m_reading = true;
+    }
+
+    // The main thread's event loop doesn't flush the requests sent from this one
+    wl_display_flush(m_display);
+}
+
+void WaylandEventQueue::readEvents()
+{
+    if (m_reading) {
+        m_reading = false;
+        if (wl_display_read_events(m_display) < 0) {
+            qCWarning(KSCREEN_WAYLAND) << "Reading events for the output management queue failed";
+            return;
+        }
+    }
+    wl_display_dispatch_queue_pending(m_display, m_queue);
+}
+
+#include "moc_waylandeventqueue.cpp"
@@ -0,0 +1,65 @@
+/*
+ *  SPDX-FileCopyrightText: 2026 KScreen contributors
+ *
+ *  SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+#pragma once
+
+#include <QObject>
+
+struct wl_display;
+struct wl_event_queue;
+struct wl_registry;
+
+class QSocketNotifier;
+
+namespace KScreen
+{
+/**
+ * A Wayland event queue dispatched by the thread this object lives in,
+ * instead of the application's main thread.
+ *
+ * Proxies bound through a registry wrapped by this queue deliver their
+ * events, and those of every object created through them, on that thread.
+ */
+class WaylandEventQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit WaylandEventQueue(wl_display *display);
+    ~WaylandEventQueue() override;
+
+    wl_display *display() const;
+
+    /**
+     * Returns a wrapper of @p registry whose binds create their proxies on
+     * this queue right away, so none of their events can end up on the queue
+     * of @p registry.
+     *
+     * The wrapper must be released with wl_proxy_wrapper_destroy().
+     */
+    wl_registry *wrap(wl_registry *registry) const;
+
+    /**
+     * Blocks until the compositor handled all requests sent so far and
+     * dispatches the events of this queue meanwhile.
+     */
+    void roundtrip();
+
+    /**
+     * Starts dispatching from the event loop of the owning thread.
+     */
+    void start();
+
+private:
+    void prepareRead();
+    void readEvents();
+
+    wl_display *m_display;
+    wl_event_queue *m_queue;
+    QSocketNotifier *m_notifier = nullptr;
+    bool m_reading = false;
+};
+
+}
@@ -5,6 +5,7 @@
  *  SPDX-License-Identifier: LGPL-2.1-or-later
  */
 #include "waylandoutputdevice.h"
+#include "waylandeventqueue.h"
 #include "waylandoutputmanagement.h"
 
 #include "kscreen_kwayland_logging.h"
@@ -16,14 +17,16 @@
 #include <mode.h>
 #include <output.h>
 
+#include <wayland-client-core.h>
 #include <wayland-server-protocol.h>
 
 #include <utility>
 
 using namespace KScreen;
 
-WaylandOutputDeviceRegistry::WaylandOutputDeviceRegistry()
+WaylandOutputDeviceRegistry::WaylandOutputDeviceRegistry(WaylandEventQueue *eventQueue)
     : QWaylandClientExtensionTemplate<WaylandOutputDeviceRegistry>(24)
+    , m_eventQueue(eventQueue)
 {
     initialize();
 }
@@ -39,6 +42,17 @@ WaylandOutputDeviceRegistry::~WaylandOutputDeviceRegistry()
     }
 }
 
+void WaylandOutputDeviceRegistry::bind(struct ::wl_registry *registry, int id, int version)
+{
+    if (!m_eventQueue) {
+        QWaylandClientExtensionTemplate::bind(registry, id, version);
+        return;
+    }
+    wl_registry *wrapper = m_eventQueue->wrap(registry);
+    QWaylandClientExtensionTemplate::bind(wrapper, id, version);
+    wl_proxy_wrapper_destroy(wrapper);
+}
+
 void WaylandOutputDeviceRegistry::kde_output_device_registry_v2_output(struct ::kde_output_device_v2 *output)
 {
     auto outputDevice = m_outputDevices.emplace_back(std::make_unique<WaylandOutputDevice>(output)).get();
@@ -86,6 +100,7 @@ void WaylandOutputDevice::kde_output_device_v2_geometry(int32_t x,
                                                         const QString &model,
                                                         int32_t transform)
 {
+    m_changes |= Change::Geometry | Change::Identity;
     m_pos = QPoint(x, y);
     m_physicalSize = QSize(physical_width, physical_height);
     m_subpixel = subpixel;
@@ -96,19 +111,24 @@ void WaylandOutputDevice::kde_output_device_v2_geometry(int32_t x,
 
 void WaylandOutputDevice::kde_output_device_v2_current_mode(struct ::kde_output_device_mode_v2 *mode)
 {
+    m_changes |= Change::CurrentMode;
     m_mode = WaylandOutputDeviceMode::get(mode);
 }
 
 void WaylandOutputDevice::kde_output_device_v2_mode(struct ::kde_output_device_mode_v2 *mode)
 {
+    m_changes |= Change::Modes | Change::CurrentMode;
     WaylandOutputDeviceMode *m = new WaylandOutputDeviceMode(mode);
     // last mode sent is the current one
     m_mode = m;
     m_modes.append(m);
 
     connect(m, &WaylandOutputDeviceMode::removed, this, [this, m]() {
+        m_changes |= Change::Modes;
         m_modes.removeOne(m);
+        m_kscreenModes.remove(m->id());
         if (m_mode == m) {
+            m_changes |= Change::CurrentMode;
             if (!m_modes.isEmpty()) {
                 m_mode = m_modes.first();
             } else {
@@ -125,6 +145,7 @@ OutputPtr WaylandOutputDevice::toKScreenOutput(const QMap<int, WaylandOutputDevi
 {
     OutputPtr output(new Output());
     output->setId(m_id);
+    m_changes = Change::All;
     updateKScreenOutput(output, outputMap);
     return output;
 }
@@ -179,116 +200,168 @@ wl_output_transform toKWaylandTransform(const Output::Rotation rotation)
 
 void KScreen::WaylandOutputDevice::updateKScreenModes(OutputPtr &output)
 {
-    ModeList modeList;
     QStringList preferredModeIds;
-    QString currentModeId;
 
     for (const WaylandOutputDeviceMode *wlMode : std::as_const(m_modes)) {
-        ModePtr mode(new Mode());
-
-        mode->setId(wlMode->id());
-        mode->setRefreshRate(wlMode->refreshRate());
-        mode->setSize(wlMode->size());
-        mode->setName(modeName(wlMode));
-
-        if (const auto cvt = wlMode->cvt()) {
-            mode->setCvt(*cvt);
-        }
+        // The properties of a mode are sent right after it was announced and never change,
+        // so a KScreen::Mode only has to be created the first time the mode is seen
+        if (!m_kscreenModes.contains(wlMode->id())) {
+            ModePtr mode(new Mode());
+
+            mode->setId(wlMode->id());
+            mode->setRefreshRate(wlMode->refreshRate());
+            mode->setSize(wlMode->size());
+            mode->setName(modeName(wlMode));
+
+            if (const auto cvt = wlMode->cvt()) {
+                mode->setCvt(*cvt);
+            }
 
-        if (m_mode == wlMode) {
-            currentModeId = wlMode->id();
+            m_kscreenModes.insert(wlMode->id(), mode);
         }
 
         if (wlMode->preferred()) {
             preferredModeIds << wlMode->id();
         }
-
-        // Add to the modelist which gets set on the output
-        modeList[wlMode->id()] = mode;
     }
-    output->setCurrentModeId(currentModeId);
     output->setPreferredModes(preferredModeIds);
-    output->setModes(modeList);
+    output->setModes(m_kscreenModes);
 }
 
 void WaylandOutputDevice::updateKScreenOutput(OutputPtr &output, const QMap<int, WaylandOutputDevice *> &outputMap)
 {
+    const Changes changes = std::exchange(m_changes, Changes());
+    if (!changes) {
+        return;
+    }
+
     output->setId(m_id);
-    output->setEnabled(enabled());
     output->setConnected(true);
-    output->setName(name());
-    output->setVendor(m_manufacturer);
-    output->setModel(m_model);
-    output->setSizeMm(m_physicalSize);
-    output->setPos(m_pos);
-    output->setRotation(toKScreenRotation(m_transform));
-    if (!output->edid()) {
-        output->setEdid(m_edid);
-    }
-
-    QSize currentSize = m_mode->size();
-    output->setSize(output->isHorizontal() ? currentSize : currentSize.transposed());
-    output->setScale(m_factor);
-    output->setType(Utils::guessOutputType(m_outputName, m_outputName));
-    output->setCapabilities(static_cast<Output::Capabilities>(static_cast<uint32_t>(m_capabilities)));
-    output->setOverscan(m_overscan);
-    output->setVrrPolicy(static_cast<Output::VrrPolicy>(m_vrr_policy));
-    output->setRgbRange(static_cast<Output::RgbRange>(m_rgbRange));
-    output->setHdrEnabled(m_hdrEnabled);
-    output->setSdrBrightness(m_sdrBrightness);
-    output->setWcgEnabled(m_wideColorGamutEnabled);
-    output->setAutoRotatePolicy(static_cast<Output::AutoRotatePolicy>(m_autoRotatePolicy));
-    output->setIccProfilePath(m_iccProfilePath);
-    output->setSdrGamutWideness(m_sdrGamutWideness);
-    output->setMaxPeakBrightness(m_maxPeakBrightness);
-    output->setMaxAverageBrightness(m_maxAverageBrightness);
-    output->setMinBrightness(m_minBrightness);
-    output->setMaxPeakBrightnessOverride(m_maxPeakBrightnessOverride);
-    output->setMaxAverageBrightnessOverride(m_maxAverageBrightnessOverride);
-    output->setMinBrightnessOverride(m_minBrightnessOverride);
-    output->setColorProfileSource(static_cast<Output::ColorProfileSource>(m_colorProfileSource));
-    output->setBrightness(m_brightness / 10'000.0);
-    output->setColorPowerPreference(static_cast<Output::ColorPowerTradeoff>(m_colorPowerPreference));
-    output->setDimming(m_dimming / 10'000.0);
-    output->setUuid(m_uuid);
-    int replicationSourceId = 0;
-    for (auto it = outputMap.begin(); it != outputMap.end(); it++) {
-        if (it.value()->uuid() == m_replicationSource) {
-            replicationSourceId = it.key();
-            break;
+    if (changes.testFlag(Change::Enabled)) {
+        output->setEnabled(enabled());
+    }
+    if (changes.testFlag(Change::Identity)) {
+        output->setName(name());
+        output->setVendor(m_manufacturer);
+        output->setModel(m_model);
+        output->setType(Utils::guessOutputType(m_outputName, m_outputName));
+        if (!output->edid()) {
+            output->setEdid(m_edid);
         }
     }
-    output->setReplicationSource(replicationSourceId);
-    output->setDdcCiAllowed(m_ddcCiAllowed);
-    output->setMaxBitsPerColor(m_maxBpc);
-    output->setAutomaticMaxBitsPerColorLimit(m_autoMaxBpcLimit);
-    output->setBitsPerColorRange(Output::BpcRange{
-        .min = bpcRange.min,
-        .max = bpcRange.max,
-    });
-    output->setEdrPolicy(static_cast<Output::EdrPolicy>(m_edrPolicy));
-    output->setSharpness(m_sharpness / 10'000.0);
-    output->setAutomaticBrightness(m_autoBrightness);
-    output->setHdrIccProfilePath(m_hdrIccProfilePath);
-    output->setHdrColorProfileSource(Output::ColorProfileSource(m_hdrColorProfileSource));
-    output->setAbmLevel(m_abmLevel);
-
-    updateKScreenModes(output);
-
-    m_customModes.clear();
-    for (const auto &mode : m_modes) {
-        if (!(mode->flags() & ModeInfo::Flag::Custom)) {
-            continue;
+    if (changes.testFlag(Change::Uuid)) {
+        output->setUuid(m_uuid);
+    }
+    if (changes.testFlag(Change::Geometry)) {
+        output->setSizeMm(m_physicalSize);
+        output->setPos(m_pos);
+        output->setRotation(toKScreenRotation(m_transform));
+    }
+    if (changes.testFlag(Change::Modes)) {
+        updateKScreenModes(output);
+
+        m_customModes.clear();
+        for (const auto &mode : m_modes) {
+            if (!(mode->flags() & ModeInfo::Flag::Custom)) {
+                continue;
+            }
+            m_customModes.push_back(ModeInfo{
+                .size = mode->size(),
+                .refreshRate = mode->refreshRate(),
+                .flags = mode->flags(),
+                .cvt = mode->cvt(),
+            });
+        }
+        output->setCustomModes(m_customModes);
+    }
+    if (changes.testAnyFlags(Change::Modes | Change::CurrentMode)) {
+        output->setCurrentModeId(m_mode->id());
+    }
+    if (changes.testAnyFlags(Change::Modes | Change::CurrentMode | Change::Geometry)) {
+        QSize currentSize = m_mode->size();
+        output->setSize(output->isHorizontal() ? currentSize : currentSize.transposed());
+    }
+    if (changes.testFlag(Change::Scale)) {
+        output->setScale(m_factor);
+    }
+    if (changes.testFlag(Change::Capabilities)) {
+        output->setCapabilities(static_cast<Output::Capabilities>(static_cast<uint32_t>(m_capabilities)));
+    }
+    if (changes.testFlag(Change::Overscan)) {
+        output->setOverscan(m_overscan);
+    }
+    if (changes.testFlag(Change::Vrr)) {
+        output->setVrrPolicy(static_cast<Output::VrrPolicy>(m_vrr_policy));
+    }
+    if (changes.testFlag(Change::RgbRange)) {
+        output->setRgbRange(static_cast<Output::RgbRange>(m_rgbRange));
+    }
+    if (changes.testFlag(Change::Hdr)) {
+        output->setHdrEnabled(m_hdrEnabled);
+        output->setSdrBrightness(m_sdrBrightness);
+        output->setSdrGamutWideness(m_sdrGamutWideness);
+        output->setHdrIccProfilePath(m_hdrIccProfilePath);
+        output->setHdrColorProfileSource(Output::ColorProfileSource(m_hdrColorProfileSource));
+    }
+    if (changes.testFlag(Change::Wcg)) {
+        output->setWcgEnabled(m_wideColorGamutEnabled);
+    }
+    if (changes.testFlag(Change::AutoRotate)) {
+        output->setAutoRotatePolicy(static_cast<Output::AutoRotatePolicy>(m_autoRotatePolicy));
+    }
+    if (changes.testFlag(Change::ColorProfile)) {
+        output->setIccProfilePath(m_iccProfilePath);
+        output->setColorProfileSource(static_cast<Output::ColorProfileSource>(m_colorProfileSource));
+        output->setColorPowerPreference(static_cast<Output::ColorPowerTradeoff>(m_colorPowerPreference));
+    }
+    if (changes.testFlag(Change::BrightnessMetadata)) {
+        output->setMaxPeakBrightness(m_maxPeakBrightness);
+        output->setMaxAverageBrightness(m_maxAverageBrightness);
+        output->setMinBrightness(m_minBrightness);
+        output->setMaxPeakBrightnessOverride(m_maxPeakBrightnessOverride);
+        output->setMaxAverageBrightnessOverride(m_maxAverageBrightnessOverride);
+        output->setMinBrightnessOverride(m_minBrightnessOverride);
+    }
+    if (changes.testFlag(Change::Brightness)) {
+        output->setBrightness(m_brightness / 10'000.0);
+        output->setDimming(m_dimming / 10'000.0);
+        output->setAutomaticBrightness(m_autoBrightness);
+    }
+    if (changes.testFlag(Change::ReplicationSource)) {
+        int replicationSourceId = 0;
+        if (!m_replicationSource.isEmpty()) {
+            for (auto it = outputMap.begin(); it != outputMap.end(); it++) {
+                if (it.value()->uuid() == m_replicationSource) {
+                    replicationSourceId = it.key();
+                    break;
+                }
+            }
         }
-        m_customModes.push_back(ModeInfo{
-            .size = mode->size(),
-            .refreshRate = mode->refreshRate(),
-            .flags = mode->flags(),
-            .cvt = mode->cvt(),
+        output->setReplicationSource(replicationSourceId);
+    }
+    if (changes.testFlag(Change::DdcCi)) {
+        output->setDdcCiAllowed(m_ddcCiAllowed);
+    }
+    if (changes.testFlag(Change::BitsPerColor)) {
+        output->setMaxBitsPerColor(m_maxBpc);
+        output->setAutomaticMaxBitsPerColorLimit(m_autoMaxBpcLimit);
+        output->setBitsPerColorRange(Output::BpcRange{
+            .min = bpcRange.min,
+            .max = bpcRange.max,
         });
     }
-    output->setCustomModes(m_customModes);
-    output->setPriority(m_priority);
+    if (changes.testFlag(Change::EdrPolicy)) {
+        output->setEdrPolicy(static_cast<Output::EdrPolicy>(m_edrPolicy));
+    }
+    if (changes.testFlag(Change::Sharpness)) {
+        output->setSharpness(m_sharpness / 10'000.0);
+    }
+    if (changes.testFlag(Change::AbmLevel)) {
+        output->setAbmLevel(m_abmLevel);
+    }
+    if (changes.testFlag(Change::Priority)) {
+        output->setPriority(m_priority);
+    }
 }
 
 QString WaylandOutputDevice::modeId() const
@@ -306,164 +379,161 @@ WaylandOutputDeviceMode *WaylandOutputDevice::deviceModeFromId(const QString &id
     return nullptr;
 }
 
-bool WaylandOutputDevice::setWlConfig(WaylandOutputManagement *management,
-                                      WaylandOutputConfiguration *wlConfig,
-                                      const KScreen::OutputPtr &output,
-                                      const QMap<int, WaylandOutputDevice *> &outputMap)
+int WaylandOutputDevice::setWlConfig(WaylandOutputManagement *management,
+                                     WaylandOutputConfiguration *wlConfig,
+                                     const KScreen::OutputPtr &output,
+                                     const QMap<int, WaylandOutputDevice *> &outputMap,
+                                     bool sendPriority,
+                                     ConfigMonitor::OutputChanges changes)
 {
-    bool changed = false;
+    using OutputChange = ConfigMonitor::OutputChange;
+    const WaylandConfigurationRequests &supported = management->supportedRequests();
+    int requests = 0;
 
     // enabled?
-    if (enabled() != output->isEnabled()) {
-        changed = true;
+    if (changes.testFlag(OutputChange::Enabled) && enabled() != output->isEnabled()) {
         wlConfig->enable(object(), output->isEnabled());
+        ++requests;
     }
 
     // position
-    if (globalPosition() != output->pos()) {
-        changed = true;
+    if (changes.testFlag(OutputChange::Geometry) && globalPosition() != output->pos()) {
         wlConfig->position(object(), output->pos().x(), output->pos().y());
+        ++requests;
     }
 
     // scale
-    if (!qFuzzyCompare(scale(), output->scale())) {
-        changed = true;
+    if (changes.testFlag(OutputChange::Geometry) && !qFuzzyCompare(scale(), output->scale())) {
         wlConfig->scale(object(), wl_fixed_from_double(output->scale()));
+        ++requests;
     }
 
     // rotation
-    if (toKScreenRotation(m_transform) != output->rotation()) {
-        changed = true;
+    if (changes.testFlag(OutputChange::Geometry) && toKScreenRotation(m_transform) != output->rotation()) {
         wlConfig->transform(object(), toKWaylandTransform(output->rotation()));
+        ++requests;
     }
 
     // mode
     const ModePtr mode = output->currentMode();
-    if (mode->id() != modeId()) {
-        changed = true;
+    if (changes.testFlag(OutputChange::Geometry) && mode->id() != modeId()) {
         wlConfig->mode(object(), deviceModeFromId(mode->id())->object());
+        ++requests;
     }
 
     // overscan
-    if ((output->capabilities() & Output::Capability::Overscan) && overscan() != output->overscan()) {
+    if (changes.testFlag(OutputChange::Other) && (output->capabilities() & Output::Capability::Overscan) && overscan() != output->overscan()) {
         wlConfig->overscan(object(), output->overscan());
-        changed = true;
+        ++requests;
     }
 
     // vrr
-    if ((output->capabilities() & Output::Capability::Vrr) && vrrPolicy() != static_cast<uint32_t>(output->vrrPolicy())) {
+    if (changes.testFlag(OutputChange::Other) && (output->capabilities() & Output::Capability::Vrr) && vrrPolicy() != static_cast<uint32_t>(output->vrrPolicy())) {
         wlConfig->set_vrr_policy(object(), static_cast<uint32_t>(output->vrrPolicy()));
-        changed = true;
+        ++requests;
     }
 
-    if ((output->capabilities() & Output::Capability::RgbRange) && rgbRange() != static_cast<uint32_t>(output->rgbRange())) {
+    if (changes.testFlag(OutputChange::Color) && (output->capabilities() & Output::Capability::RgbRange) && rgbRange() != static_cast<uint32_t>(output->rgbRange())) {
         wlConfig->set_rgb_range(object(), static_cast<uint32_t>(output->rgbRange()));
-        changed = true;
-    }
-    if (output->priority() != m_priority) {
-        changed = true;
+        ++requests;
     }
-    // always send all outputs
-    if (kde_output_configuration_v2_get_version(wlConfig->object()) >= KDE_OUTPUT_CONFIGURATION_V2_SET_PRIORITY_SINCE_VERSION) {
+    if (changes.testFlag(OutputChange::Priority) && supported.priority && (sendPriority || output->priority() != m_priority)) {
         wlConfig->set_priority(object(), output->priority());
+        ++requests;
     }
-    if ((output->capabilities() & Output::Capability::HighDynamicRange) && (m_hdrEnabled == 1) != output->isHdrEnabled()) {
+    if (changes.testFlag(OutputChange::Color) && (output->capabilities() & Output::Capability::HighDynamicRange) && (m_hdrEnabled == 1) != output->isHdrEnabled()) {
         wlConfig->set_high_dynamic_range(object(), output->isHdrEnabled());
-        changed = true;
+        ++requests;
     }
-    if ((output->capabilities() & Output::Capability::HighDynamicRange) && m_sdrBrightness != output->sdrBrightness()) {
+    if (changes.testFlag(OutputChange::Brightness) && (output->capabilities() & Output::Capability::HighDynamicRange) && m_sdrBrightness != output->sdrBrightness()) {
         wlConfig->set_sdr_brightness(object(), output->sdrBrightness());
-        changed = true;
+        ++requests;
     }
-    if ((output->capabilities() & Output::Capability::WideColorGamut) && (m_wideColorGamutEnabled == 1) != output->isWcgEnabled()) {
+    if (changes.testFlag(OutputChange::Color) && (output->capabilities() & Output::Capability::WideColorGamut) && (m_wideColorGamutEnabled == 1) != output->isWcgEnabled()) {
         wlConfig->set_wide_color_gamut(object(), output->isWcgEnabled());
-        changed = true;
+        ++requests;
     }
-    if ((output->capabilities() & Output::Capability::AutoRotation) && m_autoRotatePolicy != static_cast<uint32_t>(output->autoRotatePolicy())) {
+    if (changes.testFlag(OutputChange::Other) && (output->capabilities() & Output::Capability::AutoRotation) && m_autoRotatePolicy != static_cast<uint32_t>(output->autoRotatePolicy())) {
         wlConfig->set_auto_rotate_policy(object(), static_cast<uint32_t>(output->autoRotatePolicy()));
-        changed = true;
+        ++requests;
     }
-    if ((output->capabilities() & Output::Capability::IccProfile) && m_iccProfilePath != output->iccProfilePath()) {
+    if (changes.testFlag(OutputChange::Color) && (output->capabilities() & Output::Capability::IccProfile) && m_iccProfilePath != output->iccProfilePath()) {
         wlConfig->set_icc_profile_path(object(), output->iccProfilePath());
-        changed = true;
+        ++requests;
     }
-    const auto version = kde_output_configuration_v2_get_version(wlConfig->object());
-    if (version >= KDE_OUTPUT_CONFIGURATION_V2_SET_SDR_GAMUT_WIDENESS_SINCE_VERSION && m_sdrGamutWideness != output->sdrGamutWideness()) {
+    if (changes.testFlag(OutputChange::Color) && supported.sdrGamutWideness && m_sdrGamutWideness != output->sdrGamutWideness()) {
         wlConfig->set_sdr_gamut_wideness(object(), std::clamp<uint32_t>(std::round(output->sdrGamutWideness() * 10'000), 0, 10'000));
-        changed = true;
+        ++requests;
     }
-    if (version >= KDE_OUTPUT_CONFIGURATION_V2_SET_BRIGHTNESS_OVERRIDES_SINCE_VERSION
+    if (changes.testFlag(OutputChange::Brightness) && supported.brightnessOverrides
         && (m_maxPeakBrightnessOverride != output->maxPeakBrightnessOverride() || m_maxAverageBrightnessOverride != output->maxAverageBrightnessOverride()
             || m_minBrightnessOverride != output->minBrightnessOverride())) {
         wlConfig->set_brightness_overrides(object(),
                                            output->maxPeakBrightnessOverride().value_or(-1),
                                            output->maxAverageBrightnessOverride().value_or(-1),
                                            std::round(output->minBrightnessOverride().value_or(-0.000'1) * 10'000.0));
-        changed = true;
+        ++requests;
     }
-    if (version >= KDE_OUTPUT_CONFIGURATION_V2_SET_COLOR_PROFILE_SOURCE_SINCE_VERSION
-        && static_cast<Output::ColorProfileSource>(m_colorProfileSource) != output->colorProfileSource()) {
+    if (changes.testFlag(OutputChange::Color) && supported.colorProfileSource && static_cast<Output::ColorProfileSource>(m_colorProfileSource) != output->colorProfileSource()) {
         wlConfig->set_color_profile_source(object(), static_cast<uint32_t>(output->colorProfileSource()));
-        changed = true;
+        ++requests;
     }
-    if (version >= KDE_OUTPUT_CONFIGURATION_V2_SET_BRIGHTNESS_SINCE_VERSION && m_brightness != uint32_t(std::round(output->brightness() * 10'000))) {
+    if (changes.testFlag(OutputChange::Brightness) && supported.brightness && m_brightness != uint32_t(std::round(output->brightness() * 10'000))) {
         wlConfig->set_brightness(object(), std::round(output->brightness() * 10'000));
-        changed = true;
+        ++requests;
     }
-    if (version >= KDE_OUTPUT_CONFIGURATION_V2_SET_COLOR_POWER_TRADEOFF_SINCE_VERSION
-        && m_colorPowerPreference != static_cast<color_power_tradeoff>(output->colorPowerPreference())) {
+    if (changes.testFlag(OutputChange::Color) && supported.colorPowerTradeoff && m_colorPowerPreference != static_cast<color_power_tradeoff>(output->colorPowerPreference())) {
         wlConfig->set_color_power_tradeoff(object(), static_cast<color_power_tradeoff>(output->colorPowerPreference()));
-        changed = true;
+        ++requests;
     }
-    if (version >= KDE_OUTPUT_CONFIGURATION_V2_SET_DIMMING_SINCE_VERSION && m_dimming != uint32_t(std::round(output->dimming() * 10'000))) {
+    if (changes.testFlag(OutputChange::Brightness) && supported.dimming && m_dimming != uint32_t(std::round(output->dimming() * 10'000))) {
         wlConfig->set_dimming(object(), std::round(output->dimming() * 10'000));
-        changed = true;
-    }
-    if (version >= KDE_OUTPUT_CONFIGURATION_V2_SET_REPLICATION_SOURCE_SINCE_VERSION) {
-        const auto source = outputMap[output->replicationSource()];
-        if (source) {
-            wlConfig->set_replication_source(object(), source->uuid());
-        } else {
-            wlConfig->set_replication_source(object(), QString());
+        ++requests;
+    }
+    if (changes.testFlag(OutputChange::Replication) && supported.replicationSource) {
+        const WaylandOutputDevice *source = outputMap.value(output->replicationSource());
+        const QString sourceUuid = source ? source->uuid() : QString();
+        if (sourceUuid != m_replicationSource) {
+            wlConfig->set_replication_source(object(), sourceUuid);
+            ++requests;
         }
-        changed = true;
     }
-    if (version >= KDE_OUTPUT_CONFIGURATION_V2_SET_DDC_CI_ALLOWED_SINCE_VERSION && m_ddcCiAllowed != output->ddcCiAllowed()) {
+    if (changes.testFlag(OutputChange::Other) && supported.ddcCiAllowed && m_ddcCiAllowed != output->ddcCiAllowed()) {
         wlConfig->set_ddc_ci_allowed(object(), output->ddcCiAllowed() ? 1 : 0);
+        ++requests;
     }
-    if (version >= KDE_OUTPUT_CONFIGURATION_V2_SET_MAX_BITS_PER_COLOR_SINCE_VERSION && m_maxBpc != output->maxBitsPerColor()) {
+    if (changes.testFlag(OutputChange::Color) && supported.maxBitsPerColor && m_maxBpc != output->maxBitsPerColor()) {
         wlConfig->set_max_bits_per_color(object(), output->maxBitsPerColor());
-        changed = true;
+        ++requests;
     }
-    if (version >= KDE_OUTPUT_CONFIGURATION_V2_SET_EDR_POLICY_SINCE_VERSION && m_edrPolicy != uint32_t(output->edrPolicy())) {
+    if (changes.testFlag(OutputChange::Color) && supported.edrPolicy && m_edrPolicy != uint32_t(output->edrPolicy())) {
         wlConfig->set_edr_policy(object(), uint32_t(output->edrPolicy()));
-        changed = true;
+        ++requests;
     }
-    if (version >= KDE_OUTPUT_CONFIGURATION_V2_SET_SHARPNESS_SINCE_VERSION && m_sharpness != uint32_t(std::round(output->sharpness() * 10'000))) {
+    if (changes.testFlag(OutputChange::Other) && supported.sharpness && m_sharpness != uint32_t(std::round(output->sharpness() * 10'000))) {
         wlConfig->set_sharpness(object(), std::round(output->sharpness() * 10'000));
-        changed = true;
+        ++requests;
     }
-    if (version >= KDE_OUTPUT_CONFIGURATION_V2_SET_CUSTOM_MODES_SINCE_VERSION && m_customModes != output->customModes()) {
+    if (changes.testFlag(OutputChange::Modes) && supported.customModes && m_customModes != output->customModes()) {
         auto list = management->create_mode_list();
+        const bool cvtSupported = kde_mode_list_v2_get_version(list) >= KDE_MODE_LIST_V2_ADD_CVT_SINCE_VERSION;
         const auto modes = output->customModes();
         for (const auto &mode : modes) {
-            if (const auto &cvt = mode.cvt) {
-                if (kde_mode_list_v2_get_version(list) >= KDE_MODE_LIST_V2_ADD_CVT_SINCE_VERSION) {
-                    kde_mode_list_v2_add_cvt(list,
-                                             cvt->clock,
-                                             cvt->hdisplay,
-                                             cvt->hsyncStart,
-                                             cvt->hsyncEnd,
-                                             cvt->htotal,
-                                             cvt->hskew,
-                                             cvt->vdisplay,
-                                             cvt->vsyncStart,
-                                             cvt->vsyncEnd,
-                                             cvt->vtotal,
-                                             cvt->vscan,
-                                             cvt->flags);
-                    continue;
-                }
+            if (const auto &cvt = mode.cvt; cvt && cvtSupported) {
+                kde_mode_list_v2_add_cvt(list,
+                                         cvt->clock,
+                                         cvt->hdisplay,
+                                         cvt->hsyncStart,
+                                         cvt->hsyncEnd,
+                                         cvt->htotal,
+                                         cvt->hskew,
+                                         cvt->vdisplay,
+                                         cvt->vsyncStart,
+                                         cvt->vsyncEnd,
+                                         cvt->vtotal,
+                                         cvt->vscan,
+                                         cvt->flags);
+                continue;
             }
 
             kde_mode_list_v2_set_resolution(list, mode.size.width(), mode.size.height());
@@ -473,26 +543,26 @@ bool WaylandOutputDevice::setWlConfig(WaylandOutputManagement *management,
         }
         wlConfig->set_custom_modes(object(), list);
         kde_mode_list_v2_destroy(list);
-        changed = true;
+        ++requests;
     }
-    if (version >= KDE_OUTPUT_CONFIGURATION_V2_SET_AUTO_BRIGHTNESS_SINCE_VERSION && m_autoBrightness != output->automaticBrightness()) {
+    if (changes.testFlag(OutputChange::Brightness) && supported.autoBrightness && m_autoBrightness != output->automaticBrightness()) {
         wlConfig->set_auto_brightness(object(), output->automaticBrightness() ? 1 : 0);
-        changed = true;
+        ++requests;
     }
-    if (version >= KDE_OUTPUT_CONFIGURATION_V2_SET_HDR_ICC_PROFILE_PATH_SINCE_VERSION && m_hdrIccProfilePath != output->hdrIccProfilePath()) {
+    if (changes.testFlag(OutputChange::Color) && supported.hdrIccProfilePath && m_hdrIccProfilePath != output->hdrIccProfilePath()) {
         wlConfig->set_hdr_icc_profile_path(object(), output->hdrIccProfilePath());
-        changed = true;
+        ++requests;
     }
-    if (version >= KDE_OUTPUT_CONFIGURATION_V2_SET_HDR_COLOR_PROFILE_SOURCE_SINCE_VERSION
-        && m_hdrColorProfileSource != uint32_t(output->hdrColorProfileSource())) {
+    if (changes.testFlag(OutputChange::Color) && supported.hdrColorProfileSource && m_hdrColorProfileSource != uint32_t(output->hdrColorProfileSource())) {
         wlConfig->set_hdr_color_profile_source(object(), uint32_t(output->hdrColorProfileSource()));
+        ++requests;
     }
-    if (version >= KDE_OUTPUT_CONFIGURATION_V2_SET_ABM_LEVEL_SINCE_VERSION && m_abmLevel != output->abmLevel()) {
+    if (changes.testFlag(OutputChange::Other) && supported.abmLevel && m_abmLevel != output->abmLevel()) {
         wlConfig->set_abm_level(object(), output->abmLevel());
-        changed = true;
+        ++requests;
     }
 
-    return changed;
+    return requests;
 }
 
 QString WaylandOutputDevice::modeName(const WaylandOutputDeviceMode *m) const
@@ -519,6 +589,7 @@ void WaylandOutputDevice::kde_output_device_v2_done()
 
 void WaylandOutputDevice::kde_output_device_v2_scale(wl_fixed_t factor)
 {
+    m_changes |= Change::Scale;
     const double factorAsDouble = wl_fixed_to_double(factor);
 
     // the fractional scaling protocol only speaks in unit of 120ths
@@ -529,56 +600,67 @@ void WaylandOutputDevice::kde_output_device_v2_scale(wl_fixed_t factor)
 
 void WaylandOutputDevice::kde_output_device_v2_edid(const QString &edid)
 {
+    m_changes |= Change::Identity;
     m_edid = QByteArray::fromBase64(edid.toUtf8());
 }
 
 void WaylandOutputDevice::kde_output_device_v2_enabled(int32_t enabled)
 {
+    m_changes |= Change::Enabled;
     m_enabled = enabled;
 }
 
 void WaylandOutputDevice::kde_output_device_v2_uuid(const QString &uuid)
 {
+    m_changes |= Change::Uuid;
     m_uuid = uuid;
 }
 
 void WaylandOutputDevice::kde_output_device_v2_serial_number(const QString &serialNumber)
 {
+    m_changes |= Change::Identity;
     m_serialNumber = serialNumber;
 }
 
 void WaylandOutputDevice::kde_output_device_v2_eisa_id(const QString &eisaId)
 {
+    m_changes |= Change::Identity;
     m_eisaId = eisaId;
 }
 
 void WaylandOutputDevice::kde_output_device_v2_capabilities(uint32_t flags)
 {
+    m_changes |= Change::Capabilities;
     m_capabilities = flags;
 }
 
 void WaylandOutputDevice::kde_output_device_v2_overscan(uint32_t overscan)
 {
+    m_changes |= Change::Overscan;
     m_overscan = overscan;
 }
 
 void WaylandOutputDevice::kde_output_device_v2_vrr_policy(uint32_t vrr_policy)
 {
+    m_changes |= Change::Vrr;
     m_vrr_policy = vrr_policy;
 }
 
 void WaylandOutputDevice::kde_output_device_v2_rgb_range(uint32_t rgb_range)
 {
+    m_changes |= Change::RgbRange;
     m_rgbRange = rgb_range;
 }
 
 void WaylandOutputDevice::kde_output_device_v2_name(const QString &outputName)
 {
+    m_changes |= Change::Identity;
     m_outputName = outputName;
 }
 
 void WaylandOutputDevice::kde_output_device_v2_high_dynamic_range(uint32_t hdr_enabled)
 {
+    m_changes |= Change::Hdr | Change::Capabilities;
     m_hdrEnabled = hdr_enabled == 1;
     if (version() < KDE_OUTPUT_DEVICE_V2_CAPABILITY_BRIGHTNESS_SINCE_VERSION) {
         // make the capabilities API be consistent with older versions even if the protocol isn't
@@ -592,26 +674,31 @@ void WaylandOutputDevice::kde_output_device_v2_high_dynamic_range(uint32_t hdr_e
 
 void WaylandOutputDevice::kde_output_device_v2_sdr_brightness(uint32_t sdr_brightness)
 {
+    m_changes |= Change::Hdr;
     m_sdrBrightness = sdr_brightness;
 }
 
 void WaylandOutputDevice::kde_output_device_v2_wide_color_gamut(uint32_t wcg_enabled)
 {
+    m_changes |= Change::Wcg;
     m_wideColorGamutEnabled = wcg_enabled == 1;
 }
 
 void WaylandOutputDevice::kde_output_device_v2_auto_rotate_policy(uint32_t policy)
 {
+    m_changes |= Change::AutoRotate;
     m_autoRotatePolicy = policy;
 }
 
 void WaylandOutputDevice::kde_output_device_v2_icc_profile_path(const QString &profile)
 {
+    m_changes |= Change::ColorProfile;
     m_iccProfilePath = profile;
 }
 
 void WaylandOutputDevice::kde_output_device_v2_brightness_metadata(uint32_t max_peak_brightness, uint32_t max_frame_average_brightness, uint32_t min_brightness)
 {
+    m_changes |= Change::BrightnessMetadata;
     m_maxPeakBrightness = max_peak_brightness;
     m_maxAverageBrightness = max_frame_average_brightness;
     m_minBrightness = min_brightness / 10'000.0;
@@ -619,6 +706,7 @@ void WaylandOutputDevice::kde_output_device_v2_brightness_metadata(uint32_t max_
 
 void WaylandOutputDevice::kde_output_device_v2_brightness_overrides(int32_t max_peak_brightness, int32_t max_average_brightness, int32_t min_brightness)
 {
+    m_changes |= Change::BrightnessMetadata;
     m_maxPeakBrightnessOverride = max_peak_brightness == -1 ? std::nullopt : std::optional(max_peak_brightness);
     m_maxAverageBrightnessOverride = max_average_brightness == -1 ? std::nullopt : std::optional(max_average_brightness);
     m_minBrightnessOverride = min_brightness == -1 ? std::nullopt : std::optional(min_brightness / 10'000.0);
@@ -626,46 +714,55 @@ void WaylandOutputDevice::kde_output_device_v2_brightness_overrides(int32_t max_
 
 void WaylandOutputDevice::kde_output_device_v2_sdr_gamut_wideness(uint32_t value)
 {
+    m_changes |= Change::Hdr;
     m_sdrGamutWideness = value / 10'000.0;
 }
 
 void WaylandOutputDevice::kde_output_device_v2_color_profile_source(uint32_t source)
 {
+    m_changes |= Change::ColorProfile;
     m_colorProfileSource = source;
 }
 
 void WaylandOutputDevice::kde_output_device_v2_brightness(uint32_t brightness)
 {
+    m_changes |= Change::Brightness;
     m_brightness = brightness;
 }
 
 void WaylandOutputDevice::kde_output_device_v2_color_power_tradeoff(uint32_t preference)
 {
+    m_changes |= Change::ColorProfile;
     m_colorPowerPreference = static_cast<color_power_tradeoff>(preference);
 }
 
 void WaylandOutputDevice::kde_output_device_v2_dimming(uint32_t dimming)
 {
+    m_changes |= Change::Brightness;
     m_dimming = dimming;
 }
 
 void WaylandOutputDevice::kde_output_device_v2_replication_source(const QString &source)
 {
+    m_changes |= Change::ReplicationSource;
     m_replicationSource = source;
 }
 
 void WaylandOutputDevice::kde_output_device_v2_ddc_ci_allowed(uint32_t allowed)
 {
+    m_changes |= Change::DdcCi;
     m_ddcCiAllowed = allowed == 1;
 }
 
 void WaylandOutputDevice::kde_output_device_v2_max_bits_per_color(uint32_t max_bpc)
 {
+    m_changes |= Change::BitsPerColor;
     m_maxBpc = max_bpc;
 }
 
 void WaylandOutputDevice::kde_output_device_v2_max_bits_per_color_range(uint32_t min_value, uint32_t max_value)
 {
+    m_changes |= Change::BitsPerColor;
     bpcRange = {
         .min = min_value,
         .max = max_value,
@@ -674,26 +771,31 @@ void WaylandOutputDevice::kde_output_device_v2_max_bits_per_color_range(uint32_t
 
 void WaylandOutputDevice::kde_output_device_v2_automatic_max_bits_per_color_limit(uint32_t value)
 {
+    m_changes |= Change::BitsPerColor;
     m_autoMaxBpcLimit = value;
 }
 
 void WaylandOutputDevice::kde_output_device_v2_edr_policy(uint32_t policy)
 {
+    m_changes |= Change::EdrPolicy;
     m_edrPolicy = policy;
 }
 
 void WaylandOutputDevice::kde_output_device_v2_sharpness(uint32_t sharpness)
 {
+    m_changes |= Change::Sharpness;
     m_sharpness = sharpness;
 }
 
 void WaylandOutputDevice::kde_output_device_v2_priority(uint32_t priority)
 {
+    m_changes |= Change::Priority;
     m_priority = priority;
 }
 
 void WaylandOutputDevice::kde_output_device_v2_auto_brightness(uint32_t enabled)
 {
+    m_changes |= Change::Brightness;
     m_autoBrightness = enabled;
 }
 
@@ -704,16 +806,19 @@ void WaylandOutputDevice::kde_output_device_v2_removed()
 
 void WaylandOutputDevice::kde_output_device_v2_hdr_icc_profile_path(const QString &profile_path)
 {
+    m_changes |= Change::Hdr;
     m_hdrIccProfilePath = profile_path;
 }
 
 void WaylandOutputDevice::kde_output_device_v2_hdr_color_profile_source(uint32_t source)
 {
+    m_changes |= Change::Hdr;
     m_hdrColorProfileSource = source;
 }
 
 void WaylandOutputDevice::kde_output_device_v2_abm_level(uint32_t level)
 {
+    m_changes |= Change::AbmLevel;
     m_abmLevel = level;
 }
 
@@ -10,6 +10,7 @@
 
 #include "qwayland-kde-output-device-v2.h"
 
+#include "configmonitor.h"
 #include "kscreen_export.h"
 #include "types.h"
 
@@ -19,6 +20,7 @@
 
 namespace KScreen
 {
+class WaylandEventQueue;
 class WaylandOutputConfiguration;
 class WaylandOutputDevice;
 class WaylandOutputManagement;
@@ -28,7 +30,11 @@ class WaylandOutputDeviceRegistry : public QWaylandClientExtensionTemplate<Wayla
     Q_OBJECT
 
 public:
-    WaylandOutputDeviceRegistry();
+    /**
+     * With @p eventQueue, the registry and the output devices it announces
+     * deliver their events on that queue.
+     */
+    explicit WaylandOutputDeviceRegistry(WaylandEventQueue *eventQueue = nullptr);
     ~WaylandOutputDeviceRegistry() override;
 
 Q_SIGNALS:
@@ -36,10 +42,12 @@ Q_SIGNALS:
     void outputRemoved(WaylandOutputDevice *outputDevice);
 
 protected:
+    void bind(struct ::wl_registry *registry, int id, int version) override;
     void kde_output_device_registry_v2_output(struct ::kde_output_device_v2 *output) override;
 
 private:
     std::vector<std::unique_ptr<WaylandOutputDevice>> m_outputDevices;
+    WaylandEventQueue *m_eventQueue;
 };
 
 class WaylandOutputDevice : public QObject, public QtWayland::kde_output_device_v2
@@ -47,6 +55,40 @@ class WaylandOutputDevice : public QObject, public QtWayland::kde_output_device_
     Q_OBJECT
 
 public:
+    /**
+     * Groups of properties that changed since the KScreen::Output was last
+     * updated from this device. Protocol events mark their group, and
+     * updateKScreenOutput() only touches the groups that are marked.
+     */
+    enum class Change : uint32_t {
+        Identity = 1 << 0, // name, make, model, edid, serial number, eisa id
+        Uuid = 1 << 1,
+        Enabled = 1 << 2,
+        Geometry = 1 << 3, // position, physical size, transform
+        Modes = 1 << 4, // available modes
+        Scale = 1 << 5,
+        Capabilities = 1 << 6,
+        Overscan = 1 << 7,
+        Vrr = 1 << 8,
+        RgbRange = 1 << 9,
+        Hdr = 1 << 10, // hdr, sdr brightness and gamut, hdr color profile
+        Wcg = 1 << 11,
+        AutoRotate = 1 << 12,
+        ColorProfile = 1 << 13, // icc profile, color profile source, color power tradeoff
+        BrightnessMetadata = 1 << 14, // brightness metadata and overrides
+        Brightness = 1 << 15, // brightness, dimming, automatic brightness
+        ReplicationSource = 1 << 16,
+        DdcCi = 1 << 17,
+        BitsPerColor = 1 << 18,
+        EdrPolicy = 1 << 19,
+        Sharpness = 1 << 20,
+        Priority = 1 << 21,
+        AbmLevel = 1 << 22,
+        CurrentMode = 1 << 23,
+        All = (1 << 24) - 1,
+    };
+    Q_DECLARE_FLAGS(Changes, Change)
+
     explicit WaylandOutputDevice(::kde_output_device_v2 *outputDevice);
     ~WaylandOutputDevice();
 
@@ -64,15 +106,41 @@ public:
     uint32_t overscan() const;
     uint32_t capabilities() const;
     uint32_t rgbRange() const;
+    uint32_t priority() const
+    {
+        return m_priority;
+    }
 
     OutputPtr toKScreenOutput(const QMap<int, WaylandOutputDevice *> &outputMap);
+    /**
+     * Applies the pending changes to @p output and clears them.
+     */
     void updateKScreenOutput(OutputPtr &output, const QMap<int, WaylandOutputDevice *> &outputMap);
     void updateKScreenModes(OutputPtr &output);
 
-    bool setWlConfig(WaylandOutputManagement *management,
-                     WaylandOutputConfiguration *wlConfig,
-                     const KScreen::OutputPtr &output,
-                     const QMap<int, WaylandOutputDevice *> &outputMap);
+    Changes pendingChanges() const
+    {
+        return m_changes;
+    }
+    void markChanged(Changes changes)
+    {
+        m_changes |= changes;
+    }
+
+    /**
+     * Adds the requests turning this device into @p output to @p wlConfig,
+     * only for the properties that differ.
+     *
+     * @param sendPriority send the priority even if it is unchanged
+     * @param changes the groups of properties to look at, the others are left as they are
+     * @return the number of requests added
+     */
+    int setWlConfig(WaylandOutputManagement *management,
+                    WaylandOutputConfiguration *wlConfig,
+                    const KScreen::OutputPtr &output,
+                    const QMap<int, WaylandOutputDevice *> &outputMap,
+                    bool sendPriority,
+                    KScreen::ConfigMonitor::OutputChanges changes = KScreen::ConfigMonitor::OutputChange::All);
 
     QString modeId() const;
     QString uuid() const
@@ -139,8 +207,11 @@ private:
 
     WaylandOutputDeviceMode *m_mode;
     QList<WaylandOutputDeviceMode *> m_modes;
+    // KScreen::Mode for every entry in m_modes, created once and shared with the KScreen::Output
+    ModeList m_kscreenModes;
 
     int m_id;
+    Changes m_changes = Change::All;
     QPoint m_pos;
     QSize m_physicalSize;
     int32_t m_subpixel;
@@ -194,4 +265,6 @@ private:
 
 }
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(KScreen::WaylandOutputDevice::Changes)
+
 KSCREEN_EXPORT QDebug operator<<(QDebug dbg, const KScreen::WaylandOutputDevice *output);
@@ -5,20 +5,52 @@
  *  SPDX-License-Identifier: LGPL-2.1-or-later
  */
 #include "waylandoutputmanagement.h"
+#include "waylandeventqueue.h"
+
 #include <QDebug>
 #include <QGuiApplication>
 
+#include <wayland-client-core.h>
+
 namespace KScreen
 {
-WaylandOutputManagement::WaylandOutputManagement(int version)
+WaylandConfigurationRequests::WaylandConfigurationRequests(uint32_t version)
+    : priority(version >= KDE_OUTPUT_CONFIGURATION_V2_SET_PRIORITY_SINCE_VERSION)
+    , sdrGamutWideness(version >= KDE_OUTPUT_CONFIGURATION_V2_SET_SDR_GAMUT_WIDENESS_SINCE_VERSION)
+    , brightnessOverrides(version >= KDE_OUTPUT_CONFIGURATION_V2_SET_BRIGHTNESS_OVERRIDES_SINCE_VERSION)
+    , colorProfileSource(version >= KDE_OUTPUT_CONFIGURATION_V2_SET_COLOR_PROFILE_SOURCE_SINCE_VERSION)
+    , brightness(version >= KDE_OUTPUT_CONFIGURATION_V2_SET_BRIGHTNESS_SINCE_VERSION)
+    , colorPowerTradeoff(version >= KDE_OUTPUT_CONFIGURATION_V2_SET_COLOR_POWER_TRADEOFF_SINCE_VERSION)
+    , dimming(version >= KDE_OUTPUT_CONFIGURATION_V2_SET_DIMMING_SINCE_VERSION)
+    , replicationSource(version >= KDE_OUTPUT_CONFIGURATION_V2_SET_REPLICATION_SOURCE_SINCE_VERSION)
+    , ddcCiAllowed(version >= KDE_OUTPUT_CONFIGURATION_V2_SET_DDC_CI_ALLOWED_SINCE_VERSION)
+    , maxBitsPerColor(version >= KDE_OUTPUT_CONFIGURATION_V2_SET_MAX_BITS_PER_COLOR_SINCE_VERSION)
+    , edrPolicy(version >= KDE_OUTPUT_CONFIGURATION_V2_SET_EDR_POLICY_SINCE_VERSION)
+    , sharpness(version >= KDE_OUTPUT_CONFIGURATION_V2_SET_SHARPNESS_SINCE_VERSION)
+    , customModes(version >= KDE_OUTPUT_CONFIGURATION_V2_SET_CUSTOM_MODES_SINCE_VERSION)
+    , autoBrightness(version >= KDE_OUTPUT_CONFIGURATION_V2_SET_AUTO_BRIGHTNESS_SINCE_VERSION)
+    , hdrIccProfilePath(version >= KDE_OUTPUT_CONFIGURATION_V2_SET_HDR_ICC_PROFILE_PATH_SINCE_VERSION)
+    , hdrColorProfileSource(version >= KDE_OUTPUT_CONFIGURATION_V2_SET_HDR_COLOR_PROFILE_SOURCE_SINCE_VERSION)
+    , abmLevel(version >= KDE_OUTPUT_CONFIGURATION_V2_SET_ABM_LEVEL_SINCE_VERSION)
+{
+}
+
+WaylandOutputManagement::WaylandOutputManagement(int version, WaylandEventQueue *eventQueue)
     : QWaylandClientExtensionTemplate<WaylandOutputManagement>(version)
+    , m_eventQueue(eventQueue)
 {
     connect(this, &WaylandOutputManagement::activeChanged, this, [this]() {
         if (!isActive()) {
             kde_output_management_v2_destroy(object());
+            m_supportedRequests = WaylandConfigurationRequests();
+        } else {
+            m_supportedRequests = WaylandConfigurationRequests(kde_output_management_v2::version());
         }
     });
     initialize();
+    if (isActive()) {
+        m_supportedRequests = WaylandConfigurationRequests(kde_output_management_v2::version());
+    }
 }
 
 WaylandOutputManagement::~WaylandOutputManagement()
@@ -28,6 +60,17 @@ WaylandOutputManagement::~WaylandOutputManagement()
     }
 }
 
+void WaylandOutputManagement::bind(struct ::wl_registry *registry, int id, int version)
+{
+    if (!m_eventQueue) {
+        QWaylandClientExtensionTemplate::bind(registry, id, version);
+        return;
+    }
+    wl_registry *wrapper = m_eventQueue->wrap(registry);
+    QWaylandClientExtensionTemplate::bind(wrapper, id, version);
+    wl_proxy_wrapper_destroy(wrapper);
+}
+
 WaylandOutputConfiguration *WaylandOutputManagement::createConfiguration()
 {
     if (isActive()) {
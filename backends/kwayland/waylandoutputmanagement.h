@@ -15,6 +15,7 @@
 namespace KScreen
 {
 class WaylandConfig;
+class WaylandEventQueue;
 class WaylandOutputDevice;
 
 class WaylandOutputConfiguration : public QObject, public QtWayland::kde_output_configuration_v2
@@ -36,13 +37,55 @@ protected:
     QString m_errorMessage;
 };
 
+/**
+ * The optional kde_output_configuration_v2 requests the compositor knows,
+ * looked up once for the bound version rather than for every request sent.
+ */
+struct WaylandConfigurationRequests {
+    explicit WaylandConfigurationRequests(uint32_t version = 0);
+
+    bool priority;
+    bool sdrGamutWideness;
+    bool brightnessOverrides;
+    bool colorProfileSource;
+    bool brightness;
+    bool colorPowerTradeoff;
+    bool dimming;
+    bool replicationSource;
+    bool ddcCiAllowed;
+    bool maxBitsPerColor;
+    bool edrPolicy;
+    bool sharpness;
+    bool customModes;
+    bool autoBrightness;
+    bool hdrIccProfilePath;
+    bool hdrColorProfileSource;
+    bool abmLevel;
+};
+
 class WaylandOutputManagement : public QWaylandClientExtensionTemplate<WaylandOutputManagement>, public QtWayland::kde_output_management_v2
 {
     Q_OBJECT
 public:
-    explicit WaylandOutputManagement(int version);
+    /**
+     * With @p eventQueue, the management and the configurations created
+     * through it deliver their events on that queue.
+     */
+    explicit WaylandOutputManagement(int version, WaylandEventQueue *eventQueue = nullptr);
     ~WaylandOutputManagement() override;
 
     WaylandOutputConfiguration *createConfiguration();
+
+    const WaylandConfigurationRequests &supportedRequests() const
+    {
+        return m_supportedRequests;
+    }
+
+protected:
+    void bind(struct ::wl_registry *registry, int id, int version) override;
+
+private:
+    WaylandConfigurationRequests m_supportedRequests;
+    WaylandEventQueue *m_eventQueue;
 };
 }
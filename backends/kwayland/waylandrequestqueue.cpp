@@ -0,0 +1,165 @@
+/*
+ *  SPDX-FileCopyrightText: 2026 KScreen contributors
+ *
+ *  SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+#include "waylandrequestqueue.h"
+
+#include "kscreen_kwayland_logging.h"
+
+#include <config.h>
+#include <output.h>
+#include <outputchanges_p.h>
+
+#include <algorithm>
+#include <utility>
+
+using namespace KScreen;
+
+namespace
+{
+// Lays the groups @p request sets for @p outputId over @p expected
+void overlay(OutputPtr &expected, const WaylandTransaction::Request &request, int outputId)
+{
+    const OutputPtr output = request.config->output(outputId);
+    if (!output) {
+        return;
+    }
+    const ConfigMonitor::OutputChanges changes = request.changes ? request.changes->value(outputId) : ConfigMonitor::OutputChange::All;
+    if (!changes) {
+        return;
+    }
+    if (expected) {
+        applyOutputChanges(expected, output, changes);
+    } else {
+        expected = output->clone();
+    }
+}
+}
+
+QFuture<SetConfigResult> WaylandTransaction::addRequest(const Request &request)
+{
+    Caller caller;
+    caller.request = request;
+    caller.promise.start();
+    QFuture<SetConfigResult> future = caller.promise.future();
+    m_callers.push_back(std::move(caller));
+    return future;
+}
+
+bool WaylandTransaction::hasCallers() const
+{
+    return !m_callers.empty();
+}
+
+QSet<int> WaylandTransaction::failUnknownOutputs(const std::function<bool(int)> &isKnown)
+{
+    QSet<int> requestedOutputs;
+    for (auto it = m_callers.begin(); it != m_callers.end();) {
+        const Request &request = it->request;
+        const QList<int> outputIds = request.changes ? request.changes->keys() : request.config->outputs().keys();
+        const auto unknown = std::ranges::find_if(outputIds, [&isKnown](int outputId) {
+            return !isKnown(outputId);
+        });
+        if (unknown != outputIds.cend()) {
+            qCWarning(KSCREEN_WAYLAND) << "Cannot find output with id" << *unknown;
+            it->promise.addResult(std::unexpected(QStringLiteral("Cannot find output with id %1").arg(*unknown)));
+            it->promise.finish();
+            // Merging happens when sending, so nothing of the failed request is left behind
+            it = m_callers.erase(it);
+            continue;
+        }
+        for (const int outputId : outputIds) {
+            requestedOutputs.insert(outputId);
+        }
+        ++it;
+    }
+    return requestedOutputs;
+}
+
+WaylandTransaction::Request WaylandTransaction::merged() const
+{
+    if (m_callers.size() == 1) {
+        return m_callers.front().request;
+    }
+
+    Request merged{.config = ConfigPtr(new Config), .changes = OutputChangeMasks()};
+    for (const Caller &caller : m_callers) {
+        const Request &request = caller.request;
+        Q_ASSERT(request.changes);
+        for (auto it = request.changes->cbegin(); it != request.changes->cend(); ++it) {
+            const OutputPtr output = request.config->output(it.key());
+            if (!output) {
+                continue;
+            }
+            if (const OutputPtr target = merged.config->output(it.key())) {
+                applyOutputChanges(target, output, it.value());
+            } else {
+                merged.config->addOutput(output->clone());
+            }
+            (*merged.changes)[it.key()] |= it.value();
+        }
+    }
+    return merged;
+}
+
+void WaylandTransaction::finish(const SetConfigResult &result)
+{
+    for (Caller &caller : m_callers) {
+        caller.promise.addResult(result);
+        caller.promise.finish();
+    }
+    m_callers.clear();
+}
+
+bool WaylandRequestQueue::isEmpty() const
+{
+    return !m_pending.hasCallers();
+}
+
+QFuture<SetConfigResult> WaylandRequestQueue::enqueue(const ConfigPtr &config, const std::optional<OutputChangeMasks> &changes, const ConfigPtr &current)
+{
+    OutputChangeMasks requestChanges;
+    if (changes) {
+        requestChanges = *changes;
+    } else {
+        // A request answering to the state it saw may well revert what is in flight or queued
+        const std::optional<WaylandTransaction::Request> pending = m_pending.hasCallers() ? std::optional(m_pending.merged()) : std::nullopt;
+        for (const OutputPtr &output : config->outputs()) {
+            const OutputPtr currentOutput = current ? current->output(output->id()) : OutputPtr();
+            OutputPtr expected = currentOutput ? currentOutput->clone() : OutputPtr();
+            if (m_inFlight) {
+                overlay(expected, *m_inFlight, output->id());
+            }
+            if (pending) {
+                overlay(expected, *pending, output->id());
+            }
+            requestChanges.insert(output->id(), expected ? outputChanges(expected, output) : ConfigMonitor::OutputChange::All);
+        }
+    }
+
+    // The caller may keep changing its config until the request is sent
+    const ConfigPtr requestConfig(new Config);
+    for (auto it = requestChanges.cbegin(); it != requestChanges.cend(); ++it) {
+        // An output missing from config fails the request once it is sent
+        if (const OutputPtr output = config->output(it.key())) {
+            requestConfig->addOutput(output->clone());
+        }
+    }
+    return m_pending.addRequest({.config = requestConfig, .changes = requestChanges});
+}
+
+void WaylandRequestQueue::setInFlight(const WaylandTransaction::Request &request)
+{
+    m_inFlight = request;
+}
+
+void WaylandRequestQueue::clearInFlight()
+{
+    m_inFlight.reset();
+}
+
+WaylandTransaction WaylandRequestQueue::take()
+{
+    return std::exchange(m_pending, WaylandTransaction());
+}
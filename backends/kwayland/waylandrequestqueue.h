@@ -0,0 +1,126 @@
+/*
+ *  SPDX-FileCopyrightText: 2026 KScreen contributors
+ *
+ *  SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+#pragma once
+
+#include "abstractbackend.h"
+#include "configmonitor.h"
+#include "kscreen_export.h"
+#include "types.h"
+
+#include <QHash>
+#include <QList>
+#include <QPromise>
+#include <QSet>
+
+#include <functional>
+#include <optional>
+#include <vector>
+
+namespace KScreen
+{
+/**
+ * A configuration sent to the compositor in one go, merged from the requests
+ * of the callers it carries.
+ *
+ * WARNING: This class is *not* part of public API, it is only exported for
+ * the unit-tests.
+ */
+class KSCREEN_EXPORT WaylandTransaction
+{
+public:
+    using OutputChangeMasks = QHash<int, KScreen::ConfigMonitor::OutputChanges>;
+
+    /**
+     * Without changes, everything of config that differs from the
+     * compositor's state is sent, otherwise only the listed groups.
+     */
+    struct Request {
+        KScreen::ConfigPtr config;
+        std::optional<OutputChangeMasks> changes;
+    };
+
+    /**
+     * Adds a caller asking for @p request.
+     *
+     * @return the future resolving with the outcome of the transaction
+     */
+    QFuture<SetConfigResult> addRequest(const Request &request);
+    bool hasCallers() const;
+
+    /**
+     * Fails the callers naming an output @p isKnown returns false for and
+     * drops their requests, the others stay in the transaction.
+     *
+     * @return the outputs named by the remaining callers
+     */
+    QSet<int> failUnknownOutputs(const std::function<bool(int)> &isKnown);
+
+    /**
+     * The requests of the callers merged into one, later requests winning
+     * for the groups they name. Several requests are only merged if all of
+     * them list their changes.
+     */
+    Request merged() const;
+
+    /**
+     * Resolves the futures of all callers with @p result.
+     */
+    void finish(const SetConfigResult &result);
+
+private:
+    struct Caller {
+        QPromise<SetConfigResult> promise;
+        Request request;
+    };
+
+    std::vector<Caller> m_callers;
+};
+
+/**
+ * Requests made while a configuration is in flight, merged into one
+ * transaction, the latest request winning for each group of properties.
+ *
+ * WARNING: This class is *not* part of public API, it is only exported for
+ * the unit-tests.
+ */
+class KSCREEN_EXPORT WaylandRequestQueue
+{
+public:
+    using OutputChangeMasks = WaylandTransaction::OutputChangeMasks;
+
+    bool isEmpty() const;
+
+    /**
+     * Adds a request for @p config to the queued transaction.
+     *
+     * With @p changes, only those groups are taken from @p config. Of a whole
+     * config, the groups that differ from the state the compositor ends up in
+     * are taken: @p current, the state it reported, with the request in
+     * flight and the queued ones applied on top. Only the outputs taken from
+     * are copied.
+     */
+    QFuture<SetConfigResult> enqueue(const KScreen::ConfigPtr &config, const std::optional<OutputChangeMasks> &changes, const KScreen::ConfigPtr &current);
+
+    /**
+     * Remembers @p request as the one the compositor is applying.
+     */
+    void setInFlight(const WaylandTransaction::Request &request);
+    /**
+     * Forgets the request in flight once the compositor answered it.
+     */
+    void clearInFlight();
+
+    /**
+     * Removes the merged transaction from the queue.
+     */
+    WaylandTransaction take();
+
+private:
+    WaylandTransaction m_pending;
+    std::optional<WaylandTransaction::Request> m_inFlight;
+};
+
+}
@@ -0,0 +1,59 @@
+/*
+ *  SPDX-FileCopyrightText: 2026 KScreen contributors
+ *
+ *  SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+#include "waylandroundtrips.h"
+
+#include <QGuiApplication>
+
+#include <wayland-client-protocol.h>
+
+using namespace KScreen;
+
+WaylandRoundtrips::~WaylandRoundtrips()
+{
+    // Without the application, the connection it owns is gone already
+    if (m_callback && qGuiApp) {
+        wl_callback_destroy(m_callback);
+    }
+}
+
+QFuture<void> WaylandRoundtrips::start(wl_display *display, int count)
+{
+    Q_ASSERT(!m_promise.future().isStarted());
+    m_display = display;
+    m_pending = count;
+    m_promise.start();
+    if (!m_display || m_pending <= 0) {
+        m_promise.finish();
+    } else {
+        next();
+    }
+    return m_promise.future();
+}
+
+void WaylandRoundtrips::next()
+{
+    static const wl_callback_listener listener = {
+        .done = done,
+    };
+    m_callback = wl_display_sync(m_display);
+    wl_callback_add_listener(m_callback, &listener, this);
+    wl_display_flush(m_display);
+}
+
+void WaylandRoundtrips::done(void *data, wl_callback *callback, uint32_t serial)
+{
+    Q_UNUSED(serial);
+
+    auto roundtrips = static_cast<WaylandRoundtrips *>(data);
+    wl_callback_destroy(callback);
+    roundtrips->m_callback = nullptr;
+
+    if (--roundtrips->m_pending > 0) {
+        roundtrips->next();
+    } else {
+        roundtrips->m_promise.finish();
+    }
+}
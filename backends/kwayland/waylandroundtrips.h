@@ -0,0 +1,52 @@
+/*
+ *  SPDX-FileCopyrightText: 2026 KScreen contributors
+ *
+ *  SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+#pragma once
+
+#include "kscreen_export.h"
+
+#include <QFuture>
+#include <QPromise>
+
+struct wl_callback;
+struct wl_display;
+
+namespace KScreen
+{
+/**
+ * Display roundtrips that do not block: each one is a sync request whose
+ * answer sends the next one.
+ *
+ * WARNING: This class is *not* part of public API, it is only exported for
+ * the unit-tests.
+ */
+class KSCREEN_EXPORT WaylandRoundtrips
+{
+public:
+    WaylandRoundtrips() = default;
+    ~WaylandRoundtrips();
+
+    WaylandRoundtrips(const WaylandRoundtrips &) = delete;
+    WaylandRoundtrips &operator=(const WaylandRoundtrips &) = delete;
+
+    /**
+     * Sends @p count roundtrips to @p display one after the other.
+     *
+     * @return a future finishing once the last one was answered, or right
+     * away without a display
+     */
+    QFuture<void> start(wl_display *display, int count);
+
+private:
+    void next();
+    static void done(void *data, wl_callback *callback, uint32_t serial);
+
+    wl_display *m_display = nullptr;
+    wl_callback *m_callback = nullptr;
+    int m_pending = 0;
+    QPromise<void> m_promise;
+};
+
+}
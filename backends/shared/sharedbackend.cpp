@@ -0,0 +1,427 @@
+/*
+ *  SPDX-FileCopyrightText: 2026 KScreen contributors
+ *
+ *  SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "sharedbackend.h"
+
+#include "../kwayland/waylandbackend.h"
+
+#include "kscreen_debug.h"
+
+#include <config.h>
+#include <output.h>
+#include <outputchanges_p.h>
+#include <trace_p.h>
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSocketNotifier>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <utility>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std::chrono_literals;
+using namespace KScreen;
+
+// How long the start waits for the first state before talking to the compositor itself
+static constexpr std::chrono::milliseconds s_initialTimeout = 1s;
+
+SharedBackend::SharedBackend(const QString &path, BackendFactory createBackend)
+    : KScreen::AbstractBackend()
+    , m_path(path)
+    , m_createBackend(std::move(createBackend))
+{
+    m_ready.start();
+
+    m_reconnectTimer.setSingleShot(true);
+    m_reconnectTimer.setInterval(1s);
+    connect(&m_reconnectTimer, &QTimer::timeout, this, [this]() {
+        if (!connectToPublisher()) {
+            m_reconnectTimer.start();
+        }
+    });
+
+    connectToPublisher();
+}
+
+SharedBackend::~SharedBackend()
+{
+    disconnectFromPublisher();
+}
+
+bool SharedBackend::isConnected() const
+{
+    return m_fd >= 0;
+}
+
+bool SharedBackend::connectToPublisher()
+{
+    const QByteArray encodedPath = QFile::encodeName(m_path);
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (encodedPath.size() >= qsizetype(sizeof(address.sun_path))) {
+        qCWarning(KSCREEN) << "Socket path too long" << m_path;
+        return false;
+    }
+    std::memcpy(address.sun_path, encodedPath.constData(), encodedPath.size());
+
+    const int fd = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (fd < 0) {
+        return false;
+    }
+    if (::connect(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    qCDebug(KSCREEN) << "Using the snapshots published on" << m_path;
+    m_fd = fd;
+    // A new publisher counts its generations from the start
+    m_generation = 0;
+    m_notifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, [this]() {
+        if (!receive()) {
+            qCWarning(KSCREEN) << "Snapshot publisher went away, keeping the last state until it is back";
+            disconnectFromPublisher();
+            m_reconnectTimer.start();
+        }
+    });
+    return true;
+}
+
+void SharedBackend::disconnectFromPublisher()
+{
+    if (m_fd < 0) {
+        return;
+    }
+    m_notifier->setEnabled(false);
+    m_notifier->deleteLater();
+    m_notifier = nullptr;
+    ::close(m_fd);
+    m_fd = -1;
+    // A publisher coming back has no idea of them
+    failForwarded(QStringLiteral("The snapshot publisher went away"));
+}
+
+void SharedBackend::init(const QVariantMap &arguments)
+{
+    m_arguments = arguments;
+
+    if (!isConnected()) {
+        return;
+    }
+
+    // A publisher accepting subscribers but not sending anything must not keep us from starting
+    if (qgetenv("KSCREEN_BACKEND_ASYNC") == QByteArray("1")) {
+        QTimer::singleShot(s_initialTimeout, this, [this]() {
+            if (!m_ready.future().isFinished()) {
+                fallBack();
+            }
+        });
+        return;
+    }
+
+    // The publisher sends its current state right away, so this is a single round trip
+    QElapsedTimer timer;
+    timer.start();
+    while (!m_ready.future().isFinished() && isConnected() && !timer.hasExpired(s_initialTimeout.count())) {
+        pollfd descriptor{.fd = m_fd, .events = POLLIN, .revents = 0};
+        if (::poll(&descriptor, 1, int(s_initialTimeout.count() - timer.elapsed())) > 0 && !receive()) {
+            disconnectFromPublisher();
+            m_reconnectTimer.start();
+        }
+    }
+    if (!m_ready.future().isFinished()) {
+        fallBack();
+    }
+}
+
+void SharedBackend::fallBack()
+{
+    qCWarning(KSCREEN) << "No snapshot published on" << m_path << "in time, talking to the compositor directly";
+    m_fallenBack = true;
+    m_reconnectTimer.stop();
+    disconnectFromPublisher();
+
+    AbstractBackend *backend = this->backend();
+    connect(backend, &AbstractBackend::configChanged, this, &AbstractBackend::configChanged);
+    if (backend->ready().isFinished()) {
+        m_ready.finish();
+    } else {
+        backend->ready().then(this, [this]() {
+            m_ready.finish();
+        });
+    }
+}
+
+bool SharedBackend::hasFallenBack() const
+{
+    return m_fallenBack;
+}
+
+AbstractBackend *SharedBackend::backend()
+{
+    if (!m_backend) {
+        m_backend = m_createBackend ? m_createBackend() : new WaylandBackend;
+        m_backend->setParent(this);
+        m_backend->init(m_arguments);
+    }
+    return m_backend;
+}
+
+bool SharedBackend::receive()
+{
+    // Only the latest state matters, so announcements that piled up are skipped without mapping them
+    SharedSnapshot::Announcement latest = {};
+    int latestFd = -1;
+    // Answered once the state they led to is in place
+    QList<SharedSnapshot::Reply> replies;
+    for (;;) {
+        // Replies are longer than announcements, and their length depends on the error they carry
+        const ssize_t size = ::recv(m_fd, nullptr, 0, MSG_PEEK | MSG_TRUNC | MSG_DONTWAIT);
+        if (size < 0 && (errno == EAGAIN || errno == EINTR)) {
+            break;
+        }
+        QByteArray data(std::max<ssize_t>(size, 0), Qt::Uninitialized);
+        iovec iov{.iov_base = data.data(), .iov_len = size_t(data.size())};
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+        msghdr message = {};
+        message.msg_iov = &iov;
+        message.msg_iovlen = 1;
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+
+        const ssize_t result = size > 0 ? ::recvmsg(m_fd, &message, MSG_DONTWAIT | MSG_CMSG_CLOEXEC) : size;
+        if (result <= 0) {
+            if (latestFd >= 0) {
+                ::close(latestFd);
+            }
+            return false;
+        }
+
+        int fd = -1;
+        if (const cmsghdr *header = CMSG_FIRSTHDR(&message);
+            header && header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS && header->cmsg_len == CMSG_LEN(sizeof(int))) {
+            std::memcpy(&fd, CMSG_DATA(header), sizeof(int));
+        }
+        if (fd < 0) {
+            if (auto reply = SharedSnapshot::decodeReply(data)) {
+                replies.append(*reply);
+            }
+            continue;
+        }
+        SharedSnapshot::Announcement announcement = {};
+        if (result == ssize_t(sizeof(announcement))) {
+            std::memcpy(&announcement, data.constData(), sizeof(announcement));
+        }
+        if (result != ssize_t(sizeof(announcement)) || announcement.magic != SharedSnapshot::s_magic || announcement.version != SharedSnapshot::s_version
+            || announcement.generation <= std::max(m_generation, latest.generation)) {
+            ::close(fd);
+            continue;
+        }
+        if (latestFd >= 0) {
+            ::close(latestFd);
+        }
+        latest = announcement;
+        latestFd = fd;
+    }
+    if (latestFd >= 0) {
+        receiveSnapshot(latest, latestFd);
+    }
+
+    for (const SharedSnapshot::Reply &reply : std::as_const(replies)) {
+        if (auto node = m_forwarded.extract(reply.serial)) {
+            node.mapped().promise.addResult(reply.result);
+            node.mapped().promise.finish();
+        }
+    }
+    return true;
+}
+
+void SharedBackend::receiveSnapshot(const SharedSnapshot::Announcement &latest, int latestFd)
+{
+    Trace::Span span("SharedBackend::receive");
+
+    // Only a sealed memfd is guaranteed not to change or shrink while it is mapped
+    constexpr int requiredSeals = F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE;
+    struct stat info;
+    if ((::fcntl(latestFd, F_GET_SEALS) & requiredSeals) != requiredSeals || ::fstat(latestFd, &info) != 0 || quint64(info.st_size) < latest.size) {
+        qCWarning(KSCREEN) << "Ignoring snapshot that is not sealed";
+        ::close(latestFd);
+        return;
+    }
+    void *data = latest.size > 0 ? ::mmap(nullptr, latest.size, PROT_READ, MAP_PRIVATE, latestFd, 0) : MAP_FAILED;
+    ::close(latestFd);
+    if (data == MAP_FAILED) {
+        qCWarning(KSCREEN) << "Cannot map snapshot" << strerror(errno);
+        return;
+    }
+    auto snapshot = SharedSnapshot::decode(QByteArrayView(static_cast<const char *>(data), qsizetype(latest.size)));
+    ::munmap(data, latest.size);
+    if (!snapshot) {
+        qCWarning(KSCREEN) << "Ignoring invalid snapshot" << snapshot.error();
+        return;
+    }
+
+    m_generation = latest.generation;
+    m_config = snapshot->config;
+    m_edids = std::move(snapshot->edids);
+    Q_EMIT configChanged(m_config);
+    if (!m_ready.future().isFinished()) {
+        m_ready.finish();
+    }
+}
+
+QFuture<void> SharedBackend::ready() const
+{
+    return m_ready.future();
+}
+
+ConfigPtr SharedBackend::config() const
+{
+    if (m_fallenBack) {
+        return m_backend->config();
+    }
+    return m_config;
+}
+
+OutputPtr SharedBackend::expectedOutput(int outputId) const
+{
+    const OutputPtr published = m_config ? m_config->output(outputId) : OutputPtr();
+    if (!published) {
+        return OutputPtr();
+    }
+    const OutputPtr output = published->clone();
+    if (m_edids.contains(outputId)) {
+        output->setEdid(m_edids.value(outputId));
+    }
+    for (const auto &[serial, forwarded] : m_forwarded) {
+        const SharedSnapshot::Request &request = forwarded.request;
+        if (!request.config) {
+            if (request.outputId == outputId && request.brightness) {
+                output->setBrightness(*request.brightness);
+            }
+            if (request.outputId == outputId && request.dimming) {
+                output->setDimming(*request.dimming);
+            }
+        } else if (request.changes.contains(outputId)) {
+            applyOutputChanges(output, request.config->output(outputId), request.changes.value(outputId));
+        }
+    }
+    return output;
+}
+
+QFuture<SetConfigResult> SharedBackend::forward(SharedSnapshot::Request request)
+{
+    if (!isConnected()) {
+        return QtFuture::makeReadyValueFuture<SetConfigResult>(std::unexpected(QStringLiteral("The snapshot publisher went away")));
+    }
+
+    request.serial = m_nextSerial++;
+    // Kept to know what to expect until the answer, whatever the caller does with its config meanwhile
+    if (request.config) {
+        request.config = request.config->clone();
+    }
+    const QByteArray data = SharedSnapshot::encodeRequest(request);
+    if (::send(m_fd, data.constData(), data.size(), MSG_NOSIGNAL | MSG_DONTWAIT) != data.size()) {
+        return QtFuture::makeReadyValueFuture<SetConfigResult>(
+            std::unexpected(QStringLiteral("Cannot send configuration to the snapshot publisher: %1").arg(QString::fromLocal8Bit(strerror(errno)))));
+    }
+
+    auto &forwarded = m_forwarded[request.serial];
+    forwarded.request = std::move(request);
+    forwarded.promise.start();
+    return forwarded.promise.future();
+}
+
+void SharedBackend::failForwarded(const QString &error)
+{
+    for (auto &[serial, forwarded] : std::exchange(m_forwarded, {})) {
+        forwarded.promise.addResult(std::unexpected(error));
+        forwarded.promise.finish();
+    }
+}
+
+QFuture<SetConfigResult> SharedBackend::setConfig(const ConfigPtr &config)
+{
+    if (m_fallenBack) {
+        return m_backend->setConfig(config);
+    }
+    if (!config) {
+        return QtFuture::makeReadyValueFuture<SetConfigResult>(std::unexpected(QStringLiteral("config is nullptr!")));
+    }
+
+    // The config was built from a published state, so everything it does not change is what the publisher has already
+    QHash<int, ConfigMonitor::OutputChanges> changes;
+    for (const OutputPtr &output : config->outputs()) {
+        const OutputPtr expected = expectedOutput(output->id());
+        if (!expected) {
+            return QtFuture::makeReadyValueFuture<SetConfigResult>(std::unexpected(QStringLiteral("Cannot find output with id %1").arg(output->id())));
+        }
+        // Without EDIDs the config would differ from the published state in them alone
+        if (!output->edid()) {
+            expected->setEdid(QByteArray());
+        }
+        ConfigMonitor::OutputChanges changed = outputChanges(expected, output);
+        changed.setFlag(ConfigMonitor::OutputChange::Connected, false);
+        if (changed.toInt()) {
+            changes.insert(output->id(), changed);
+        }
+    }
+    if (changes.isEmpty()) {
+        return QtFuture::makeReadyValueFuture(SetConfigResult());
+    }
+    return forward({.config = config, .changes = changes});
+}
+
+QFuture<SetConfigResult> SharedBackend::setPartialConfig(const ConfigPtr &config, const QHash<int, ConfigMonitor::OutputChanges> &changes)
+{
+    if (m_fallenBack) {
+        return m_backend->setPartialConfig(config, changes);
+    }
+    for (auto it = changes.cbegin(); it != changes.cend(); ++it) {
+        if (!config->output(it.key()) || !expectedOutput(it.key())) {
+            return QtFuture::makeReadyValueFuture<SetConfigResult>(std::unexpected(QStringLiteral("Cannot find output with id %1").arg(it.key())));
+        }
+    }
+    return forward({.config = config, .changes = changes});
+}
+
+QFuture<SetConfigResult> SharedBackend::setBrightness(int outputId, std::optional<double> brightness, std::optional<double> dimming)
+{
+    if (m_fallenBack) {
+        return m_backend->setBrightness(outputId, brightness, dimming);
+    }
+    if (!expectedOutput(outputId)) {
+        return QtFuture::makeReadyValueFuture<SetConfigResult>(std::unexpected(QStringLiteral("Cannot find output with id %1").arg(outputId)));
+    }
+    return forward({.outputId = outputId, .brightness = brightness, .dimming = dimming});
+}
+
+QByteArray SharedBackend::edid(int outputId) const
+{
+    if (m_fallenBack) {
+        return m_backend->edid(outputId);
+    }
+    return m_edids.value(outputId);
+}
+
+quint64 SharedBackend::generation() const
+{
+    return m_generation;
+}
+
+#include "moc_sharedbackend.cpp"
@@ -0,0 +1,114 @@
+/*
+ *  SPDX-FileCopyrightText: 2026 KScreen contributors
+ *
+ *  SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+#pragma once
+
+#include "abstractbackend.h"
+#include "sharedsnapshot.h"
+
+#include <QHash>
+#include <QPointer>
+#include <QPromise>
+#include <QTimer>
+
+#include <functional>
+#include <map>
+
+class QSocketNotifier;
+
+namespace KScreen
+{
+/**
+ * Backend reading the states published by a SnapshotPublisher in another
+ * process, instead of talking to the compositor itself.
+ *
+ * Configurations are forwarded to the publisher, which applies them. Only the
+ * groups of properties that differ from the published state are sent, so
+ * those this process does not know about keep the values the publisher has.
+ *
+ * If the publisher does not send a state in time, a backend talking to the
+ * compositor takes over reading and applying.
+ *
+ * WARNING: This class is *not* part of public API, it is only exported for
+ * the unit-tests.
+ */
+class KSCREEN_EXPORT SharedBackend : public KScreen::AbstractBackend
+{
+    Q_OBJECT
+
+public:
+    using BackendFactory = std::function<KScreen::AbstractBackend *()>;
+
+    /**
+     * @p createBackend creates the backend taking over from a silent
+     * publisher, the Wayland backend if none is given.
+     */
+    explicit SharedBackend(const QString &path = SharedSnapshot::socketPath(), BackendFactory createBackend = {});
+    ~SharedBackend() override;
+
+    /**
+     * Whether a publisher was found. Without one, the backend never becomes
+     * ready and should not be used.
+     */
+    bool isConnected() const;
+
+    void init(const QVariantMap &arguments) override;
+    QFuture<void> ready() const override;
+    KScreen::ConfigPtr config() const override;
+    QFuture<SetConfigResult> setConfig(const KScreen::ConfigPtr &config) override;
+    QFuture<SetConfigResult> setPartialConfig(const KScreen::ConfigPtr &config, const QHash<int, KScreen::ConfigMonitor::OutputChanges> &changes) override;
+    QFuture<SetConfigResult> setBrightness(int outputId, std::optional<double> brightness, std::optional<double> dimming) override;
+    QByteArray edid(int outputId) const override;
+
+    /**
+     * Generation of the last state received from the publisher.
+     */
+    quint64 generation() const;
+
+    /**
+     * Whether the publisher did not send a state in time and the backend
+     * talking to the compositor took over.
+     */
+    bool hasFallenBack() const;
+
+private:
+    bool connectToPublisher();
+    void disconnectFromPublisher();
+    // Returns false once the publisher is gone
+    bool receive();
+    void receiveSnapshot(const SharedSnapshot::Announcement &announcement, int fd);
+    void fallBack();
+
+    KScreen::AbstractBackend *backend();
+    QFuture<SetConfigResult> forward(SharedSnapshot::Request request);
+    void failForwarded(const QString &error);
+    // The published output with the forwarded requests not answered yet applied
+    KScreen::OutputPtr expectedOutput(int outputId) const;
+
+    QString m_path;
+    int m_fd = -1;
+    QSocketNotifier *m_notifier = nullptr;
+    QTimer m_reconnectTimer;
+
+    quint64 m_generation = 0;
+    KScreen::ConfigPtr m_config;
+    QHash<int, QByteArray> m_edids;
+    QPromise<void> m_ready;
+
+    struct ForwardedRequest {
+        SharedSnapshot::Request request;
+        QPromise<SetConfigResult> promise;
+    };
+    // By serial, so in the order the publisher applies them
+    std::map<quint32, ForwardedRequest> m_forwarded;
+    quint32 m_nextSerial = 1;
+
+    BackendFactory m_createBackend;
+    QPointer<KScreen::AbstractBackend> m_backend;
+    QVariantMap m_arguments;
+    bool m_fallenBack = false;
+};
+
+}
@@ -0,0 +1,479 @@
+/*
+ *  SPDX-FileCopyrightText: 2026 KScreen contributors
+ *
+ *  SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "sharedsnapshot.h"
+
+#include "../fake/parser.h"
+#include "kscreen_debug.h"
+
+#include <config.h>
+#include <configserializer_p.h>
+#include <edid.h>
+#include <output.h>
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPointer>
+#include <QSocketNotifier>
+#include <QStandardPaths>
+
+#include <algorithm>
+#include <cstring>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace KScreen;
+
+namespace
+{
+struct ContentsHeader {
+    quint32 configSize;
+    quint32 edidCount;
+};
+
+struct EdidHeader {
+    qint32 outputId;
+    quint32 size;
+};
+
+template<typename T>
+void append(QByteArray &data, const T &value)
+{
+    data.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+// The data is only aligned to bytes
+template<typename T>
+bool read(QByteArrayView data, qsizetype &offset, T &value)
+{
+    if (data.size() - offset < qsizetype(sizeof(T))) {
+        return false;
+    }
+    std::memcpy(&value, data.data() + offset, sizeof(T));
+    offset += sizeof(T);
+    return true;
+}
+
+// Requests and replies are their magic followed by JSON
+QByteArray encodeMessage(quint32 magic, const QJsonObject &object)
+{
+    QByteArray data;
+    append(data, magic);
+    data.append(QJsonDocument(object).toJson(QJsonDocument::Compact));
+    return data;
+}
+
+std::expected<QJsonObject, QString> decodeMessage(quint32 magic, QByteArrayView data)
+{
+    qsizetype offset = 0;
+    quint32 value;
+    if (!read(data, offset, value) || value != magic) {
+        return std::unexpected(QStringLiteral("Unknown message"));
+    }
+    QJsonParseError error;
+    const QJsonDocument document = QJsonDocument::fromJson(QByteArray::fromRawData(data.data() + offset, data.size() - offset), &error);
+    if (error.error != QJsonParseError::NoError || !document.isObject()) {
+        return std::unexpected(QStringLiteral("Invalid message: %1").arg(error.errorString()));
+    }
+    return document.object();
+}
+
+bool socketAddress(const QString &path, sockaddr_un &address)
+{
+    const QByteArray encodedPath = QFile::encodeName(path);
+    address = {};
+    address.sun_family = AF_UNIX;
+    if (encodedPath.size() >= qsizetype(sizeof(address.sun_path))) {
+        qCWarning(KSCREEN) << "Socket path too long" << path;
+        return false;
+    }
+    std::memcpy(address.sun_path, encodedPath.constData(), encodedPath.size());
+    return true;
+}
+}
+
+SharedSnapshot::Role SharedSnapshot::role()
+{
+    const QByteArray role = qgetenv("KSCREEN_SHARED_SNAPSHOT");
+    if (role == QByteArrayView("publish")) {
+        return Role::Publish;
+    }
+    if (role == QByteArrayView("subscribe")) {
+        return Role::Subscribe;
+    }
+    return Role::None;
+}
+
+QString SharedSnapshot::socketPath()
+{
+    QString display = qEnvironmentVariable("WAYLAND_DISPLAY", QStringLiteral("wayland-0"));
+    display.replace(QLatin1Char('/'), QLatin1Char('_'));
+    return QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation) + QStringLiteral("/kscreen-snapshot-") + display;
+}
+
+QByteArray SharedSnapshot::encode(const ConfigPtr &config)
+{
+    const QByteArray json = QJsonDocument(ConfigSerializer::serializeConfig(config)).toJson(QJsonDocument::Compact);
+
+    QList<std::pair<int, QByteArray>> edids;
+    for (const OutputPtr &output : config->outputs()) {
+        if (const Edid *edid = output->edid(); edid && !edid->rawData().isEmpty()) {
+            edids.append({output->id(), edid->rawData()});
+        }
+    }
+
+    QByteArray data;
+    append(data, ContentsHeader{.configSize = quint32(json.size()), .edidCount = quint32(edids.size())});
+    data.append(json);
+    for (const auto &[outputId, edid] : std::as_const(edids)) {
+        append(data, EdidHeader{.outputId = outputId, .size = quint32(edid.size())});
+        data.append(edid);
+    }
+    return data;
+}
+
+std::expected<SharedSnapshot::Snapshot, QString> SharedSnapshot::decode(QByteArrayView data)
+{
+    const QString truncated = QStringLiteral("Snapshot is truncated");
+
+    qsizetype offset = 0;
+    ContentsHeader header;
+    if (!read(data, offset, header) || data.size() - offset < qsizetype(header.configSize)) {
+        return std::unexpected(truncated);
+    }
+    // Parsed in place, the config does not keep any reference to the data
+    const auto config = Parser::parse(QByteArray::fromRawData(data.data() + offset, header.configSize));
+    if (!config) {
+        return std::unexpected(config.error());
+    }
+    offset += header.configSize;
+
+    Snapshot snapshot{.config = *config, .edids = {}};
+    snapshot.edids.reserve(header.edidCount);
+    for (quint32 i = 0; i < header.edidCount; ++i) {
+        EdidHeader edid;
+        if (!read(data, offset, edid) || data.size() - offset < qsizetype(edid.size)) {
+            return std::unexpected(truncated);
+        }
+        snapshot.edids.insert(edid.outputId, QByteArray(data.data() + offset, edid.size));
+        offset += edid.size;
+    }
+    return snapshot;
+}
+
+QByteArray SharedSnapshot::encodeRequest(const Request &request)
+{
+    QJsonObject object;
+    object[QLatin1String("serial")] = qint64(request.serial);
+    if (request.config) {
+        QJsonArray outputs;
+        QJsonObject changes;
+        for (auto it = request.changes.cbegin(); it != request.changes.cend(); ++it) {
+            if (const OutputPtr output = request.config->output(it.key())) {
+                outputs.append(ConfigSerializer::serializeOutput(output, it.value()));
+                changes[QString::number(it.key())] = it.value().toInt();
+            }
+        }
+        object[QLatin1String("outputs")] = outputs;
+        object[QLatin1String("changes")] = changes;
+    } else {
+        QJsonObject brightness;
+        brightness[QLatin1String("outputId")] = request.outputId;
+        if (request.brightness) {
+            brightness[QLatin1String("brightness")] = *request.brightness;
+        }
+        if (request.dimming) {
+            brightness[QLatin1String("dimming")] = *request.dimming;
+        }
+        object[QLatin1String("brightness")] = brightness;
+    }
+    return encodeMessage(s_requestMagic, object);
+}
+
+std::expected<SharedSnapshot::Request, QString> SharedSnapshot::decodeRequest(QByteArrayView data)
+{
+    const auto object = decodeMessage(s_requestMagic, data);
+    if (!object) {
+        return std::unexpected(object.error());
+    }
+
+    Request request;
+    request.serial = quint32(object->value(QLatin1String("serial")).toInteger());
+    if (const QJsonValue brightness = object->value(QLatin1String("brightness")); brightness.isObject()) {
+        const QJsonObject values = brightness.toObject();
+        request.outputId = values.value(QLatin1String("outputId")).toInt();
+        if (const QJsonValue value = values.value(QLatin1String("brightness")); value.isDouble()) {
+            request.brightness = value.toDouble();
+        }
+        if (const QJsonValue value = values.value(QLatin1String("dimming")); value.isDouble()) {
+            request.dimming = value.toDouble();
+        }
+        return request;
+    }
+
+    QJsonObject outputs;
+    outputs[QLatin1String("outputs")] = object->value(QLatin1String("outputs"));
+    const auto config = Parser::parse(QJsonDocument(outputs).toJson(QJsonDocument::Compact));
+    if (!config) {
+        return std::unexpected(config.error());
+    }
+    request.config = *config;
+
+    const QJsonObject changes = object->value(QLatin1String("changes")).toObject();
+    for (auto it = changes.constBegin(); it != changes.constEnd(); ++it) {
+        bool ok = false;
+        const int outputId = it.key().toInt(&ok);
+        if (!ok || !request.config->output(outputId)) {
+            return std::unexpected(QStringLiteral("Request changes unknown output %1").arg(it.key()));
+        }
+        request.changes.insert(outputId, ConfigMonitor::OutputChanges::fromInt(it.value().toInt()));
+    }
+    return request;
+}
+
+QByteArray SharedSnapshot::encodeReply(const Reply &reply)
+{
+    QJsonObject object;
+    object[QLatin1String("serial")] = qint64(reply.serial);
+    if (!reply.result) {
+        object[QLatin1String("error")] = reply.result.error();
+    }
+    return encodeMessage(s_replyMagic, object);
+}
+
+std::expected<SharedSnapshot::Reply, QString> SharedSnapshot::decodeReply(QByteArrayView data)
+{
+    const auto object = decodeMessage(s_replyMagic, data);
+    if (!object) {
+        return std::unexpected(object.error());
+    }
+
+    Reply reply;
+    reply.serial = quint32(object->value(QLatin1String("serial")).toInteger());
+    if (const QJsonValue error = object->value(QLatin1String("error")); error.isString()) {
+        reply.result = std::unexpected(error.toString());
+    }
+    return reply;
+}
+
+SnapshotPublisher::SnapshotPublisher(const QString &path, QObject *parent)
+    : QObject(parent)
+    , m_path(path)
+{
+    sockaddr_un address;
+    if (!socketAddress(path, address)) {
+        return;
+    }
+
+    const int fd = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (fd < 0) {
+        qCWarning(KSCREEN) << "Cannot create snapshot socket" << strerror(errno);
+        return;
+    }
+    // A publisher that went away leaves its socket behind, only take over one nobody answers on
+    if (::connect(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) == 0) {
+        qCWarning(KSCREEN) << "Another process already publishes snapshots on" << path;
+        ::close(fd);
+        return;
+    }
+    ::unlink(address.sun_path);
+    if (::bind(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0 || ::listen(fd, SOMAXCONN) != 0) {
+        qCWarning(KSCREEN) << "Cannot listen on" << path << strerror(errno);
+        ::close(fd);
+        return;
+    }
+
+    m_listenFd = fd;
+    m_listenNotifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+    connect(m_listenNotifier, &QSocketNotifier::activated, this, &SnapshotPublisher::acceptSubscriber);
+}
+
+SnapshotPublisher::~SnapshotPublisher()
+{
+    for (auto it = m_subscribers.cbegin(); it != m_subscribers.cend(); ++it) {
+        delete it.value();
+        ::close(it.key());
+    }
+    if (m_listenFd >= 0) {
+        delete m_listenNotifier;
+        ::close(m_listenFd);
+        ::unlink(QFile::encodeName(m_path).constData());
+    }
+    if (m_memfd >= 0) {
+        ::close(m_memfd);
+    }
+}
+
+bool SnapshotPublisher::isListening() const
+{
+    return m_listenFd >= 0;
+}
+
+int SnapshotPublisher::subscriberCount() const
+{
+    return m_subscribers.size();
+}
+
+void SnapshotPublisher::acceptSubscriber()
+{
+    int fd;
+    while ((fd = ::accept4(m_listenFd, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK)) >= 0) {
+        auto notifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+        connect(notifier, &QSocketNotifier::activated, this, [this, fd]() {
+            if (!readRequests(fd)) {
+                removeSubscriber(fd);
+            }
+        });
+        m_subscribers.insert(fd, notifier);
+
+        if (m_memfd >= 0 && !send(fd)) {
+            removeSubscriber(fd);
+        }
+    }
+}
+
+void SnapshotPublisher::setApplyHandler(ApplyHandler handler)
+{
+    m_applyHandler = std::move(handler);
+}
+
+bool SnapshotPublisher::readRequests(int fd)
+{
+    for (;;) {
+        // Subscribers never send empty messages, so a size of 0 means they hung up
+        const ssize_t size = ::recv(fd, nullptr, 0, MSG_PEEK | MSG_TRUNC | MSG_DONTWAIT);
+        if (size < 0 && (errno == EAGAIN || errno == EINTR)) {
+            return true;
+        }
+        if (size <= 0) {
+            return false;
+        }
+        QByteArray data(size, Qt::Uninitialized);
+        if (::recv(fd, data.data(), data.size(), MSG_DONTWAIT) != size) {
+            return false;
+        }
+
+        // Without an answer the subscriber would wait forever, so one not speaking the protocol is dropped
+        const auto request = SharedSnapshot::decodeRequest(data);
+        if (!request) {
+            qCWarning(KSCREEN) << "Dropping snapshot subscriber sending an invalid request" << request.error();
+            return false;
+        }
+
+        QSocketNotifier *notifier = m_subscribers.value(fd);
+        if (!m_applyHandler) {
+            reply(fd, notifier, {.serial = request->serial, .result = std::unexpected(QStringLiteral("The snapshot publisher does not apply configurations"))});
+            if (m_subscribers.value(fd) != notifier) {
+                return true;
+            }
+            continue;
+        }
+        m_applyHandler(*request).then(this, [this, fd, notifier = QPointer(notifier), serial = request->serial](const SetConfigResult &result) {
+            reply(fd, notifier, {.serial = serial, .result = result});
+        });
+    }
+}
+
+void SnapshotPublisher::reply(int fd, QSocketNotifier *notifier, const SharedSnapshot::Reply &reply)
+{
+    // The descriptor may have been reused by a subscriber connecting since
+    if (!notifier || m_subscribers.value(fd) != notifier) {
+        return;
+    }
+    const QByteArray data = SharedSnapshot::encodeReply(reply);
+    if (::send(fd, data.constData(), data.size(), MSG_NOSIGNAL | MSG_DONTWAIT) != data.size()) {
+        qCWarning(KSCREEN) << "Dropping snapshot subscriber not taking replies";
+        removeSubscriber(fd);
+    }
+}
+
+void SnapshotPublisher::removeSubscriber(int fd)
+{
+    if (QSocketNotifier *notifier = m_subscribers.take(fd)) {
+        notifier->setEnabled(false);
+        notifier->deleteLater();
+        ::close(fd);
+    }
+}
+
+bool SnapshotPublisher::send(int fd)
+{
+    iovec iov{.iov_base = &m_announcement, .iov_len = sizeof(m_announcement)};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+
+    msghdr message = {};
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    cmsghdr *header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof(int));
+    std::memcpy(CMSG_DATA(header), &m_memfd, sizeof(int));
+
+    return ::sendmsg(fd, &message, MSG_NOSIGNAL | MSG_DONTWAIT) == ssize_t(sizeof(m_announcement));
+}
+
+void SnapshotPublisher::publish(const ConfigPtr &config)
+{
+    if (!isListening() || !config) {
+        return;
+    }
+
+    const QByteArray data = SharedSnapshot::encode(config);
+    const int memfd = ::memfd_create("kscreen-snapshot", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (memfd < 0) {
+        qCWarning(KSCREEN) << "Cannot create snapshot memfd" << strerror(errno);
+        return;
+    }
+    for (qsizetype written = 0; written < data.size();) {
+        const ssize_t result = ::write(memfd, data.constData() + written, data.size() - written);
+        if (result < 0 && errno != EINTR) {
+            qCWarning(KSCREEN) << "Cannot write snapshot" << strerror(errno);
+            ::close(memfd);
+            return;
+        }
+        written += std::max<ssize_t>(result, 0);
+    }
+    // Subscribers map it without copying, so it must never change once handed out
+    if (::fcntl(memfd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) != 0) {
+        qCWarning(KSCREEN) << "Cannot seal snapshot" << strerror(errno);
+        ::close(memfd);
+        return;
+    }
+
+    if (m_memfd >= 0) {
+        ::close(m_memfd);
+    }
+    m_memfd = memfd;
+    m_announcement = {
+        .magic = SharedSnapshot::s_magic,
+        .version = SharedSnapshot::s_version,
+        // Subscribers skip anything not newer than what they have
+        .generation = std::max(config->generation(), m_announcement.generation + 1),
+        .size = quint64(data.size()),
+    };
+
+    const QList<int> subscribers = m_subscribers.keys();
+    for (const int fd : subscribers) {
+        if (!send(fd)) {
+            // It picks up the current state when it reconnects
+            qCWarning(KSCREEN) << "Dropping snapshot subscriber not keeping up";
+            removeSubscriber(fd);
+        }
+    }
+}
+
+#include "moc_sharedsnapshot.cpp"
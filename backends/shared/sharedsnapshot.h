@@ -0,0 +1,167 @@
+/*
+ *  SPDX-FileCopyrightText: 2026 KScreen contributors
+ *
+ *  SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+#pragma once
+
+#include "configmonitor.h"
+#include "kscreen_export.h"
+#include "types.h"
+
+#include <QByteArray>
+#include <QFuture>
+#include <QHash>
+#include <QList>
+#include <QObject>
+
+#include <expected>
+#include <functional>
+#include <optional>
+
+class QSocketNotifier;
+
+namespace KScreen
+{
+/**
+ * Sharing the backend state between the processes of a session.
+ *
+ * One process publishes every state of its backend as a sealed memfd, which
+ * it hands to the other processes over a local socket. Those map it read-only
+ * and deserialize it, instead of each talking to the compositor and building
+ * the same config themselves.
+ *
+ * Subscribers do not talk to the compositor at all: what they apply is sent
+ * to the publisher over the same socket, which applies it and answers.
+ *
+ * The roles are picked with KSCREEN_SHARED_SNAPSHOT: "publish" for the process
+ * whose backend state is shared, "subscribe" for those using it.
+ *
+ * WARNING: This namespace is *not* part of public API, it is only exported
+ * for the unit-tests.
+ */
+namespace SharedSnapshot
+{
+enum class Role {
+    None,
+    Publish,
+    Subscribe,
+};
+
+KSCREEN_EXPORT Role role();
+
+/**
+ * The socket the publisher listens on, one per Wayland display.
+ */
+KSCREEN_EXPORT QString socketPath();
+
+// Sent along with the memfd of every new state
+struct Announcement {
+    quint32 magic;
+    quint32 version;
+    quint64 generation;
+    quint64 size;
+};
+
+constexpr quint32 s_magic = 0x53534b53; // "SKSS"
+constexpr quint32 s_version = 1;
+
+struct Snapshot {
+    KScreen::ConfigPtr config;
+    QHash<int, QByteArray> edids;
+};
+
+/**
+ * The contents of the memfd: the config as ConfigSerializer writes it,
+ * followed by the EDIDs of its outputs.
+ */
+KSCREEN_EXPORT QByteArray encode(const KScreen::ConfigPtr &config);
+KSCREEN_EXPORT std::expected<Snapshot, QString> decode(QByteArrayView data);
+
+// Leading the requests of subscribers and the replies to them, which carry no memfd
+constexpr quint32 s_requestMagic = 0x51534b53; // "SKSQ"
+constexpr quint32 s_replyMagic = 0x52534b53; // "SKSR"
+
+/**
+ * An apply forwarded by a subscriber, naming outputs by the ids of the
+ * published states.
+ */
+struct Request {
+    quint32 serial = 0;
+    // The groups of properties in changes, taken from the outputs of config
+    KScreen::ConfigPtr config;
+    QHash<int, KScreen::ConfigMonitor::OutputChanges> changes;
+    // Without a config, the brightness of outputId is set instead
+    int outputId = 0;
+    std::optional<double> brightness;
+    std::optional<double> dimming;
+};
+
+struct Reply {
+    quint32 serial = 0;
+    SetConfigResult result;
+};
+
+/**
+ * Only the outputs a request names are written, each with just the groups of
+ * properties it changes.
+ */
+KSCREEN_EXPORT QByteArray encodeRequest(const Request &request);
+KSCREEN_EXPORT std::expected<Request, QString> decodeRequest(QByteArrayView data);
+KSCREEN_EXPORT QByteArray encodeReply(const Reply &reply);
+KSCREEN_EXPORT std::expected<Reply, QString> decodeReply(QByteArrayView data);
+}
+
+/**
+ * Hands the states of the backend to every process connected to
+ * SharedSnapshot::socketPath(), and applies what they forward.
+ *
+ * WARNING: This class is *not* part of public API, it is only exported for
+ * the unit-tests.
+ */
+class KSCREEN_EXPORT SnapshotPublisher : public QObject
+{
+    Q_OBJECT
+
+public:
+    using ApplyHandler = std::function<QFuture<SetConfigResult>(const SharedSnapshot::Request &request)>;
+
+    explicit SnapshotPublisher(const QString &path = SharedSnapshot::socketPath(), QObject *parent = nullptr);
+    ~SnapshotPublisher() override;
+
+    bool isListening() const;
+    int subscriberCount() const;
+
+    /**
+     * Sends @p config to all subscribers, and to everyone connecting later
+     * until the next state is published. The config needs to have its EDIDs
+     * loaded, like BackendManager::snapshot() does.
+     */
+    void publish(const KScreen::ConfigPtr &config);
+
+    /**
+     * Applies the requests subscribers forward, each one gets the outcome as
+     * reply. Without a handler, requests are rejected.
+     */
+    void setApplyHandler(ApplyHandler handler);
+
+private:
+    void acceptSubscriber();
+    // Returns false once the subscriber is gone
+    bool readRequests(int fd);
+    void removeSubscriber(int fd);
+    bool send(int fd);
+    void reply(int fd, QSocketNotifier *notifier, const SharedSnapshot::Reply &reply);
+
+    QString m_path;
+    int m_listenFd = -1;
+    QSocketNotifier *m_listenNotifier = nullptr;
+    QHash<int, QSocketNotifier *> m_subscribers;
+    ApplyHandler m_applyHandler;
+
+    // The current state, kept to hand it to new subscribers
+    int m_memfd = -1;
+    SharedSnapshot::Announcement m_announcement = {};
+};
+
+}
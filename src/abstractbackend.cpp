@@ -5,12 +5,61 @@
  */
 
 #include "abstractbackend.h"
+#include "config.h"
+#include "output.h"
+#include "outputchanges_p.h"
 
 void KScreen::AbstractBackend::init(const QVariantMap &arguments)
 {
     Q_UNUSED(arguments);
 }
 
+QFuture<void> KScreen::AbstractBackend::ready() const
+{
+    return QtFuture::makeReadyVoidFuture();
+}
+
+QFuture<KScreen::SetConfigResult> KScreen::AbstractBackend::setPartialConfig(const KScreen::ConfigPtr &config,
+                                                                             const QHash<int, KScreen::ConfigMonitor::OutputChanges> &changes)
+{
+    const KScreen::ConfigPtr current = this->config();
+    const KScreen::ConfigPtr target = current ? current->clone() : KScreen::ConfigPtr();
+    if (!target) {
+        return QtFuture::makeReadyValueFuture<SetConfigResult>(std::unexpected(QStringLiteral("Backend failed to provide a valid configuration")));
+    }
+    bool prioritiesChanged = false;
+    for (auto it = changes.cbegin(); it != changes.cend(); ++it) {
+        const KScreen::OutputPtr output = target->output(it.key());
+        const KScreen::OutputPtr source = config->output(it.key());
+        if (!output || !source) {
+            return QtFuture::makeReadyValueFuture<SetConfigResult>(std::unexpected(QStringLiteral("Cannot find output with id %1").arg(it.key())));
+        }
+        KScreen::applyOutputChanges(output, source, it.value());
+        prioritiesChanged |= it.value().testFlag(KScreen::ConfigMonitor::OutputChange::Priority);
+    }
+    if (prioritiesChanged) {
+        target->adjustPriorities();
+    }
+    return setConfig(target);
+}
+
+QFuture<KScreen::SetConfigResult> KScreen::AbstractBackend::setBrightness(int outputId, std::optional<double> brightness, std::optional<double> dimming)
+{
+    const KScreen::ConfigPtr current = config();
+    const KScreen::ConfigPtr config = current ? current->clone() : KScreen::ConfigPtr();
+    const KScreen::OutputPtr output = config ? config->output(outputId) : KScreen::OutputPtr();
+    if (!output) {
+        return QtFuture::makeReadyValueFuture<SetConfigResult>(std::unexpected(QStringLiteral("Cannot find output with id %1").arg(outputId)));
+    }
+    if (brightness) {
+        output->setBrightness(*brightness);
+    }
+    if (dimming) {
+        output->setDimming(*dimming);
+    }
+    return setConfig(config);
+}
+
 QByteArray KScreen::AbstractBackend::edid(int outputId) const
 {
     Q_UNUSED(outputId);
@@ -7,21 +7,21 @@
 
 #pragma once
 
+#include "configmonitor.h"
 #include "kscreen_export.h"
 #include "types.h"
 
 #include <QFuture>
+#include <QHash>
 #include <QObject>
 #include <QString>
 #include <expected>
+#include <optional>
 
 namespace KScreen
 {
 class Config;
 
-
-typedef std::expected<void, QString> SetConfigResult;
-
 /**
  * Abstract class for backends.
  */
@@ -44,6 +44,17 @@ public:
      */
     virtual void init(const QVariantMap &arguments);
 
+    /**
+     * Returns a future that finishes once the backend has finished its
+     * initialization and config() reflects the state of the system.
+     *
+     * Backends which initialize synchronously don't have to reimplement this
+     * method, the default implementation returns a finished future.
+     *
+     * @since 6.8
+     */
+    virtual QFuture<void> ready() const;
+
     /**
      * Returns a new Config object, holding Screen, Output objects, etc.
      *
@@ -60,6 +71,33 @@ public:
      */
     virtual QFuture<SetConfigResult> setConfig(const KScreen::ConfigPtr &config) = 0;
 
+    /**
+     * Apply some properties of some outputs of @p config to the system.
+     *
+     * @p config holds at least the outputs named in @p changes, which maps
+     * their ids to the groups of properties to take from them. Everything
+     * else is meant to keep the state the backend has, so backends can
+     * compare and send only those properties. The default implementation
+     * applies a copy of config() with the groups taken over.
+     *
+     * @since 6.8
+     */
+    virtual QFuture<SetConfigResult> setPartialConfig(const KScreen::ConfigPtr &config, const QHash<int, KScreen::ConfigMonitor::OutputChanges> &changes);
+
+    /**
+     * Changes the brightness and dimming of one output, leaving everything
+     * else alone. Values that are not set are not changed.
+     *
+     * This is meant for frequent updates, e.g. while a slider is dragged, so
+     * backends should send only these values instead of a whole
+     * configuration. The default implementation applies a copy of config()
+     * with the values changed.
+     *
+     * @see BrightnessChannel
+     * @since 6.8
+     */
+    virtual QFuture<SetConfigResult> setBrightness(int outputId, std::optional<double> brightness, std::optional<double> dimming);
+
     /**
      * Returns encoded EDID data for given output
      *
@@ -74,9 +112,8 @@ Q_SIGNALS:
     /**
      * Emitted when backend detects a change in configuration
      *
-     * It's OK to emit this signal for every single change. The emissions are aggregated
-     * in the backend launcher, so that the backend does not spam DBus and client
-     * applications.
+     * It's OK to emit this signal for every single change. ConfigMonitor can be
+     * configured to aggregate the emissions, see ConfigMonitor::setCoalescingInterval().
      *
      * @param config New configuration
      */
@@ -9,10 +9,31 @@
 #include "backendmanager_p.h"
 
 #include "../backends/fake/fake.h"
+#include "../backends/fake/parser.h"
 #include "../backends/kwayland/waylandbackend.h"
+#include "../backends/shared/sharedbackend.h"
+#include "../backends/shared/sharedsnapshot.h"
 #include "abstractbackend.h"
+#include "config.h"
 #include "configmonitor.h"
+#include "configserializer_p.h"
+#include "kscreen_debug.h"
+#include "metrics.h"
+#include "output.h"
+#include "setconfigoperation.h"
 
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QPointer>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <utility>
+
+using namespace std::chrono_literals;
 using namespace KScreen;
 
 BackendManager *BackendManager::sInstance = nullptr;
@@ -29,6 +50,9 @@ BackendManager *BackendManager::instance()
 BackendManager::BackendManager()
     : mInProcessBackend(nullptr)
 {
+    mConfigCacheTimer.setSingleShot(true);
+    mConfigCacheTimer.setInterval(1s);
+    connect(&mConfigCacheTimer, &QTimer::timeout, this, &BackendManager::writeConfigCache);
 }
 
 BackendManager::~BackendManager()
@@ -54,15 +78,57 @@ KScreen::AbstractBackend *BackendManager::loadBackendInProcess()
         return mInProcessBackend;
     }
 
+    QElapsedTimer startup;
+    startup.start();
+
+    const SharedSnapshot::Role sharing = SharedSnapshot::role();
     if (qgetenv("KSCREEN_BACKEND") == QLatin1StringView("Fake")) {
         mInProcessBackend = new Fake;
         mInProcessBackend->init(mBackendArguments);
-    } else {
+    } else if (sharing == SharedSnapshot::Role::Subscribe) {
+        auto shared = new SharedBackend;
+        if (shared->isConnected()) {
+            mInProcessBackend = shared;
+            mInProcessBackend->init(mBackendArguments);
+        } else {
+            qCDebug(KSCREEN) << "No snapshot publisher running, talking to the compositor directly";
+            delete shared;
+        }
+    }
+    if (!mInProcessBackend) {
         mInProcessBackend = new WaylandBackend;
         mInProcessBackend->init(mBackendArguments);
     }
+    if (sharing == SharedSnapshot::Role::Publish) {
+        mPublisher = new SnapshotPublisher(SharedSnapshot::socketPath(), this);
+        // Requests name outputs by the ids of the published states, which are those of this backend
+        mPublisher->setApplyHandler([this](const SharedSnapshot::Request &request) {
+            if (!request.config) {
+                return mInProcessBackend->setBrightness(request.outputId, request.brightness, request.dimming);
+            }
+            return KScreen::setConfig(request.config, request.changes);
+        });
+    }
 
+    ++mGeneration;
+    resetSnapshots();
+    // Connected before the monitor, so watchers already see the new generation
+    connect(mInProcessBackend, &AbstractBackend::configChanged, this, &BackendManager::backendConfigChanged);
     ConfigMonitor::instance()->connectInProcessBackend(mInProcessBackend);
+
+    const QFuture<void> ready = mInProcessBackend->ready();
+    if (ready.isFinished()) {
+        Metrics::record(Metrics::Stage::Startup, std::chrono::nanoseconds(startup.nsecsElapsed()));
+        backendReady();
+    } else {
+        ready.then(this, [this, backend = QPointer(mInProcessBackend), startup]() {
+            if (backend && backend == mInProcessBackend) {
+                Metrics::record(Metrics::Stage::Startup, std::chrono::nanoseconds(startup.nsecsElapsed()));
+                backendReady();
+            }
+        });
+    }
+
     setConfig(mInProcessBackend->config());
     return mInProcessBackend;
 }
@@ -78,10 +144,178 @@ void BackendManager::setConfig(ConfigPtr c)
     mConfig = c;
 }
 
+#ifndef QT_NO_DEBUG
+static QByteArray fingerprint(const ConfigPtr &config)
+{
+    return QJsonDocument(ConfigSerializer::serializeConfig(config)).toJson(QJsonDocument::Compact);
+}
+#endif
+
+ConfigPtr BackendManager::snapshot(ConfigOperation::Options options)
+{
+    if (!mInProcessBackend) {
+        return ConfigPtr();
+    }
+
+    if (!mSnapshot) {
+        const ConfigPtr config = mInProcessBackend->config();
+        if (!config) {
+            return ConfigPtr();
+        }
+        mSnapshot = config->clone();
+        mSnapshot->setGeneration(mGeneration);
+#ifndef QT_NO_DEBUG
+        mSnapshotFingerprint = fingerprint(mSnapshot);
+#endif
+    }
+    if (options.testFlag(ConfigOperation::NoEDID)) {
+        return mSnapshot;
+    }
+
+    if (!mEdidSnapshot) {
+        mEdidSnapshot = mSnapshot->clone();
+        for (const OutputPtr &output : mEdidSnapshot->outputs()) {
+            if (output->edid() == nullptr) {
+                output->setEdid(mInProcessBackend->edid(output->id()));
+            }
+        }
+#ifndef QT_NO_DEBUG
+        mEdidSnapshotFingerprint = fingerprint(mEdidSnapshot);
+#endif
+    }
+    return mEdidSnapshot;
+}
+
+bool BackendManager::isSnapshot(const ConfigPtr &config) const
+{
+    return config && (config == mSnapshot || config == mEdidSnapshot);
+}
+
+void BackendManager::resetSnapshots()
+{
+#ifndef QT_NO_DEBUG
+    // ConfigOperation::ReadOnly hands out the snapshots themselves, a change made through one of them would be seen by every reader.
+    // Checked once per generation, so handing them out stays cheap in debug builds as well.
+    Q_ASSERT_X(!mSnapshot || fingerprint(mSnapshot) == mSnapshotFingerprint, "BackendManager", "shared config snapshot was modified");
+    Q_ASSERT_X(!mEdidSnapshot || fingerprint(mEdidSnapshot) == mEdidSnapshotFingerprint, "BackendManager", "shared config snapshot was modified");
+#endif
+    mSnapshot.reset();
+    mEdidSnapshot.reset();
+}
+
+quint64 BackendManager::generation() const
+{
+    return mGeneration;
+}
+
+void BackendManager::backendConfigChanged(const ConfigPtr &config)
+{
+    Metrics::increment(Metrics::Counter::ConfigRebuilds);
+    ++mGeneration;
+    resetSnapshots();
+    if (config) {
+        config->setGeneration(mGeneration);
+    }
+    if (mConfigCacheEnabled) {
+        mConfigCacheTimer.start();
+    }
+    if (mPublisher && mInProcessBackend && mInProcessBackend->ready().isFinished()) {
+        mPublisher->publish(snapshot());
+    }
+}
+
+void BackendManager::backendReady()
+{
+    mCachedConfig.reset();
+    if (std::exchange(mCachedConfigServed, false)) {
+        // Someone is showing the cached state, report the live one as a change
+        const ConfigPtr config = mInProcessBackend->config();
+        backendConfigChanged(config);
+        ConfigMonitor::instance()->backendConfigChanged(config);
+    } else if (mPublisher) {
+        mPublisher->publish(snapshot());
+    }
+    if (mConfigCacheEnabled) {
+        mConfigCacheTimer.start();
+    }
+}
+
+void BackendManager::setConfigCacheEnabled(bool enabled)
+{
+    if (mConfigCacheEnabled == enabled) {
+        return;
+    }
+    mConfigCacheEnabled = enabled;
+    if (!enabled) {
+        mConfigCacheTimer.stop();
+    } else if (mInProcessBackend && mInProcessBackend->ready().isFinished()) {
+        mConfigCacheTimer.start();
+    }
+}
+
+QString BackendManager::configCachePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QStringLiteral("/kscreen/config.json");
+}
+
+ConfigPtr BackendManager::cachedConfig()
+{
+    if (!mCachedConfig) {
+        QFile file(configCachePath());
+        if (!file.open(QIODevice::ReadOnly)) {
+            return ConfigPtr();
+        }
+        auto config = Parser::parse(file.readAll());
+        if (!config) {
+            qCWarning(KSCREEN) << "Ignoring config cache" << file.fileName() << config.error();
+            return ConfigPtr();
+        }
+        mCachedConfig = *config;
+        mCachedConfig->setCached(true);
+    }
+
+    mCachedConfigServed = true;
+    const ConfigPtr config = mCachedConfig->clone();
+    // Reporting the live state bumps the generation, which makes this one stale
+    config->setGeneration(mGeneration);
+    return config;
+}
+
+void BackendManager::writeConfigCache()
+{
+    // The serializer doesn't write EDIDs
+    const ConfigPtr config = snapshot(ConfigOperation::NoEDID);
+    if (!config) {
+        return;
+    }
+
+    const QString path = configCachePath();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(KSCREEN) << "Cannot write config cache" << path << file.errorString();
+        return;
+    }
+    file.write(QJsonDocument(ConfigSerializer::serializeConfig(config)).toJson(QJsonDocument::Compact));
+    if (!file.commit()) {
+        qCWarning(KSCREEN) << "Cannot write config cache" << path << file.errorString();
+    }
+}
+
 void BackendManager::shutdownBackend()
 {
+    // Don't lose the last state, it is what the next start shows first
+    if (mConfigCacheTimer.isActive()) {
+        mConfigCacheTimer.stop();
+        writeConfigCache();
+    }
+    mCachedConfigServed = false;
+    delete mPublisher;
+    mPublisher = nullptr;
     delete mInProcessBackend;
     mInProcessBackend = nullptr;
+    // The generation keeps counting, so configs of the old backend stay stale
+    resetSnapshots();
 }
 
 #include "moc_backendmanager_p.cpp"
@@ -15,13 +15,16 @@
 #pragma once
 
 #include <QObject>
+#include <QTimer>
 
+#include "configoperation.h"
 #include "kscreen_export.h"
 #include "types.h"
 
 namespace KScreen
 {
 class AbstractBackend;
+class SnapshotPublisher;
 
 class KSCREEN_EXPORT BackendManager : public QObject
 {
@@ -34,6 +37,48 @@ public:
     KScreen::ConfigPtr config() const;
     void setConfig(KScreen::ConfigPtr c);
 
+    /**
+     * Immutable copy of the backend state, shared by everyone asking for it.
+     *
+     * The snapshot is only rebuilt after the backend reported a change. It
+     * is tagged with the current generation() and has the EDIDs loaded,
+     * unless @p options contains ConfigOperation::NoEDID.
+     *
+     * Nobody may modify it. Debug builds assert that whenever it is handed out.
+     *
+     * @return the snapshot, or a null pointer if no backend is loaded
+     */
+    KScreen::ConfigPtr snapshot(KScreen::ConfigOperation::Options options = KScreen::ConfigOperation::NoOptions);
+
+    /**
+     * Whether @p config is one of the current snapshots.
+     */
+    bool isSnapshot(const KScreen::ConfigPtr &config) const;
+
+    /**
+     * Generation of the backend state, increased on each backend change.
+     */
+    quint64 generation() const;
+
+    /**
+     * Keep the cache file of the backend state up to date. Writes are
+     * batched, so a burst of changes results in a single write.
+     */
+    void setConfigCacheEnabled(bool enabled);
+
+    /**
+     * Config read from the cache file, marked with Config::isCached().
+     *
+     * Once the backend is ready, its state is reported like a change, so
+     * ConfigMonitor replaces the cached state with the live one and the
+     * generation moves past the one of the returned config.
+     *
+     * @return the config, or a null pointer if there is no usable cache
+     */
+    KScreen::ConfigPtr cachedConfig();
+
+    static QString configCachePath();
+
     /** Set arguments map which a backend may use on initialization.
      *
      * Calling this method after a backend has been initialized will have no effect.
@@ -66,10 +111,31 @@ private:
     explicit BackendManager();
     static BackendManager *sInstance;
 
+    void backendConfigChanged(const KScreen::ConfigPtr &config);
+    void backendReady();
+    void writeConfigCache();
+    void resetSnapshots();
+
     KScreen::ConfigPtr mConfig;
+    KScreen::ConfigPtr mSnapshot;
+    // mSnapshot with the EDIDs loaded, only built for callers wanting them
+    KScreen::ConfigPtr mEdidSnapshot;
+    // What the snapshots looked like when they were built, only set in debug builds
+    QByteArray mSnapshotFingerprint;
+    QByteArray mEdidSnapshotFingerprint;
+    quint64 mGeneration = 0;
     QVariantMap mBackendArguments;
 
+    bool mConfigCacheEnabled = false;
+    // Whether a cached config was handed out since the backend was loaded
+    bool mCachedConfigServed = false;
+    KScreen::ConfigPtr mCachedConfig;
+    QTimer mConfigCacheTimer;
+
     KScreen::AbstractBackend *mInProcessBackend;
+    // With KSCREEN_SHARED_SNAPSHOT=publish, hands every backend state to the other processes of the session
+    // and applies what they forward
+    KScreen::SnapshotPublisher *mPublisher = nullptr;
 };
 
 }
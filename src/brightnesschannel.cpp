@@ -0,0 +1,146 @@
+/*
+ *  SPDX-FileCopyrightText: 2026 KScreen contributors
+ *
+ *  SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "brightnesschannel.h"
+
+#include "abstractbackend.h"
+#include "backendmanager_p.h"
+#include "kscreen_debug.h"
+#include "mode.h"
+#include "output.h"
+
+#include <QElapsedTimer>
+#include <QTimer>
+
+#include <optional>
+#include <utility>
+
+using namespace std::chrono_literals;
+using namespace KScreen;
+
+class Q_DECL_HIDDEN BrightnessChannel::Private
+{
+public:
+    explicit Private(BrightnessChannel *q)
+        : q(q)
+    {
+    }
+
+    void schedule();
+    void send();
+
+    BrightnessChannel *const q;
+    int outputId = -1;
+    std::chrono::nanoseconds interval = 0ns;
+
+    // Values not sent yet, only the latest of each matters
+    std::optional<double> brightness;
+    std::optional<double> dimming;
+
+    bool inFlight = false;
+    QElapsedTimer lastSent;
+    QTimer timer;
+};
+
+void BrightnessChannel::Private::schedule()
+{
+    if (inFlight || timer.isActive()) {
+        return;
+    }
+    if (!brightness && !dimming) {
+        Q_EMIT q->settled();
+        return;
+    }
+
+    const std::chrono::nanoseconds elapsed = lastSent.isValid() ? std::chrono::nanoseconds(lastSent.nsecsElapsed()) : interval;
+    if (elapsed >= interval) {
+        send();
+    } else {
+        timer.start(std::chrono::ceil<std::chrono::milliseconds>(interval - elapsed));
+    }
+}
+
+void BrightnessChannel::Private::send()
+{
+    const std::optional<double> sentBrightness = std::exchange(brightness, std::nullopt);
+    const std::optional<double> sentDimming = std::exchange(dimming, std::nullopt);
+
+    AbstractBackend *backend = BackendManager::instance()->loadBackendInProcess();
+    if (!backend) {
+        Q_EMIT q->failed(QStringLiteral("Plugin does not provide valid KScreen backend"));
+        Q_EMIT q->settled();
+        return;
+    }
+
+    inFlight = true;
+    lastSent.start();
+    auto finish = [this](const SetConfigResult &result) {
+        inFlight = false;
+        if (!result.has_value()) {
+            qCWarning(KSCREEN) << "Failed to change the brightness of output" << outputId << result.error();
+            Q_EMIT q->failed(result.error());
+        }
+        schedule();
+    };
+
+    const QFuture<SetConfigResult> pendingResult = backend->setBrightness(outputId, sentBrightness, sentDimming);
+    if (pendingResult.isFinished()) {
+        finish(pendingResult.result());
+        return;
+    }
+    pendingResult.then(q, finish);
+}
+
+BrightnessChannel::BrightnessChannel(const OutputPtr &output, QObject *parent)
+    : QObject(parent)
+    , d(new Private(this))
+{
+    d->outputId = output->id();
+
+    const ModePtr mode = output->currentMode();
+    const double refreshRate = mode && mode->refreshRate() > 0 ? mode->refreshRate() : 60.0;
+    d->interval = std::chrono::nanoseconds(qint64(1'000'000'000 / refreshRate));
+
+    d->timer.setSingleShot(true);
+    d->timer.setTimerType(Qt::PreciseTimer);
+    connect(&d->timer, &QTimer::timeout, this, [this]() {
+        d->schedule();
+    });
+}
+
+BrightnessChannel::~BrightnessChannel()
+{
+    delete d;
+}
+
+int BrightnessChannel::outputId() const
+{
+    return d->outputId;
+}
+
+std::chrono::nanoseconds BrightnessChannel::interval() const
+{
+    return d->interval;
+}
+
+void BrightnessChannel::setBrightness(double brightness)
+{
+    d->brightness = brightness;
+    d->schedule();
+}
+
+void BrightnessChannel::setDimming(double dimming)
+{
+    d->dimming = dimming;
+    d->schedule();
+}
+
+bool BrightnessChannel::isBusy() const
+{
+    return d->inFlight || d->brightness || d->dimming;
+}
+
+#include "moc_brightnesschannel.cpp"
@@ -0,0 +1,78 @@
+/*
+ *  SPDX-FileCopyrightText: 2026 KScreen contributors
+ *
+ *  SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include <QObject>
+
+#include <chrono>
+
+#include "kscreen_export.h"
+#include "types.h"
+
+namespace KScreen
+{
+/**
+ * @brief Changes the brightness and dimming of an output at a high rate.
+ *
+ * Meant for sliders and dimming animations, which change the values far more
+ * often than the display can show them. Instead of applying a whole config
+ * for every value, the channel sends just the brightness and dimming.
+ *
+ * Updates are sent at most once per frame of the output's current mode, and
+ * only one of them is in flight at a time. Values set in the meantime are
+ * coalesced, so only the latest one is sent.
+ *
+ * @since 6.8
+ */
+class KSCREEN_EXPORT BrightnessChannel : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * The refresh rate of the current mode of @p output sets the pace of the
+     * updates, later mode changes are not taken into account.
+     */
+    explicit BrightnessChannel(const KScreen::OutputPtr &output, QObject *parent = nullptr);
+    ~BrightnessChannel() override;
+
+    int outputId() const;
+
+    /**
+     * Minimum time between two updates sent to the backend.
+     */
+    std::chrono::nanoseconds interval() const;
+
+    /**
+     * @see Output::setBrightness
+     */
+    void setBrightness(double brightness);
+
+    /**
+     * @see Output::setDimming
+     */
+    void setDimming(double dimming);
+
+    /**
+     * Whether values are waiting to be sent or an update is in flight.
+     */
+    bool isBusy() const;
+
+Q_SIGNALS:
+    /**
+     * Emitted once all values set so far have been applied or failed.
+     */
+    void settled();
+
+    void failed(const QString &errorMessage);
+
+private:
+    class Private;
+    Private *const d;
+};
+
+}
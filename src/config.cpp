@@ -11,6 +11,7 @@
 #include "kscreen_debug.h"
 #include "mode.h"
 #include "screen.h"
+#include "trace_p.h"
 
 #include <QCryptographicHash>
 #include <QDebug>
@@ -70,6 +71,8 @@ public:
     OutputList outputs;
     bool tabletModeAvailable;
     bool tabletModeEngaged;
+    quint64 generation = 0;
+    bool cached = false;
 
 private:
     Config *q;
@@ -193,6 +196,8 @@ ConfigPtr Config::clone() const
     newConfig->d->screen = d->screen->clone();
     newConfig->setTabletModeAvailable(tabletModeAvailable());
     newConfig->setTabletModeEngaged(tabletModeEngaged());
+    newConfig->d->generation = d->generation;
+    newConfig->d->cached = d->cached;
     for (const OutputPtr &ourOutput : std::as_const(d->outputs)) {
         newConfig->addOutput(ourOutput->clone());
     }
@@ -379,8 +384,30 @@ void Config::setValid(bool valid)
     d->valid = valid;
 }
 
+quint64 Config::generation() const
+{
+    return d->generation;
+}
+
+void Config::setGeneration(quint64 generation)
+{
+    d->generation = generation;
+}
+
+bool Config::isCached() const
+{
+    return d->cached;
+}
+
+void Config::setCached(bool cached)
+{
+    d->cached = cached;
+}
+
 void Config::apply(const ConfigPtr &other)
 {
+    Trace::Span span("Config::apply");
+
     d->screen->apply(other->screen());
 
     setTabletModeAvailable(other->tabletModeAvailable());
@@ -408,6 +435,8 @@ void Config::apply(const ConfigPtr &other)
 
     // Update validity
     setValid(other->isValid());
+    d->generation = other->d->generation;
+    d->cached = other->d->cached;
 
     Q_EMIT prioritiesChanged();
 }
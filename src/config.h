@@ -161,6 +161,48 @@ public:
     bool isValid() const;
     void setValid(bool valid);
 
+    /**
+     * Generation of the backend state this config was taken from.
+     *
+     * The backend state gets a new, strictly increasing generation every time
+     * it changes. clone() and apply() carry the generation over, so it tells
+     * how recent a config is. Zero means the config does not originate from
+     * the backend.
+     *
+     * @since 6.8
+     */
+    quint64 generation() const;
+
+    /**
+     * Sets the generation of the config. This should not be called by the user,
+     * but by the library.
+     *
+     * @see generation
+     * @since 6.8
+     */
+    void setGeneration(quint64 generation);
+
+    /**
+     * Whether the config was read from the cache of the last known state
+     * instead of the running backend, see ConfigOperation::AllowCached.
+     *
+     * A cached config may be outdated and cannot be applied. Once the backend
+     * is ready, ConfigMonitor updates configs added to it with the live state,
+     * which clears this flag.
+     *
+     * @since 6.8
+     */
+    bool isCached() const;
+
+    /**
+     * Marks the config as read from the cache. This should not be called by
+     * the user, but by the library.
+     *
+     * @see isCached
+     * @since 6.8
+     */
+    void setCached(bool cached);
+
     void apply(const ConfigPtr &other);
 
     /**
@@ -8,9 +8,168 @@
 #include "abstractbackend.h"
 #include "backendmanager_p.h"
 #include "config.h"
+#include "edid.h"
 #include "kscreen_debug.h"
+#include "metrics.h"
+#include "mode.h"
+#include "output.h"
+#include "outputchanges_p.h"
+#include "screen.h"
+#include "trace_p.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QTimer>
+
+#include <algorithm>
+#include <optional>
+#include <tuple>
+#include <utility>
 
 using namespace KScreen;
+using namespace std::chrono_literals;
+
+namespace
+{
+// The output properties the monitor compares, one tuple per OutputChange.
+// Copying these is much cheaper than cloning the output with all its modes.
+struct OutputState {
+    explicit OutputState(const OutputPtr &output);
+    ConfigMonitor::OutputChanges changesTo(const OutputState &after) const;
+
+    // What OutputChange::Removed is reported with. Backends no longer touch
+    // an output once it is gone, so this needs no copy.
+    OutputPtr output;
+    bool connected;
+    bool enabled;
+    uint32_t priority;
+    std::tuple<QPoint, QSize, qreal, Output::Rotation, QString, QSizeF> geometry;
+    std::tuple<QList<QString>, QStringList, QList<ModeInfo>> modes;
+    std::tuple<QList<int>, int> replication;
+    std::tuple<double, double, uint32_t, bool, std::optional<double>, std::optional<double>, std::optional<double>> brightness;
+    std::tuple<bool,
+               bool,
+               Output::RgbRange,
+               QString,
+               QString,
+               Output::ColorProfileSource,
+               Output::ColorProfileSource,
+               double,
+               Output::ColorPowerTradeoff,
+               uint32_t,
+               Output::EdrPolicy>
+        color;
+    std::tuple<QString, QString, QString, Output::Type, QString, QString, QSize, QByteArray, Output::Capabilities, bool, uint32_t, Output::VrrPolicy>
+        identity;
+    std::tuple<Output::AutoRotatePolicy, bool, double, uint32_t, double, double, double, Output::BpcRange, uint32_t> other;
+};
+
+struct ConfigState {
+    explicit ConfigState(const ConfigPtr &config);
+
+    QHash<int, OutputState> outputs;
+    bool tabletModeAvailable;
+    bool tabletModeEngaged;
+    QSize screenSize;
+};
+
+OutputState::OutputState(const OutputPtr &output)
+    : output(output)
+    , connected(output->isConnected())
+    , enabled(output->isEnabled())
+    , priority(output->priority())
+    , geometry(output->pos(), output->size(), output->scale(), output->rotation(), output->currentModeId(), output->explicitLogicalSize())
+    , modes(output->modes().keys(), output->preferredModes(), output->customModes())
+    , replication(output->clones(), output->replicationSource())
+    , brightness(output->brightness(),
+                 output->dimming(),
+                 output->sdrBrightness(),
+                 output->automaticBrightness(),
+                 output->maxPeakBrightnessOverride(),
+                 output->maxAverageBrightnessOverride(),
+                 output->minBrightnessOverride())
+    , color(output->isHdrEnabled(),
+            output->isWcgEnabled(),
+            output->rgbRange(),
+            output->iccProfilePath(),
+            output->hdrIccProfilePath(),
+            output->colorProfileSource(),
+            output->hdrColorProfileSource(),
+            output->sdrGamutWideness(),
+            output->colorPowerPreference(),
+            output->maxBitsPerColor(),
+            output->edrPolicy())
+    , identity(output->name(),
+               output->vendor(),
+               output->model(),
+               output->type(),
+               output->icon(),
+               output->uuid(),
+               output->sizeMm(),
+               output->edid() ? output->edid()->rawData() : QByteArray(),
+               output->capabilities(),
+               output->followPreferredMode(),
+               output->overscan(),
+               output->vrrPolicy())
+    , other(output->autoRotatePolicy(),
+            output->ddcCiAllowed(),
+            output->sharpness(),
+            output->abmLevel(),
+            output->maxPeakBrightness(),
+            output->maxAverageBrightness(),
+            output->minBrightness(),
+            output->bitsPerColorRange(),
+            output->automaticMaxBitsPerColorLimit())
+{
+}
+
+ConfigMonitor::OutputChanges OutputState::changesTo(const OutputState &after) const
+{
+    using OutputChange = ConfigMonitor::OutputChange;
+
+    ConfigMonitor::OutputChanges changes;
+    if (connected != after.connected) {
+        changes |= OutputChange::Connected;
+    }
+    if (enabled != after.enabled) {
+        changes |= OutputChange::Enabled;
+    }
+    if (priority != after.priority) {
+        changes |= OutputChange::Priority;
+    }
+    if (geometry != after.geometry) {
+        changes |= OutputChange::Geometry;
+    }
+    if (modes != after.modes) {
+        changes |= OutputChange::Modes;
+    }
+    if (replication != after.replication) {
+        changes |= OutputChange::Replication;
+    }
+    if (brightness != after.brightness) {
+        changes |= OutputChange::Brightness;
+    }
+    if (color != after.color) {
+        changes |= OutputChange::Color;
+    }
+    if (identity != after.identity || other != after.other) {
+        changes |= OutputChange::Other;
+    }
+    return changes;
+}
+
+ConfigState::ConfigState(const ConfigPtr &config)
+    : tabletModeAvailable(config->tabletModeAvailable())
+    , tabletModeEngaged(config->tabletModeEngaged())
+    , screenSize(config->screen() ? config->screen()->currentSize() : QSize())
+{
+    const OutputList configOutputs = config->outputs();
+    outputs.reserve(configOutputs.size());
+    for (const OutputPtr &output : configOutputs) {
+        outputs.insert(output->id(), OutputState(output));
+    }
+}
+}
 
 class Q_DECL_HIDDEN ConfigMonitor::Private : public QObject
 {
@@ -19,10 +178,48 @@ class Q_DECL_HIDDEN ConfigMonitor::Private : public QObject
 public:
     Private(ConfigMonitor *q);
 
-    void configDestroyed(QObject *removedConfig);
+    void backendConfigChanged(const KScreen::ConfigPtr &newConfig);
     void updateConfigs(const KScreen::ConfigPtr &newConfig);
+    bool needsChangeTracking() const;
+    void notifySubscribers(const QHash<int, OutputChanges> &changes, const ConfigState &oldState, const KScreen::ConfigPtr &newConfig);
+
+    struct WatchedConfig {
+        QWeakPointer<KScreen::Config> config;
+        OutputChanges changes;
+    };
+    using WatchedConfigs = QHash<const KScreen::Config *, WatchedConfig>;
+    void watchConfig(const KScreen::ConfigPtr &config, OutputChanges changes);
+    WatchedConfigs::iterator unwatchConfig(WatchedConfigs::iterator it);
+    void purgeWatchedConfigs();
+
+    // Keyed by identity. Entries of destroyed configs are not removed right
+    // away, but on the next update or once enough of them may have piled up.
+    WatchedConfigs watchedConfigs;
+    qsizetype purgeThreshold = 16;
+    // Number of watched configs that don't want every change
+    qsizetype maskedConfigs = 0;
+
+    struct Subscription {
+        int outputId;
+        OutputChanges changes;
+        QPointer<QObject> context;
+        OutputChangeHandler handler;
+    };
+    QHash<int, Subscription> subscriptions;
+    int nextSubscriptionId = 1;
 
-    QList<QWeakPointer<KScreen::Config>> watchedConfigs;
+    // What the backend reported last, to find out what a change is about. Only
+    // kept while someone is interested in individual changes.
+    std::optional<ConfigState> lastState;
+
+    std::chrono::milliseconds coalescingInterval = -1ms;
+    QTimer coalescingTimer;
+    // Backends always report the complete configuration, so the latest one
+    // received during the coalescing window supersedes all earlier ones
+    KScreen::ConfigPtr pendingConfig;
+    // Since when the oldest change not propagated yet is known
+    QElapsedTimer propagationTimer;
+    qint64 propagationStart = 0;
 
 private:
     ConfigMonitor *q;
@@ -32,33 +229,180 @@ ConfigMonitor::Private::Private(ConfigMonitor *q)
     : QObject(q)
     , q(q)
 {
+    coalescingTimer.setSingleShot(true);
+    connect(&coalescingTimer, &QTimer::timeout, this, [this]() {
+        const KScreen::ConfigPtr config = std::exchange(pendingConfig, {});
+        if (config) {
+            updateConfigs(config);
+        }
+    });
+}
+
+void ConfigMonitor::Private::backendConfigChanged(const KScreen::ConfigPtr &newConfig)
+{
+    if (!propagationTimer.isValid()) {
+        propagationTimer.start();
+        propagationStart = Trace::timestamp();
+    }
+
+    if (coalescingInterval < 0ms) {
+        updateConfigs(newConfig);
+        return;
+    }
+
+    pendingConfig = newConfig;
+    // The window starts with the first change, so a steady stream of changes
+    // cannot postpone the update indefinitely
+    if (!coalescingTimer.isActive()) {
+        coalescingTimer.start(coalescingInterval);
+    }
+}
+
+ConfigMonitor::OutputChanges KScreen::outputChanges(const OutputPtr &before, const OutputPtr &after)
+{
+    return OutputState(before).changesTo(OutputState(after));
+}
+
+static QHash<int, ConfigMonitor::OutputChanges> configChanges(const ConfigState &before, const ConfigState &after)
+{
+    QHash<int, ConfigMonitor::OutputChanges> changes;
+    for (auto it = before.outputs.cbegin(); it != before.outputs.cend(); ++it) {
+        const auto newOutput = after.outputs.constFind(it.key());
+        const ConfigMonitor::OutputChanges outputChange =
+            newOutput != after.outputs.cend() ? it->changesTo(*newOutput) : ConfigMonitor::OutputChange::Removed;
+        if (outputChange.toInt()) {
+            changes.insert(it.key(), outputChange);
+        }
+    }
+    for (auto it = after.outputs.cbegin(); it != after.outputs.cend(); ++it) {
+        if (!before.outputs.contains(it.key())) {
+            changes.insert(it.key(), ConfigMonitor::OutputChange::Added);
+        }
+    }
+    return changes;
+}
+
+bool ConfigMonitor::Private::needsChangeTracking() const
+{
+    return !subscriptions.isEmpty() || maskedConfigs > 0;
+}
+
+void ConfigMonitor::Private::watchConfig(const KScreen::ConfigPtr &config, OutputChanges changes)
+{
+    auto it = watchedConfigs.find(config.data());
+    if (it == watchedConfigs.end()) {
+        if (watchedConfigs.size() >= purgeThreshold) {
+            purgeWatchedConfigs();
+        }
+        it = watchedConfigs.insert(config.data(), {});
+    } else if (it->changes != OutputChange::All) {
+        // Also covers a destroyed config whose address got reused
+        --maskedConfigs;
+    }
+
+    it->config = config.toWeakRef();
+    it->changes = changes;
+    if (changes != OutputChange::All) {
+        ++maskedConfigs;
+    }
+}
+
+ConfigMonitor::Private::WatchedConfigs::iterator ConfigMonitor::Private::unwatchConfig(WatchedConfigs::iterator it)
+{
+    if (it->changes != OutputChange::All) {
+        --maskedConfigs;
+    }
+    return watchedConfigs.erase(it);
+}
+
+void ConfigMonitor::Private::purgeWatchedConfigs()
+{
+    for (auto it = watchedConfigs.begin(); it != watchedConfigs.end();) {
+        if (it->config.isNull()) {
+            it = unwatchConfig(it);
+        } else {
+            ++it;
+        }
+    }
+    // Amortizes the sweeps over the insertions
+    purgeThreshold = std::max<qsizetype>(16, watchedConfigs.size() * 2);
 }
 
 void ConfigMonitor::Private::updateConfigs(const KScreen::ConfigPtr &newConfig)
 {
-    QMutableListIterator<QWeakPointer<Config>> iter(watchedConfigs);
-    while (iter.hasNext()) {
-        KScreen::ConfigPtr config = iter.next().toStrongRef();
+    Trace::Span span("ConfigMonitor::updateConfigs");
+
+    // Without a previous config to compare with, assume everything changed
+    OutputChanges allChanges = OutputChange::All;
+    QHash<int, OutputChanges> changes;
+    const std::optional<ConfigState> oldState = std::exchange(lastState, std::nullopt);
+    if (needsChangeTracking()) {
+        // The backend may keep modifying the config it emitted, so keep a copy of what is compared
+        lastState.emplace(newConfig);
+        if (oldState) {
+            changes = configChanges(*oldState, *lastState);
+            allChanges = {};
+            for (const OutputChanges outputChange : std::as_const(changes)) {
+                allChanges |= outputChange;
+            }
+            if (oldState->tabletModeAvailable != lastState->tabletModeAvailable || oldState->tabletModeEngaged != lastState->tabletModeEngaged
+                || oldState->screenSize != lastState->screenSize) {
+                allChanges |= OutputChange::Other;
+            }
+        }
+    }
+
+    // Applying emits signals, whose receivers may (un)watch configs, so don't
+    // touch the hash while doing so
+    QList<KScreen::ConfigPtr> configs;
+    configs.reserve(watchedConfigs.size());
+    for (auto it = watchedConfigs.begin(); it != watchedConfigs.end();) {
+        KScreen::ConfigPtr config = it->config.toStrongRef();
         if (!config) {
-            iter.remove();
+            it = unwatchConfig(it);
             continue;
         }
+        // Configs watching everything are always updated, whatever the comparison missed
+        if (it->changes == OutputChange::All || it->changes.testAnyFlags(allChanges)) {
+            configs.append(std::move(config));
+        }
+        ++it;
+    }
+    purgeThreshold = std::max<qsizetype>(16, watchedConfigs.size() * 2);
 
+    for (const KScreen::ConfigPtr &config : std::as_const(configs)) {
         config->apply(newConfig);
-        iter.setValue(config.toWeakRef());
     }
 
     Q_EMIT q->configurationChanged();
+
+    if (oldState) {
+        notifySubscribers(changes, *oldState, newConfig);
+    }
+
+    if (propagationTimer.isValid()) {
+        Metrics::record(Metrics::Stage::Propagation, std::chrono::nanoseconds(propagationTimer.nsecsElapsed()));
+        Trace::complete("ConfigMonitor propagation", propagationStart);
+        propagationTimer.invalidate();
+    }
 }
 
-void ConfigMonitor::Private::configDestroyed(QObject *removedConfig)
+void ConfigMonitor::Private::notifySubscribers(const QHash<int, OutputChanges> &changes, const ConfigState &oldState, const ConfigPtr &newConfig)
 {
-    for (auto iter = watchedConfigs.begin(); iter != watchedConfigs.end();) {
-        if (iter->toStrongRef() == removedConfig) {
-            iter = watchedConfigs.erase(iter);
-            // Iterate over the entire list in case there are duplicates
-        } else {
-            ++iter;
+    // Handlers are free to (un)subscribe, so iterate over a snapshot
+    const QHash<int, Subscription> currentSubscriptions = subscriptions;
+    for (auto change = changes.cbegin(); change != changes.cend(); ++change) {
+        const OutputPtr output = change.value().testFlag(OutputChange::Removed) ? oldState.outputs.constFind(change.key())->output : newConfig->output(change.key());
+        for (auto it = currentSubscriptions.cbegin(); it != currentSubscriptions.cend(); ++it) {
+            const Subscription &subscription = it.value();
+            if (subscription.outputId != -1 && subscription.outputId != change.key()) {
+                continue;
+            }
+            const OutputChanges relevantChanges = subscription.changes & change.value();
+            if (!relevantChanges || !subscription.context || !subscriptions.contains(it.key())) {
+                continue;
+            }
+            subscription.handler(output, relevantChanges);
         }
     }
 }
@@ -87,31 +431,86 @@ ConfigMonitor::~ConfigMonitor()
 
 void ConfigMonitor::addConfig(const ConfigPtr &config)
 {
-    const QWeakPointer<Config> weakConfig = config.toWeakRef();
-    if (!d->watchedConfigs.contains(weakConfig)) {
-        connect(weakConfig.toStrongRef().data(), &QObject::destroyed, d, &Private::configDestroyed);
-        d->watchedConfigs << weakConfig;
+    addConfig(config, OutputChange::All);
+}
+
+void ConfigMonitor::addConfig(const ConfigPtr &config, OutputChanges changes)
+{
+    Q_ASSERT_X(!BackendManager::instance()->isSnapshot(config), "ConfigMonitor::addConfig", "configs returned with ConfigOperation::ReadOnly must not be modified");
+    if (config) {
+        d->watchConfig(config, changes);
     }
 }
 
 void ConfigMonitor::removeConfig(const ConfigPtr &config)
 {
-    const QWeakPointer<Config> weakConfig = config.toWeakRef();
-    if (d->watchedConfigs.contains(config)) {
-        disconnect(weakConfig.toStrongRef().data(), &QObject::destroyed, d, &Private::configDestroyed);
-        d->watchedConfigs.removeAll(config);
+    const auto it = d->watchedConfigs.find(config.data());
+    if (it != d->watchedConfigs.end()) {
+        d->unwatchConfig(it);
     }
 }
 
-void ConfigMonitor::connectInProcessBackend(KScreen::AbstractBackend *backend)
+void ConfigMonitor::setCoalescingInterval(std::chrono::milliseconds interval)
+{
+    if (d->coalescingInterval == interval) {
+        return;
+    }
+    d->coalescingInterval = interval;
+
+    // Don't hold back a pending update when coalescing gets disabled
+    if (interval < 0ms && d->coalescingTimer.isActive()) {
+        d->coalescingTimer.stop();
+        if (const KScreen::ConfigPtr config = std::exchange(d->pendingConfig, {})) {
+            d->updateConfigs(config);
+        }
+    }
+}
+
+std::chrono::milliseconds ConfigMonitor::coalescingInterval() const
+{
+    return d->coalescingInterval;
+}
+
+int ConfigMonitor::subscribe(int outputId, OutputChanges changes, QObject *context, OutputChangeHandler handler)
 {
-    connect(backend, &AbstractBackend::configChanged, [this](KScreen::ConfigPtr config) {
-        if (config.isNull()) {
-            return;
+    Q_ASSERT(context);
+    Q_ASSERT(handler);
+
+    // Start tracking from the config the backend reported on startup, so the
+    // very next change can already be attributed
+    if (!d->lastState) {
+        if (const ConfigPtr config = BackendManager::instance()->config()) {
+            d->lastState.emplace(config);
         }
-        qCDebug(KSCREEN) << "Backend change!" << config;
-        d->updateConfigs(config);
+    }
+
+    const int id = d->nextSubscriptionId++;
+    d->subscriptions.insert(id, {outputId, changes, context, std::move(handler)});
+    connect(context, &QObject::destroyed, d, [this, id]() {
+        unsubscribe(id);
     });
+    return id;
+}
+
+void ConfigMonitor::unsubscribe(int subscription)
+{
+    d->subscriptions.remove(subscription);
+}
+
+void ConfigMonitor::connectInProcessBackend(KScreen::AbstractBackend *backend)
+{
+    // Whatever we knew about the previous backend's state is meaningless now
+    d->lastState.reset();
+    connect(backend, &AbstractBackend::configChanged, this, &ConfigMonitor::backendConfigChanged);
+}
+
+void ConfigMonitor::backendConfigChanged(const KScreen::ConfigPtr &config)
+{
+    if (config.isNull()) {
+        return;
+    }
+    qCDebug(KSCREEN) << "Backend change!" << config;
+    d->backendConfigChanged(config);
 }
 
 #include "configmonitor.moc"
@@ -9,6 +9,9 @@
 #include <QObject>
 #include <QPointer>
 
+#include <chrono>
+#include <functional>
+
 #include "kscreen_export.h"
 #include "types.h"
 
@@ -22,11 +25,76 @@ class KSCREEN_EXPORT ConfigMonitor : public QObject
     Q_OBJECT
 
 public:
+    /**
+     * Groups of output properties a change can be reported for.
+     *
+     * @since 6.8
+     */
+    enum class OutputChange {
+        Added = 1 << 0,
+        Removed = 1 << 1,
+        Connected = 1 << 2,
+        Enabled = 1 << 3,
+        Priority = 1 << 4,
+        Geometry = 1 << 5, ///< position, size, scale, rotation and current mode
+        Modes = 1 << 6, ///< available, preferred and custom modes
+        Replication = 1 << 7, ///< clones and replication source
+        Brightness = 1 << 8, ///< brightness, dimming, SDR brightness and brightness overrides
+        Color = 1 << 9, ///< HDR, WCG, color profiles, RGB range and bit depth
+        Other = 1 << 10, ///< anything else, including screen and tablet mode changes
+        All = (1 << 11) - 1,
+    };
+    Q_ENUM(OutputChange)
+    Q_DECLARE_FLAGS(OutputChanges, OutputChange)
+    Q_FLAG(OutputChanges)
+
+    using OutputChangeHandler = std::function<void(const KScreen::OutputPtr &output, KScreen::ConfigMonitor::OutputChanges changes)>;
+
     static ConfigMonitor *instance();
 
     void addConfig(const KScreen::ConfigPtr &config);
+    /**
+     * Watches @p config like addConfig(), but only updates it when the backend
+     * changes a property in @p changes. Other properties of @p config may then
+     * become stale, which is fine for users that never read them.
+     *
+     * @since 6.8
+     */
+    void addConfig(const KScreen::ConfigPtr &config, OutputChanges changes);
     void removeConfig(const KScreen::ConfigPtr &config);
 
+    /**
+     * Merges bursts of backend changes into a single update.
+     *
+     * Backends usually report several changes in a row, e.g. when a dock is
+     * plugged in. With coalescing enabled, changes arriving within @p interval
+     * of the first one are collapsed: only the latest configuration is applied
+     * to the watched configs and configurationChanged() is emitted once.
+     *
+     * A negative interval (the default) disables coalescing. An interval of
+     * zero defers the update until control returns to the event loop.
+     *
+     * @since 6.8
+     */
+    void setCoalescingInterval(std::chrono::milliseconds interval);
+    std::chrono::milliseconds coalescingInterval() const;
+
+    /**
+     * Calls @p handler whenever the backend reports one of @p changes for the
+     * output with @p outputId, or for any output if @p outputId is -1.
+     *
+     * The handler receives the updated output (the last known one for
+     * OutputChange::Removed) and the subset of @p changes that happened. It
+     * is called after the watched configs have been updated.
+     *
+     * The subscription ends when @p context is destroyed or unsubscribe() is
+     * called with the returned id.
+     *
+     * @since 6.8
+     */
+    int subscribe(int outputId, OutputChanges changes, QObject *context, OutputChangeHandler handler);
+    void unsubscribe(int subscription);
+
 Q_SIGNALS:
     void configurationChanged();
 
@@ -38,9 +106,12 @@ private:
 
     friend BackendManager;
     void connectInProcessBackend(KScreen::AbstractBackend *backend);
+    void backendConfigChanged(const KScreen::ConfigPtr &config);
 
     class Private;
     Private *const d;
 };
 
 } /* namespace KScreen */
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(KScreen::ConfigMonitor::OutputChanges)
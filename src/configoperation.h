@@ -25,6 +25,33 @@ public:
     enum Option {
         NoOptions,
         NoEDID,
+        /**
+         * Return the snapshot of the backend state shared by all readers
+         * instead of a private copy. This is O(1) as long as the state does
+         * not change, but the returned config must not be modified, nor be
+         * passed to ConfigMonitor::addConfig(). Debug builds assert that.
+         *
+         * @since 6.8
+         */
+        ReadOnly = 1 << 1,
+        /**
+         * While the backend is still initializing, return the last known
+         * config from a cache file right away instead of waiting for it. The
+         * config is marked with Config::isCached() and may be outdated.
+         * Adding it to ConfigMonitor delivers the live config once the
+         * backend is ready.
+         *
+         * This only has an effect with backends that initialize
+         * asynchronously, which is opt-in through the environment variable
+         * KSCREEN_BACKEND_ASYNC=1. Otherwise the backend is ready before the
+         * operation starts and the live config is returned.
+         *
+         * Using this option also keeps the cache file up to date, so the
+         * next start of this or another client can use it.
+         *
+         * @since 6.8
+         */
+        AllowCached = 1 << 2,
     };
     Q_DECLARE_FLAGS(Options, Option)
 
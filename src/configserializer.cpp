@@ -19,6 +19,47 @@
 using namespace Qt::StringLiterals;
 using namespace KScreen;
 
+namespace
+{
+QJsonObject serializeSizeF(const QSizeF &size)
+{
+    QJsonObject obj;
+    obj[QLatin1String("width")] = size.width();
+    obj[QLatin1String("height")] = size.height();
+    return obj;
+}
+
+QJsonObject serializeCvt(const Cvt &cvt)
+{
+    QJsonObject obj;
+    obj[QLatin1String("clock")] = qint64(cvt.clock);
+    obj[QLatin1String("hdisplay")] = cvt.hdisplay;
+    obj[QLatin1String("hsyncStart")] = cvt.hsyncStart;
+    obj[QLatin1String("hsyncEnd")] = cvt.hsyncEnd;
+    obj[QLatin1String("htotal")] = cvt.htotal;
+    obj[QLatin1String("hskew")] = cvt.hskew;
+    obj[QLatin1String("vdisplay")] = cvt.vdisplay;
+    obj[QLatin1String("vsyncStart")] = cvt.vsyncStart;
+    obj[QLatin1String("vsyncEnd")] = cvt.vsyncEnd;
+    obj[QLatin1String("vtotal")] = cvt.vtotal;
+    obj[QLatin1String("vscan")] = cvt.vscan;
+    obj[QLatin1String("flags")] = qint64(cvt.flags);
+    return obj;
+}
+
+QJsonObject serializeModeInfo(const ModeInfo &mode)
+{
+    QJsonObject obj;
+    obj[QLatin1String("size")] = ConfigSerializer::serializeSize(mode.size);
+    obj[QLatin1String("refreshRate")] = mode.refreshRate;
+    obj[QLatin1String("flags")] = mode.flags.toInt();
+    if (mode.cvt) {
+        obj[QLatin1String("cvt")] = serializeCvt(*mode.cvt);
+    }
+    return obj;
+}
+}
+
 QJsonObject ConfigSerializer::serializePoint(const QPoint &point)
 {
     QJsonObject obj;
@@ -60,66 +101,121 @@ QJsonObject ConfigSerializer::serializeConfig(const ConfigPtr &config)
 
 QJsonObject ConfigSerializer::serializeOutput(const OutputPtr &output)
 {
+    return serializeOutput(output, ConfigMonitor::OutputChange::All);
+}
+
+QJsonObject ConfigSerializer::serializeOutput(const OutputPtr &output, ConfigMonitor::OutputChanges groups)
+{
+    using OutputChange = ConfigMonitor::OutputChange;
+
     QJsonObject obj;
 
     obj[QLatin1String("id")] = output->id();
-    obj[QLatin1String("name")] = output->name();
-    obj[QLatin1String("type")] = static_cast<int>(output->type());
-    obj[QLatin1String("icon")] = output->icon();
-    obj[QLatin1String("pos")] = serializePoint(output->pos());
-    obj[QLatin1String("scale")] = output->scale();
-    obj[QLatin1String("size")] = serializeSize(output->size());
-    obj[QLatin1String("rotation")] = static_cast<int>(output->rotation());
-    obj[QLatin1String("currentModeId")] = output->currentModeId();
-    obj[QLatin1String("preferredModes")] = serializeList(output->preferredModes());
-    obj[QLatin1String("connected")] = output->isConnected();
-    obj[QLatin1String("followPreferredMode")] = output->followPreferredMode();
-    obj[QLatin1String("enabled")] = output->isEnabled();
-    obj[QLatin1String("priority")] = static_cast<int>(output->priority());
-    obj[QLatin1String("clones")] = serializeList(output->clones());
-    // obj[QLatin1String("edid")] = output->edid()->raw();
-    obj[QLatin1String("sizeMM")] = serializeSize(output->sizeMm());
-    obj[QLatin1String("replicationSource")] = output->replicationSource();
-
-    QJsonArray modes;
-    for (const ModePtr &mode : output->modes()) {
-        modes.append(serializeMode(mode));
-    }
-    obj[QLatin1String("modes")] = modes;
 
-    if (output->capabilities() & Output::Capability::Overscan) {
-        obj[QLatin1String("overscan")] = static_cast<int>(output->overscan());
-    }
-    if (output->capabilities() & Output::Capability::Vrr) {
-        obj[QLatin1String("vrrPolicy")] = static_cast<int>(output->vrrPolicy());
-    }
-    if (output->capabilities() & Output::Capability::RgbRange) {
-        obj[QLatin1String("rgbRange")] = static_cast<int>(output->rgbRange());
+    if (groups & OutputChange::Connected) {
+        obj[QLatin1String("connected")] = output->isConnected();
     }
-    if (output->capabilities() & Output::Capability::HighDynamicRange) {
-        obj[QLatin1String("hdr")] = output->isHdrEnabled();
-        obj[QLatin1String("sdr-brightness")] = static_cast<int>(output->sdrBrightness());
+    if (groups & OutputChange::Enabled) {
+        obj[QLatin1String("enabled")] = output->isEnabled();
     }
-    if (output->capabilities() & Output::Capability::WideColorGamut) {
-        obj[QLatin1String("wcg")] = output->isWcgEnabled();
+    if (groups & OutputChange::Priority) {
+        obj[QLatin1String("priority")] = static_cast<int>(output->priority());
     }
-    if (output->capabilities() & Output::Capability::AutoRotation) {
-        obj[QLatin1String("autoRotatePolicy")] = static_cast<int>(output->autoRotatePolicy());
+    if (groups & OutputChange::Geometry) {
+        obj[QLatin1String("pos")] = serializePoint(output->pos());
+        obj[QLatin1String("scale")] = output->scale();
+        obj[QLatin1String("size")] = serializeSize(output->size());
+        obj[QLatin1String("rotation")] = static_cast<int>(output->rotation());
+        obj[QLatin1String("currentModeId")] = output->currentModeId();
+        obj[QLatin1String("explicitLogicalSize")] = serializeSizeF(output->explicitLogicalSize());
     }
-    if (output->capabilities() & Output::Capability::IccProfile) {
-        obj[QLatin1String("iccProfilePath")] = output->iccProfilePath();
+    if (groups & OutputChange::Modes) {
+        obj[QLatin1String("preferredModes")] = serializeList(output->preferredModes());
+
+        QJsonArray modes;
+        for (const ModePtr &mode : output->modes()) {
+            modes.append(serializeMode(mode));
+        }
+        obj[QLatin1String("modes")] = modes;
+
+        QJsonArray customModes;
+        for (const ModeInfo &mode : output->customModes()) {
+            customModes.append(serializeModeInfo(mode));
+        }
+        obj[QLatin1String("customModes")] = customModes;
     }
-    if (output->capabilities() & Output::Capability::BrightnessControl) {
-        obj[QLatin1String("brightness")] = output->brightness();
+    if (groups & OutputChange::Replication) {
+        obj[QLatin1String("clones")] = serializeList(output->clones());
+        obj[QLatin1String("replicationSource")] = output->replicationSource();
     }
-    if (output->capabilities() & Output::Capability::DdcCi) {
-        obj[QLatin1String("ddcCiAllowed")] = output->ddcCiAllowed();
+    if (groups & OutputChange::Brightness) {
+        if (output->capabilities() & Output::Capability::HighDynamicRange) {
+            obj[QLatin1String("sdr-brightness")] = static_cast<int>(output->sdrBrightness());
+        }
+        if (output->capabilities() & Output::Capability::BrightnessControl) {
+            obj[QLatin1String("brightness")] = output->brightness();
+        }
+        obj[QLatin1String("dimming")] = output->dimming();
+        obj[QLatin1String("automaticBrightness")] = output->automaticBrightness();
+        // Unset overrides are left out, the compositor's values apply then
+        if (const auto value = output->maxPeakBrightnessOverride()) {
+            obj[QLatin1String("maxPeakBrightnessOverride")] = *value;
+        }
+        if (const auto value = output->maxAverageBrightnessOverride()) {
+            obj[QLatin1String("maxAverageBrightnessOverride")] = *value;
+        }
+        if (const auto value = output->minBrightnessOverride()) {
+            obj[QLatin1String("minBrightnessOverride")] = *value;
+        }
     }
-    if (output->capabilities() & Output::Capability::MaxBitsPerColor) {
-        obj[QLatin1String("maxBpc")] = int(output->maxBitsPerColor());
+    if (groups & OutputChange::Color) {
+        if (output->capabilities() & Output::Capability::RgbRange) {
+            obj[QLatin1String("rgbRange")] = static_cast<int>(output->rgbRange());
+        }
+        if (output->capabilities() & Output::Capability::HighDynamicRange) {
+            obj[QLatin1String("hdr")] = output->isHdrEnabled();
+        }
+        if (output->capabilities() & Output::Capability::WideColorGamut) {
+            obj[QLatin1String("wcg")] = output->isWcgEnabled();
+        }
+        if (output->capabilities() & Output::Capability::IccProfile) {
+            obj[QLatin1String("iccProfilePath")] = output->iccProfilePath();
+        }
+        if (output->capabilities() & Output::Capability::MaxBitsPerColor) {
+            obj[QLatin1String("maxBpc")] = int(output->maxBitsPerColor());
+        }
+        if (output->capabilities() & Output::Capability::ExtendedDynamicRange) {
+            obj[QLatin1String("edrPolicy")] = static_cast<int>(output->edrPolicy());
+        }
+        obj[QLatin1String("hdrIccProfilePath")] = output->hdrIccProfilePath();
+        obj[QLatin1String("colorProfileSource")] = static_cast<int>(output->colorProfileSource());
+        obj[QLatin1String("hdrColorProfileSource")] = static_cast<int>(output->hdrColorProfileSource());
+        obj[QLatin1String("sdrGamutWideness")] = output->sdrGamutWideness();
+        obj[QLatin1String("colorPowerPreference")] = static_cast<int>(output->colorPowerPreference());
     }
-    if (output->capabilities() & Output::Capability::ExtendedDynamicRange) {
-        obj[QLatin1String("edrPolicy")] = static_cast<int>(output->edrPolicy());
+    if (groups & OutputChange::Other) {
+        obj[QLatin1String("name")] = output->name();
+        obj[QLatin1String("type")] = static_cast<int>(output->type());
+        obj[QLatin1String("icon")] = output->icon();
+        obj[QLatin1String("followPreferredMode")] = output->followPreferredMode();
+        // obj[QLatin1String("edid")] = output->edid()->raw();
+        obj[QLatin1String("sizeMM")] = serializeSize(output->sizeMm());
+        obj[QLatin1String("capabilities")] = output->capabilities().toInt();
+        obj[QLatin1String("sharpness")] = output->sharpness();
+        obj[QLatin1String("abmLevel")] = static_cast<int>(output->abmLevel());
+
+        if (output->capabilities() & Output::Capability::Overscan) {
+            obj[QLatin1String("overscan")] = static_cast<int>(output->overscan());
+        }
+        if (output->capabilities() & Output::Capability::Vrr) {
+            obj[QLatin1String("vrrPolicy")] = static_cast<int>(output->vrrPolicy());
+        }
+        if (output->capabilities() & Output::Capability::AutoRotation) {
+            obj[QLatin1String("autoRotatePolicy")] = static_cast<int>(output->autoRotatePolicy());
+        }
+        if (output->capabilities() & Output::Capability::DdcCi) {
+            obj[QLatin1String("ddcCiAllowed")] = output->ddcCiAllowed();
+        }
     }
 
     return obj;
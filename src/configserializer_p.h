@@ -11,6 +11,7 @@
 #include <QJsonObject>
 #include <QVariant>
 
+#include "configmonitor.h"
 #include "kscreen_export.h"
 #include "types.h"
 
@@ -32,6 +33,11 @@ KSCREEN_EXPORT QJsonArray serializeList(const QList<T> &list)
 
 KSCREEN_EXPORT QJsonObject serializeConfig(const KScreen::ConfigPtr &config);
 KSCREEN_EXPORT QJsonObject serializeOutput(const KScreen::OutputPtr &output);
+/**
+ * Serializes the id of @p output and the properties belonging to @p groups,
+ * using the keys of serializeOutput().
+ */
+KSCREEN_EXPORT QJsonObject serializeOutput(const KScreen::OutputPtr &output, KScreen::ConfigMonitor::OutputChanges groups);
 KSCREEN_EXPORT QJsonObject serializeMode(const KScreen::ModePtr &mode);
 KSCREEN_EXPORT QJsonObject serializeScreen(const KScreen::ScreenPtr &screen);
 }
@@ -12,26 +12,36 @@
 #include <QCoreApplication>
 #include <QDBusConnection>
 #include <QDBusMessage>
+#include <QDataStream>
 #include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
 #include <QFile>
+#include <QFileInfo>
 #include <QGuiApplication>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QLoggingCategory>
+#include <QProcess>
 #include <QRect>
+#include <QSaveFile>
 #include <QScreen>
 #include <QStandardPaths>
 #include <QTimer>
 
+#include <cmath>
 #include <print>
 #include <ranges>
 #include <utility>
 
 #include "../backendmanager_p.h"
 #include "../config.h"
+#include "../configmonitor.h"
 #include "../configoperation.h"
 #include "../getconfigoperation.h"
+#include "../metrics.h"
 #include "../output.h"
 #include "../setconfigoperation.h"
 
@@ -53,10 +63,95 @@ namespace ConfigSerializer
 {
 // Exported private symbol in configserializer_p.h in KScreen
 extern QJsonObject serializeConfig(const KScreen::ConfigPtr &config);
+extern QJsonObject serializeOutput(const KScreen::OutputPtr &output);
+extern QJsonObject serializeOutput(const KScreen::OutputPtr &output, KScreen::ConfigMonitor::OutputChanges groups);
 }
 }
 
 using namespace KScreen;
+using namespace std::chrono_literals;
+
+namespace
+{
+// Everything needed to restore an output, resolved when the profile is saved
+struct ProfileOutput {
+    QString uuid;
+    QString name;
+    bool enabled = false;
+    quint32 priority = 0;
+    QPoint position;
+    double scale = 1.0;
+    qint32 rotation = KScreen::Output::None;
+    // Mode ids are assigned by the backend and only likely to stay the same,
+    // the size and refresh rate identify the mode if they don't
+    QString modeId;
+    QSize modeSize;
+    quint32 modeRefreshRate = 0; // mHz
+};
+using Profiles = QHash<QString, QList<ProfileOutput>>;
+
+QDataStream &operator<<(QDataStream &stream, const ProfileOutput &output)
+{
+    return stream << output.uuid << output.name << output.enabled << output.priority << output.position << output.scale << output.rotation << output.modeId
+                  << output.modeSize << output.modeRefreshRate;
+}
+
+QDataStream &operator>>(QDataStream &stream, ProfileOutput &output)
+{
+    return stream >> output.uuid >> output.name >> output.enabled >> output.priority >> output.position >> output.scale >> output.rotation >> output.modeId
+        >> output.modeSize >> output.modeRefreshRate;
+}
+
+constexpr quint32 s_profilesMagic = 0x4b534450; // "KSDP"
+constexpr quint32 s_profilesVersion = 1;
+
+QString profilesPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + QStringLiteral("/kscreen/doctor-profiles");
+}
+
+std::expected<Profiles, QString> readProfiles()
+{
+    QFile file(profilesPath());
+    if (!file.exists()) {
+        return Profiles();
+    }
+    if (!file.open(QIODevice::ReadOnly)) {
+        return std::unexpected(file.errorString());
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    stream >> magic >> version;
+    if (magic != s_profilesMagic || version != s_profilesVersion) {
+        return std::unexpected(QStringLiteral("Unsupported profile file %1").arg(file.fileName()));
+    }
+    Profiles profiles;
+    stream >> profiles;
+    if (stream.status() != QDataStream::Ok) {
+        return std::unexpected(QStringLiteral("Corrupt profile file %1").arg(file.fileName()));
+    }
+    return profiles;
+}
+
+std::expected<void, QString> writeProfiles(const Profiles &profiles)
+{
+    const QString path = profilesPath();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return std::unexpected(file.errorString());
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << s_profilesMagic << s_profilesVersion << profiles;
+    if (!file.commit()) {
+        return std::unexpected(file.errorString());
+    }
+    return {};
+}
+}
 
 Doctor::Doctor(QObject *parent)
     : QObject(parent)
@@ -73,7 +168,9 @@ Doctor::~Doctor()
 void Doctor::start(QCommandLineParser *parser)
 {
     m_parser = parser;
-    if (parser->isSet(QStringLiteral("json")) || parser->isSet(QStringLiteral("outputs")) || !m_outputArgs.isEmpty()) {
+    if (parser->isSet(QStringLiteral("json")) || parser->isSet(QStringLiteral("outputs")) || parser->isSet(QStringLiteral("batch"))
+        || parser->isSet(QStringLiteral("watch")) || parser->isSet(QStringLiteral("bench")) || parser->isSet(QStringLiteral("profile"))
+        || parser->isSet(QStringLiteral("save-profile")) || !m_outputArgs.isEmpty()) {
         KScreen::GetConfigOperation *op = new KScreen::GetConfigOperation();
         connect(op, &KScreen::GetConfigOperation::finished, this, [this](KScreen::ConfigOperation *op) {
             configReceived(op);
@@ -161,10 +258,10 @@ OutputPtr Doctor::findOutput(const QString &query)
     }
 }
 
-void Doctor::parseOutputArgs()
+int Doctor::parseOutputArgs(const QStringList &args)
 {
     // qCDebug(KSCREEN_DOCTOR) << "POSARGS" << m_positionalArgs;
-    for (const QString &op : std::as_const(m_outputArgs)) {
+    for (const QString &op : args) {
         auto ops = op.split(QLatin1Char('.'));
         if (ops.count() > 2) {
             bool ok;
@@ -181,20 +278,19 @@ void Doctor::parseOutputArgs()
                     auto reply = QDBusConnection::sessionBus().call(message);
                     if (reply.type() == QDBusMessage::ErrorMessage) {
                         qCWarning(KSCREEN_DOCTOR) << "DBus error from KWin:" << reply.errorName() << reply.errorMessage();
-                        return;
+                        return 2;
                     }
                     auto args = reply.arguments();
                     if (args.isEmpty()) {
                         qCWarning(KSCREEN_DOCTOR) << "activeOutputName returned no arguments";
-                        return;
+                        return 2;
                     }
                     outputQuery = args.first().toString();
                 }
 
                 OutputPtr output = findOutput(outputQuery);
                 if (!output) {
-                    qApp->exit(3);
-                    return;
+                    return 3;
                 }
                 int output_id = output->id();
 
@@ -206,8 +302,7 @@ void Doctor::parseOutputArgs()
                     uint32_t priority = ops[3].toUInt(&ok);
                     if (!ok || priority > 100) {
                         qCWarning(KSCREEN_DOCTOR) << "Wrong input: allowed values for priority are from 1 to 100";
-                        qApp->exit(5);
-                        return;
+                        return 5;
                     }
                     setPriority(output, priority);
                 } else if (ops.count() == 3 && subcmd == QLatin1String("enable")) {
@@ -218,8 +313,7 @@ void Doctor::parseOutputArgs()
                     QString mode_id = ops[3];
                     // set mode
                     if (!setMode(output, mode_id)) {
-                        qApp->exit(9);
-                        return;
+                        return 9;
                     }
                     qCDebug(KSCREEN_DOCTOR) << "Output" << output_id << "set mode" << mode_id;
 
@@ -227,8 +321,7 @@ void Doctor::parseOutputArgs()
                     QStringList _pos = ops[3].split(QLatin1Char(','));
                     if (_pos.count() != 2) {
                         qCWarning(KSCREEN_DOCTOR) << "Invalid position:" << ops[3];
-                        qApp->exit(5);
-                        return;
+                        return 5;
                     }
                     bool okX = false;
                     bool okY = false;
@@ -236,8 +329,7 @@ void Doctor::parseOutputArgs()
                     int y = _pos[1].toInt(&okY);
                     if (!okX || !okY) {
                         cerr << "Unable to parse position: " << ops[3] << Qt::endl;
-                        qApp->exit(5);
-                        return;
+                        return 5;
                     }
                     setPosition(output, QPoint(x, y));
                 } else if ((ops.count() == 4 || ops.count() == 5) && subcmd == QLatin1String("scale")) {
@@ -250,8 +342,7 @@ void Doctor::parseOutputArgs()
                     // set scale
                     if (!ok || qFuzzyCompare(scale, 0.0)) {
                         qCWarning(KSCREEN_DOCTOR) << "Could not set scale " << scale << " to output " << output_id;
-                        qApp->exit(9);
-                        return;
+                        return 9;
                     }
                     setScale(output, scale);
                 } else if ((ops.count() == 4) && (subcmd == QLatin1String("orientation") || subcmd == QStringLiteral("rotation"))) {
@@ -274,16 +365,14 @@ void Doctor::parseOutputArgs()
                     }
                     if (!ok) {
                         qCWarning(KSCREEN_DOCTOR) << "Could not set orientation " << _rotation << " to output " << output_id;
-                        qApp->exit(9);
-                        return;
+                        return 9;
                     }
                     setRotation(output, rot);
                 } else if (ops.count() == 4 && subcmd == QLatin1String("overscan")) {
                     const uint32_t overscan = ops[3].toInt();
                     if (overscan > 100) {
                         qCWarning(KSCREEN_DOCTOR) << "Wrong input: allowed values for overscan are from 0 to 100";
-                        qApp->exit(9);
-                        return;
+                        return 9;
                     }
                     setOverscan(output, overscan);
                 } else if (ops.count() == 4 && subcmd == QLatin1String("vrrpolicy")) {
@@ -297,8 +386,7 @@ void Doctor::parseOutputArgs()
                         policy = KScreen::Output::VrrPolicy::Automatic;
                     } else {
                         qCWarning(KSCREEN_DOCTOR) << "Wrong input: Only allowed values are \"never\", \"always\" and \"automatic\"";
-                        qApp->exit(9);
-                        return;
+                        return 9;
                     }
                     setVrrPolicy(output, policy);
                 } else if (ops.count() == 4 && subcmd == QLatin1String("rgbrange")) {
@@ -312,8 +400,7 @@ void Doctor::parseOutputArgs()
                         range = KScreen::Output::RgbRange::Limited;
                     } else {
                         qCWarning(KSCREEN_DOCTOR) << "Wrong input: Only allowed values for rgbrange are \"automatic\", \"full\" and \"limited\"";
-                        qApp->exit(9);
-                        return;
+                        return 9;
                     }
                     setRgbRange(output, range);
                 } else if (ops.count() == 4 && subcmd == "hdr") {
@@ -326,15 +413,13 @@ void Doctor::parseOutputArgs()
                         setHdrEnabled(output, !output->isHdrEnabled());
                     } else {
                         qCWarning(KSCREEN_DOCTOR) << "Wrong input: Only allowed values for hdr are \"enable\", \"disable\" and \"toggle\"";
-                        qApp->exit(9);
-                        return;
+                        return 9;
                     }
                 } else if (ops.count() == 4 && subcmd == "sdr-brightness") {
                     const uint32_t brightness = ops[3].toInt();
                     if (brightness < 50 || brightness > 10000) {
                         qCWarning(KSCREEN_DOCTOR) << "Wrong input: Allowed range for sdr-brightness is 50 to 10000";
-                        qApp->exit(9);
-                        return;
+                        return 9;
                     }
                     setSdrBrightness(output, brightness);
                 } else if (ops.count() == 4 && subcmd == "wcg") {
@@ -347,8 +432,7 @@ void Doctor::parseOutputArgs()
                         setWcgEnabled(output, !output->isWcgEnabled());
                     } else {
                         qCWarning(KSCREEN_DOCTOR) << "Wrong input: Only allowed values for wcg are \"enable\", \"disable\" and \"toggle\"";
-                        qApp->exit(9);
-                        return;
+                        return 9;
                     }
                 } else if (ops.count() == 4 && subcmd == "hdrAndWcg") {
                     const QString _enable = ops[3].toLower();
@@ -365,8 +449,7 @@ void Doctor::parseOutputArgs()
                         setWcgEnabled(output, !isHdrEnabled);
                     } else {
                         qCWarning(KSCREEN_DOCTOR) << "Wrong input: Only allowed values for hdrAndWcg are \"enable\", \"disable\" and \"toggle\"";
-                        qApp->exit(9);
-                        return;
+                        return 9;
                     }
                 } else if (ops.count() >= 4 && subcmd == "iccprofile") {
                     QString profilePath = ops[3];
@@ -386,8 +469,7 @@ void Doctor::parseOutputArgs()
                     const uint32_t wideness = ops[3].toUInt();
                     if (wideness > 100) {
                         qCWarning(KSCREEN_DOCTOR) << "Wrong input: Allowed range for sdr wideness is 0 to 100";
-                        qApp->exit(9);
-                        return;
+                        return 9;
                     }
                     output->setSdrGamutWideness(wideness / 100.0);
                     m_changed = true;
@@ -398,8 +480,7 @@ void Doctor::parseOutputArgs()
                         output->setMaxPeakBrightnessOverride(nits);
                     } else {
                         qCWarning(KSCREEN_DOCTOR) << "Wrong input: max brightness must be bigger than 0";
-                        qApp->exit(9);
-                        return;
+                        return 9;
                     }
                     m_changed = true;
                 } else if (ops.count() >= 4 && subcmd == "maxAverageBrightnessOverride") {
@@ -409,8 +490,7 @@ void Doctor::parseOutputArgs()
                         output->setMaxAverageBrightnessOverride(nits);
                     } else {
                         qCWarning(KSCREEN_DOCTOR) << "Wrong input: max average brightness must be bigger than 0";
-                        qApp->exit(9);
-                        return;
+                        return 9;
                     }
                     m_changed = true;
                 } else if (ops.count() >= 4 && subcmd == "minBrightnessOverride") {
@@ -421,8 +501,7 @@ void Doctor::parseOutputArgs()
                         output->setMinBrightnessOverride(nits10k / 10'000.0);
                     } else {
                         qCWarning(KSCREEN_DOCTOR) << "Wrong input: couldn't parse" << ops[3];
-                        qApp->exit(9);
-                        return;
+                        return 9;
                     }
                     m_changed = true;
                 } else if (ops.count() >= 4 && subcmd == "colorProfileSource") {
@@ -434,8 +513,7 @@ void Doctor::parseOutputArgs()
                         output->setColorProfileSource(Output::ColorProfileSource::EDID);
                     } else {
                         qCWarning(KSCREEN_DOCTOR) << "Wrong input: only allowed values for colorProfileSource are \"sRGB\", \"ICC\" and \"EDID\"";
-                        qApp->exit(9);
-                        return;
+                        return 9;
                     }
                     m_changed = true;
                 } else if (ops.count() >= 4 && subcmd == "hdrColorProfileSource") {
@@ -445,16 +523,14 @@ void Doctor::parseOutputArgs()
                         output->setHdrColorProfileSource(Output::ColorProfileSource::EDID);
                     } else {
                         qCWarning(KSCREEN_DOCTOR) << "Wrong input: only allowed values for hdrColorProfileSource are \"ICC\" and \"EDID\"";
-                        qApp->exit(9);
-                        return;
+                        return 9;
                     }
                     m_changed = true;
                 } else if (ops.count() >= 4 && subcmd == "brightness") {
                     const uint32_t brightness = ops[3].toUInt();
                     if (brightness > 100) {
                         qCWarning(KSCREEN_DOCTOR) << "Wrong input: Allowed range for brightness is 0 to 100";
-                        qApp->exit(9);
-                        return;
+                        return 9;
                     }
                     output->setBrightness(brightness / 100.0);
                     m_changed = true;
@@ -465,16 +541,14 @@ void Doctor::parseOutputArgs()
                         output->setColorPowerPreference(Output::ColorPowerTradeoff::PreferAccuracy);
                     } else {
                         qCWarning(KSCREEN_DOCTOR) << "Wrong input: only allowed values for colorPowerTradeoff are \"preferEfficiency\" and \"preferAccuracy\"";
-                        qApp->exit(9);
-                        return;
+                        return 9;
                     }
                     m_changed = true;
                 } else if (ops.count() >= 4 && subcmd == "dimming") {
                     const uint32_t dimming = ops[3].toUInt();
                     if (dimming > 100) {
                         qCWarning(KSCREEN_DOCTOR) << "Wrong input: Allowed range for dimming is 0 to 100";
-                        qApp->exit(9);
-                        return;
+                        return 9;
                     }
                     output->setDimming(dimming / 100.0);
                     m_changed = true;
@@ -485,8 +559,7 @@ void Doctor::parseOutputArgs()
                         const auto source = findOutput(ops[3]);
                         if (!source) {
                             qCWarning(KSCREEN_DOCTOR, "No output %s", qPrintable(ops[3]));
-                            qApp->exit(9);
-                            return;
+                            return 9;
                         }
                         output->setReplicationSource(source->id());
                     }
@@ -499,8 +572,7 @@ void Doctor::parseOutputArgs()
                         output->setDdcCiAllowed(false);
                     } else {
                         qCWarning(KSCREEN_DOCTOR) << "Wrong input: Only allowed values for ddcCi are \"allow\" and \"disallow\"";
-                        qApp->exit(9);
-                        return;
+                        return 9;
                     }
                     m_changed = true;
                 } else if (ops.count() >= 4 && subcmd == "maxbpc") {
@@ -511,8 +583,7 @@ void Doctor::parseOutputArgs()
                         const uint32_t bpc = ops[3].toUInt(&ok);
                         if (!ok || bpc < 6 || bpc > 16 || bpc % 2 != 0) {
                             qCWarning(KSCREEN_DOCTOR) << "Wrong input: Only 'automatic' and whole numbers between 6 and 16 are allowed";
-                            qApp->exit(9);
-                            return;
+                            return 9;
                         }
                         output->setMaxBitsPerColor(bpc);
                     }
@@ -524,16 +595,14 @@ void Doctor::parseOutputArgs()
                         output->setEdrPolicy(Output::EdrPolicy::Always);
                     } else {
                         qCWarning(KSCREEN_DOCTOR) << "Wrong input: Only 'never' and 'automatic' are valid";
-                        qApp->exit(9);
-                        return;
+                        return 9;
                     }
                     m_changed = true;
                 } else if (ops.count() >= 4 && subcmd == "sharpness") {
                     const uint32_t sharpness = ops[3].toUInt();
                     if (sharpness > 100) {
                         qCWarning(KSCREEN_DOCTOR) << "Wrong input: Allowed range for sharpness is 0 to 100";
-                        qApp->exit(9);
-                        return;
+                        return 9;
                     }
                     output->setSharpness(sharpness / 100.0);
                     m_changed = true;
@@ -545,8 +614,7 @@ void Doctor::parseOutputArgs()
                             flags |= ModeInfo::Flag::ReducedBlanking;
                         } else if (ops[6] != "full") {
                             qCWarning(KSCREEN_DOCTOR) << "Invalid input: Only 'reduced' or 'full' allowed";
-                            qApp->exit(9);
-                            return;
+                            return 9;
                         }
                     }
                     modes.push_back(ModeInfo{
@@ -561,8 +629,7 @@ void Doctor::parseOutputArgs()
                     const int index = ops[3].toInt();
                     if (index < 0 || index >= modes.size()) {
                         qCWarning(KSCREEN_DOCTOR) << "Invalid index";
-                        qApp->exit(9);
-                        return;
+                        return 9;
                     }
                     modes.erase(modes.begin() + index);
                     output->setCustomModes(modes);
@@ -574,8 +641,7 @@ void Doctor::parseOutputArgs()
                         output->setAutomaticBrightness(false);
                     } else {
                         qCWarning(KSCREEN_DOCTOR) << "Invalid input: Only 'enable' and 'disable' are allowed";
-                        qApp->exit(9);
-                        return;
+                        return 9;
                     }
                     m_changed = true;
                 } else if (ops.count() == 4 && subcmd == "autoRotatePolicy") {
@@ -587,27 +653,25 @@ void Doctor::parseOutputArgs()
                         setAutoRotatePolicy(output, KScreen::Output::AutoRotatePolicy::Always);
                     } else {
                         qCWarning(KSCREEN_DOCTOR) << "Invalid input: Only 'never', 'inTabletMode', and 'always' are allowed";
-                        qApp->exit(9);
-                        return;
+                        return 9;
                     }
                 } else if (ops.count() >= 4 && subcmd == "abm") {
                     bool ok = false;
                     const uint32_t level = ops[3].toUInt(&ok);
                     if (level >= 5 || !ok) {
                         qCWarning(KSCREEN_DOCTOR) << "Invalid input: Allowed values for abm level are 0, 1, 2, 3, 4";
-                        qApp->exit(9);
-                        return;
+                        return 9;
                     }
                     output->setAbmLevel(level);
                     m_changed = true;
                 } else {
                     cerr << "Unable to parse arguments: " << op << Qt::endl;
-                    qApp->exit(2);
-                    return;
+                    return 2;
                 }
             }
         }
     }
+    return 0;
 }
 
 void Doctor::configReceived(KScreen::ConfigOperation *op)
@@ -627,8 +691,38 @@ void Doctor::configReceived(KScreen::ConfigOperation *op)
         showOutputs();
         qApp->quit();
     }
+    if (m_parser->isSet(QStringLiteral("batch"))) {
+        qApp->exit(runBatch(m_parser->value(QStringLiteral("batch"))));
+        return;
+    }
+    if (m_parser->isSet(QStringLiteral("watch"))) {
+        watch();
+        return;
+    }
+    if (m_parser->isSet(QStringLiteral("profile"))) {
+        qApp->exit(applyProfile(m_parser->value(QStringLiteral("profile"))));
+        return;
+    }
+    if (m_parser->isSet(QStringLiteral("save-profile"))) {
+        qApp->exit(saveProfile(m_parser->value(QStringLiteral("save-profile"))));
+        return;
+    }
+    if (m_parser->isSet(QStringLiteral("bench"))) {
+        bool ok = false;
+        const int iterations = m_parser->value(QStringLiteral("bench")).toInt(&ok);
+        if (!ok || iterations < 1) {
+            cerr << "Invalid number of iterations: " << m_parser->value(QStringLiteral("bench")) << Qt::endl;
+            qApp->exit(2);
+            return;
+        }
+        qApp->exit(runBenchmark(iterations));
+        return;
+    }
 
-    parseOutputArgs();
+    if (const int error = parseOutputArgs(m_outputArgs)) {
+        qApp->exit(error);
+        return;
+    }
 
     const auto ret = applyConfig();
     if (!ret.has_value()) {
@@ -942,6 +1036,59 @@ void Doctor::showJson() const
     cout << doc.toJson(QJsonDocument::Indented);
 }
 
+void Doctor::watch()
+{
+    ConfigMonitor::instance()->addConfig(m_config);
+    ConfigMonitor::instance()->subscribe(-1, ConfigMonitor::OutputChange::All, this, [this](const OutputPtr &output, ConfigMonitor::OutputChanges changes) {
+        recordChanges(output, changes);
+    });
+    // Nothing is known yet, so the first line describes every output completely
+    for (const OutputPtr &output : m_config->outputs()) {
+        recordChanges(output, ConfigMonitor::OutputChange::All);
+    }
+}
+
+void Doctor::recordChanges(const OutputPtr &output, ConfigMonitor::OutputChanges changes)
+{
+    // The monitor reports each output separately, print them together once it is done
+    if (m_watchedChanges.isEmpty()) {
+        QMetaObject::invokeMethod(this, &Doctor::printChanges, Qt::QueuedConnection);
+    }
+
+    QJsonObject &outputChanges = m_watchedChanges[output->id()];
+    if (changes & ConfigMonitor::OutputChange::Removed) {
+        outputChanges = QJsonObject{{QStringLiteral("id"), output->id()}, {QStringLiteral("removed"), true}};
+        return;
+    }
+    // Only the groups that changed are serialized, the mode list only when it did.
+    // A hotplugged output has no earlier state to differ from, so all of it is new.
+    const ConfigMonitor::OutputChanges groups = changes & ConfigMonitor::OutputChange::Added ? ConfigMonitor::OutputChanges(ConfigMonitor::OutputChange::All) : changes;
+    const QJsonObject current = KScreen::ConfigSerializer::serializeOutput(output, groups);
+    for (auto it = current.begin(); it != current.end(); ++it) {
+        outputChanges.insert(it.key(), it.value());
+    }
+    outputChanges.insert(QStringLiteral("name"), output->name());
+}
+
+void Doctor::printChanges()
+{
+    QJsonArray outputs;
+    for (const QJsonObject &outputChanges : std::as_const(m_watchedChanges)) {
+        outputs.append(outputChanges);
+    }
+    m_watchedChanges.clear();
+    if (outputs.isEmpty()) {
+        return;
+    }
+
+    const QJsonObject change{
+        {QStringLiteral("timestamp"), QDateTime::currentMSecsSinceEpoch()},
+        {QStringLiteral("generation"), qint64(m_config->generation())},
+        {QStringLiteral("outputs"), outputs},
+    };
+    cout << QJsonDocument(change).toJson(QJsonDocument::Compact) << Qt::endl;
+}
+
 void Doctor::setEnabled(OutputPtr output, bool enable)
 {
     cout << (enable ? "Enabling " : "Disabling ") << "output " << output->id() << Qt::endl;
@@ -1047,6 +1194,233 @@ void Doctor::setAutoRotatePolicy(OutputPtr output, KScreen::Output::AutoRotatePo
     m_changed = true;
 }
 
+int Doctor::runBatch(const QString &path)
+{
+    QFile file(path);
+    const bool opened = path == QLatin1String("-") ? file.open(stdin, QIODevice::ReadOnly) : file.open(QIODevice::ReadOnly);
+    if (!opened) {
+        cerr << "Unable to open " << path << ": " << file.errorString() << Qt::endl;
+        return 1;
+    }
+
+    // Follows the backend, also changes made by others, so every line starts from the current state
+    const KScreen::ConfigPtr liveConfig = m_config;
+    ConfigMonitor::instance()->addConfig(liveConfig);
+
+    int lineNumber = 0;
+    int failures = 0;
+    while (true) {
+        // Blocks until the next line arrives when reading from a pipe
+        const QByteArray line = file.readLine();
+        if (line.isEmpty()) {
+            break;
+        }
+        ++lineNumber;
+
+        const QString commands = QString::fromUtf8(line).trimmed();
+        if (commands.isEmpty() || commands.startsWith(QLatin1Char('#'))) {
+            continue;
+        }
+
+        // Let the monitor catch up with whatever happened while waiting for input
+        QCoreApplication::processEvents();
+
+        QElapsedTimer timer;
+        timer.start();
+
+        // A line is applied in one go, or not at all
+        m_config = liveConfig->clone();
+        m_changed = false;
+        if (const int error = parseOutputArgs(QProcess::splitCommand(commands))) {
+            cout << lineNumber << " error " << error << Qt::endl;
+            ++failures;
+            continue;
+        }
+        if (const auto ret = applyConfig(); !ret.has_value()) {
+            cout << lineNumber << " error 1 " << ret.error() << Qt::endl;
+            ++failures;
+            continue;
+        }
+        cout << lineNumber << " ok " << QString::number(timer.nsecsElapsed() / 1'000'000.0, 'f', 3) << "ms" << Qt::endl;
+    }
+
+    ConfigMonitor::instance()->removeConfig(liveConfig);
+    m_config = liveConfig;
+    return failures == 0 ? 0 : 1;
+}
+
+int Doctor::saveProfile(const QString &name)
+{
+    if (const int error = parseOutputArgs(m_outputArgs)) {
+        return error;
+    }
+
+    QList<ProfileOutput> outputs;
+    for (const OutputPtr &output : m_config->outputs()) {
+        if (!output->isConnected()) {
+            continue;
+        }
+        ProfileOutput entry{
+            .uuid = output->uuid(),
+            .name = output->name(),
+            .enabled = output->isEnabled(),
+            .priority = output->priority(),
+            .position = output->pos(),
+            .scale = output->scale(),
+            .rotation = output->rotation(),
+        };
+        if (const ModePtr mode = output->currentMode()) {
+            entry.modeId = mode->id();
+            entry.modeSize = mode->size();
+            entry.modeRefreshRate = qRound(mode->refreshRate() * 1000);
+        }
+        outputs.append(entry);
+    }
+
+    auto profiles = readProfiles();
+    if (!profiles) {
+        cerr << "Unable to read profiles: " << profiles.error() << Qt::endl;
+        return 1;
+    }
+    profiles->insert(name, outputs);
+    if (const auto ret = writeProfiles(*profiles); !ret) {
+        cerr << "Unable to save profile: " << ret.error() << Qt::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int Doctor::applyProfile(const QString &name)
+{
+    const auto profiles = readProfiles();
+    if (!profiles) {
+        cerr << "Unable to read profiles: " << profiles.error() << Qt::endl;
+        return 1;
+    }
+    const auto profile = profiles->constFind(name);
+    if (profile == profiles->cend()) {
+        cerr << "No profile named " << name << Qt::endl;
+        return 1;
+    }
+
+    // Backends without uuids still have unique names
+    QHash<QString, OutputPtr> outputs;
+    for (const OutputPtr &output : m_config->outputs()) {
+        outputs.insert(output->uuid().isEmpty() ? output->name() : output->uuid(), output);
+    }
+
+    for (const ProfileOutput &entry : *profile) {
+        OutputPtr output = outputs.value(entry.uuid.isEmpty() ? entry.name : entry.uuid);
+        if (!output) {
+            cerr << "Output " << entry.name << " of profile " << name << " is not connected" << Qt::endl;
+            return 8;
+        }
+        output->setEnabled(entry.enabled);
+        output->setPriority(entry.priority);
+        output->setPos(entry.position);
+        output->setScale(entry.scale);
+        output->setRotation(KScreen::Output::Rotation(entry.rotation));
+
+        if (entry.modeId.isEmpty()) {
+            continue;
+        }
+        ModePtr mode = output->mode(entry.modeId);
+        const auto matches = [&entry](const ModePtr &mode) {
+            return mode->size() == entry.modeSize && quint32(qRound(mode->refreshRate() * 1000)) == entry.modeRefreshRate;
+        };
+        if (!mode || !matches(mode)) {
+            const ModeList modes = output->modes();
+            const auto it = std::ranges::find_if(modes, matches);
+            mode = it != modes.end() ? *it : ModePtr();
+        }
+        if (!mode) {
+            cerr << "Mode of output " << entry.name << " in profile " << name << " is not available" << Qt::endl;
+            return 9;
+        }
+        output->setCurrentModeId(mode->id());
+    }
+
+    m_changed = true;
+    if (const auto ret = applyConfig(); !ret) {
+        cerr << "applying profile failed! " << ret.error() << Qt::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int Doctor::runBenchmark(int iterations)
+{
+    const KScreen::ConfigPtr original = m_config->clone();
+    m_changed = false;
+    if (const int error = parseOutputArgs(m_outputArgs)) {
+        return error;
+    }
+    if (!m_changed) {
+        cerr << "Nothing to benchmark, pass the settings to apply" << Qt::endl;
+        return 2;
+    }
+    const KScreen::ConfigPtr changed = m_config;
+
+    std::vector<qint64> samples;
+    samples.reserve(iterations);
+    const quint64 requestsBefore = Metrics::count(Metrics::Counter::ProtocolRequests);
+    const quint64 rebuildsBefore = Metrics::count(Metrics::Counter::ConfigRebuilds);
+
+    // Alternates between the changed and the original config, so every iteration changes something
+    for (int i = 0; i < iterations; ++i) {
+        const KScreen::ConfigPtr target = (i % 2 == 0 ? changed : original)->clone();
+
+        QEventLoop loop;
+        bool reported = false;
+        const auto connection = connect(ConfigMonitor::instance(), &ConfigMonitor::configurationChanged, &loop, [&loop, &reported]() {
+            reported = true;
+            loop.quit();
+        });
+
+        QElapsedTimer timer;
+        timer.start();
+        auto setop = new SetConfigOperation(target, this);
+        if (!setop->exec()) {
+            cerr << "Applying failed in iteration " << i + 1 << ": " << setop->errorString() << Qt::endl;
+            return 1;
+        }
+        // Backends may report the change before or after the operation finished
+        if (!reported) {
+            QTimer::singleShot(5s, &loop, &QEventLoop::quit);
+            loop.exec();
+        }
+        disconnect(connection);
+        if (!reported) {
+            cerr << "The change of iteration " << i + 1 << " was never reported" << Qt::endl;
+            return 1;
+        }
+        samples.push_back(timer.nsecsElapsed());
+    }
+
+    const double requests = double(Metrics::count(Metrics::Counter::ProtocolRequests) - requestsBefore) / iterations;
+    const double rebuilds = double(Metrics::count(Metrics::Counter::ConfigRebuilds) - rebuildsBefore) / iterations;
+
+    // Leave the outputs the way they were found
+    if (iterations % 2 != 0) {
+        auto setop = new SetConfigOperation(original->clone(), this);
+        if (!setop->exec()) {
+            cerr << "Restoring the original configuration failed: " << setop->errorString() << Qt::endl;
+        }
+    }
+
+    std::ranges::sort(samples);
+    const auto milliseconds = [](qint64 nsecs) {
+        return QString::number(nsecs / 1'000'000.0, 'f', 3);
+    };
+    const qsizetype p99 = std::max<qsizetype>(0, qsizetype(std::ceil(samples.size() * 0.99)) - 1);
+    cout << "iterations: " << iterations << Qt::endl;
+    cout << "latency: min " << milliseconds(samples.front()) << "ms, median " << milliseconds(samples[samples.size() / 2]) << "ms, p99 "
+         << milliseconds(samples[p99]) << "ms" << Qt::endl;
+    cout << "per iteration: " << QString::number(requests, 'f', 1) << " protocol requests, " << QString::number(rebuilds, 'f', 1) << " config rebuilds"
+         << Qt::endl;
+    return 0;
+}
+
 std::expected<void, QString> Doctor::applyConfig()
 {
     if (!m_changed) {
@@ -7,9 +7,12 @@
 #pragma once
 
 #include <QCommandLineParser>
+#include <QHash>
+#include <QJsonObject>
 #include <QObject>
 #include <expected>
 
+#include "configmonitor.h"
 #include "output.h"
 #include "types.h"
 
@@ -34,6 +37,7 @@ public:
 
     void showOutputs() const;
     void showJson() const;
+    void watch();
 
     void setEnabled(OutputPtr output, bool enable = true);
     void setPosition(OutputPtr output, const QPoint &pos);
@@ -58,12 +62,20 @@ Q_SIGNALS:
 private:
     // static QString modeString(KWayland::Server::OutputDeviceInterface* outputdevice, int mid);
     std::expected<void, QString> applyConfig();
-    void parseOutputArgs();
+    int parseOutputArgs(const QStringList &args);
+    int runBatch(const QString &path);
+    int runBenchmark(int iterations);
+    int saveProfile(const QString &name);
+    int applyProfile(const QString &name);
+    void recordChanges(const OutputPtr &output, KScreen::ConfigMonitor::OutputChanges changes);
+    void printChanges();
     KScreen::ConfigPtr m_config;
     QCommandLineParser *m_parser;
     bool m_changed;
     QStringList m_outputArgs;
     Dpms *m_dpmsClient;
+    // What --watch prints next, by output id
+    QHash<int, QJsonObject> m_watchedChanges;
 };
 
 } // namespace
@@ -76,7 +76,16 @@ int main(int argc, char **argv)
         "   Add a custom mode: (arguments: width,height,refresh rate in mHz,blanking 'reduced' or 'full')\n"
         "   $ kscreen-doctor output.1.addCustomMode.1920.1080.75000.full\n"
         "   Remove a custom mode: (arguments: index in the custom mode list)\n"
-        "   $ kscreen-doctor output.1.removeCustomMode.0");
+        "   $ kscreen-doctor output.1.removeCustomMode.0\n"
+        "\n   Apply settings read line by line from stdin, each line in one go, and report the time it took\n"
+        "   $ printf 'output.HDMI-2.scale.2\\noutput.HDMI-2.scale.1 output.eDP-1.disable\\n' | kscreen-doctor --batch -\n"
+        "\n   Print a line of JSON with the changed properties of each output whenever the configuration changes\n"
+        "   $ kscreen-doctor --watch\n"
+        "\n   Measure how long it takes until a change is reported, alternating between two scales 20 times\n"
+        "   $ kscreen-doctor --bench 20 output.HDMI-2.scale.2\n"
+        "\n   Save the current setup, with the given settings changed, as a profile and apply it later\n"
+        "   $ kscreen-doctor --save-profile docked output.eDP-1.disable output.HDMI-2.priority.1\n"
+        "   $ kscreen-doctor --profile docked");
     /*
         "\nError codes:\n"
         "   2 : general parse error\n"
@@ -104,6 +113,20 @@ int main(int argc, char **argv)
     QCommandLineOption outputs = QCommandLineOption(QStringList() << QStringLiteral("o") << QStringLiteral("outputs"), QStringLiteral("Show outputs"));
     QCommandLineOption json =
         QCommandLineOption(QStringList() << QStringLiteral("j") << QStringLiteral("json"), QStringLiteral("Show configuration in JSON format"));
+    QCommandLineOption batch = QCommandLineOption(QStringList() << QStringLiteral("b") << QStringLiteral("batch"),
+                                                  QStringLiteral("Apply the settings on each line of a file, - for stdin"),
+                                                  QStringLiteral("file"));
+    QCommandLineOption watch = QCommandLineOption(QStringList() << QStringLiteral("w") << QStringLiteral("watch"),
+                                                  QStringLiteral("Print changes as they happen, one JSON object per line"));
+    QCommandLineOption bench = QCommandLineOption(QStringList() << QStringLiteral("bench"),
+                                                  QStringLiteral("Apply the settings and revert them, the given number of times in total, and show how long it took"),
+                                                  QStringLiteral("iterations"));
+    QCommandLineOption profile = QCommandLineOption(QStringList() << QStringLiteral("p") << QStringLiteral("profile"),
+                                                    QStringLiteral("Apply a profile saved with --save-profile"),
+                                                    QStringLiteral("name"));
+    QCommandLineOption saveProfile = QCommandLineOption(QStringList() << QStringLiteral("save-profile"),
+                                                        QStringLiteral("Save the setup with the given settings changed as a profile, without applying it"),
+                                                        QStringLiteral("name"));
     QCommandLineOption dpms = QCommandLineOption(QStringList() << QStringLiteral("d") << QStringLiteral("dpms"),
                                                  QStringLiteral("Display power management (wayland only)"),
                                                  QStringLiteral("off"));
@@ -115,6 +138,11 @@ int main(int argc, char **argv)
     parser.addOption(json);
     parser.addOption(outputs);
     parser.addOption(dpms);
+    parser.addOption(batch);
+    parser.addOption(watch);
+    parser.addOption(bench);
+    parser.addOption(profile);
+    parser.addOption(saveProfile);
     parser.process(app);
 
     if (!parser.positionalArguments().isEmpty()) {
@@ -7,6 +7,7 @@
 
 #include "edid.h"
 #include "kscreen_debug_edid.h"
+#include "trace_p.h"
 
 #include <math.h>
 
@@ -243,6 +244,8 @@ QByteArray Edid::rawData() const
 
 bool Edid::Private::parse(const QByteArray &rawData_)
 {
+    Trace::Span span("Edid::parse");
+
     quint32 serial;
     const quint8 *data = reinterpret_cast<const quint8 *>(rawData_.constData());
     int length = rawData_.length();
@@ -6,10 +6,13 @@
  */
 
 #include "getconfigoperation.h"
+#include "abstractbackend.h"
 #include "backendmanager_p.h"
 #include "config.h"
 #include "configoperation_p.h"
+#include "kscreen_debug.h"
 #include "output.h"
+#include "trace_p.h"
 
 using namespace KScreen;
 
@@ -25,7 +28,6 @@ public:
 public:
     GetConfigOperation::Options options;
     ConfigPtr config;
-    void loadEdid(KScreen::AbstractBackend *backend);
 
 private:
     Q_DECLARE_PUBLIC(GetConfigOperation)
@@ -57,31 +59,73 @@ KScreen::ConfigPtr GetConfigOperation::config() const
 void GetConfigOperation::start()
 {
     Q_D(GetConfigOperation);
+    const qint64 start = Trace::timestamp();
     auto backend = d->loadBackend();
     if (!backend) {
         return; // loadBackend() already set error and called emitResult() for us
     }
-    d->config = backend->config()->clone();
-    d->loadEdid(backend);
-    emitResult();
+
+    auto finish = [this, start](const ConfigPtr &config) {
+        Q_D(GetConfigOperation);
+        Trace::complete("GetConfigOperation", start);
+        if (!config) {
+            setError(QStringLiteral("Backend failed to provide a valid configuration"));
+        }
+        d->config = config;
+        emitResult();
+    };
+
+    const QFuture<ConfigPtr> pendingConfig = KScreen::getConfig(d->options);
+    if (pendingConfig.isFinished()) {
+        finish(pendingConfig.result());
+        return;
+    }
+    pendingConfig.then(this, finish);
 }
 
-void GetConfigOperationPrivate::loadEdid(KScreen::AbstractBackend *backend)
+static ConfigPtr currentConfig(ConfigOperation::Options options)
 {
-    if (options & KScreen::ConfigOperation::NoEDID) {
-        return;
+    const ConfigPtr snapshot = BackendManager::instance()->snapshot(options);
+    if (!snapshot) {
+        qCWarning(KSCREEN) << "Backend failed to provide a valid configuration";
+        return ConfigPtr();
     }
-    if (!config) {
-        return;
+    // The snapshot is shared, so only hand it out to callers promising not to modify it
+    return options.testFlag(ConfigOperation::ReadOnly) ? snapshot : snapshot->clone();
+}
+
+QFuture<ConfigPtr> KScreen::getConfig(ConfigOperation::Options options)
+{
+    BackendManager *manager = BackendManager::instance();
+    if (options.testFlag(ConfigOperation::AllowCached)) {
+        manager->setConfigCacheEnabled(true);
+    }
+    AbstractBackend *backend = manager->loadBackendInProcess();
+    if (!backend) {
+        return QtFuture::makeReadyValueFuture(ConfigPtr());
     }
-    auto outputs = config->outputs();
-    for (auto it = outputs.begin(); it != outputs.end(); ++it) {
-        auto output = *it;
-        if (output->edid() == nullptr) {
-            const QByteArray edidData = backend->edid(output->id());
-            output->setEdid(edidData);
+
+    const QFuture<void> ready = backend->ready();
+    if (ready.isFinished()) {
+        return QtFuture::makeReadyValueFuture(currentConfig(options));
+    }
+
+    if (options.testFlag(ConfigOperation::AllowCached)) {
+        if (const ConfigPtr cached = manager->cachedConfig()) {
+            return QtFuture::makeReadyValueFuture(cached);
         }
     }
+
+    // Let a backend still talking to the system finish that first, without blocking the caller
+    return ready
+        .then(manager,
+              [options]() {
+                  return currentConfig(options);
+              })
+        .onCanceled(manager, []() {
+            qCWarning(KSCREEN) << "Backend went away before it finished initializing";
+            return ConfigPtr();
+        });
 }
 
 #include "getconfigoperation.moc"
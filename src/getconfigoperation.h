@@ -11,6 +11,8 @@
 #include "kscreen_export.h"
 #include "types.h"
 
+#include <QFuture>
+
 namespace KScreen
 {
 class GetConfigOperationPrivate;
@@ -31,4 +33,21 @@ protected:
 private:
     Q_DECLARE_PRIVATE(GetConfigOperation)
 };
+
+/**
+ * Fetches the current configuration.
+ *
+ * Unlike GetConfigOperation this does not go through the event loop: the
+ * returned future is already finished when the backend state is known, which
+ * is always the case once the backend is running. A backend initializing
+ * asynchronously (see AbstractBackend::ready()) resolves it once it is done,
+ * unless ConfigOperation::AllowCached is passed and a cached config exists.
+ * It can be chained with QFuture::then() or awaited with a coroutine library
+ * such as QCoro.
+ *
+ * @param options see ConfigOperation::Option
+ * @return future holding the config, or a null pointer if there is no valid config
+ * @since 6.8
+ */
+KSCREEN_EXPORT QFuture<KScreen::ConfigPtr> getConfig(KScreen::ConfigOperation::Options options = KScreen::ConfigOperation::NoOptions);
 }
@@ -0,0 +1,386 @@
+/*
+ *  SPDX-FileCopyrightText: 2026 KScreen contributors
+ *
+ *  SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "layoutstore.h"
+
+#include "config.h"
+#include "configserializer_p.h"
+#include "kscreen_debug.h"
+#include "mode.h"
+#include "output.h"
+#include "trace_p.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QMap>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtEndian>
+
+#include <algorithm>
+#include <span>
+
+#include <sys/stat.h>
+
+using namespace KScreen;
+
+namespace
+{
+// The file is only shared between processes of one machine, so it uses the native byte order
+struct Header {
+    quint32 magic;
+    quint32 version;
+    quint32 count;
+    quint32 reserved;
+};
+
+// Sorted by fingerprint, followed by the layouts they point to
+struct Entry {
+    quint64 fingerprint;
+    quint32 offset;
+    quint32 size;
+};
+
+static_assert(sizeof(Header) == 16);
+static_assert(sizeof(Entry) == 16);
+
+constexpr quint32 s_magic = 0x534c534b; // "KSLS"
+constexpr quint32 s_version = 1;
+}
+
+class Q_DECL_HIDDEN LayoutStore::Private
+{
+public:
+    explicit Private(const QString &path)
+        : path(path)
+        , file(path)
+    {
+    }
+
+    bool update();
+    std::span<const Entry> entries() const;
+    const Entry *entry(quint64 fingerprint);
+    QByteArray find(quint64 fingerprint);
+    QMap<quint64, QByteArray> readAll();
+    bool write(const QMap<quint64, QByteArray> &layouts);
+    void unmap();
+
+    const QString path;
+    QFile file;
+    uchar *data = nullptr;
+    qint64 size = 0;
+    // Saving replaces the file, so a new inode means new contents
+    ino_t inode = 0;
+    qint64 modified = 0;
+};
+
+bool LayoutStore::Private::update()
+{
+    struct stat info;
+    if (::stat(QFile::encodeName(path).constData(), &info) != 0) {
+        unmap();
+        return false;
+    }
+    const qint64 mtime = qint64(info.st_mtim.tv_sec) * 1'000'000'000 + info.st_mtim.tv_nsec;
+    if (data && info.st_ino == inode && mtime == modified && info.st_size == size) {
+        return true;
+    }
+
+    unmap();
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCWarning(KSCREEN) << "Cannot open layout store" << path << file.errorString();
+        return false;
+    }
+    size = file.size();
+    if (size < qint64(sizeof(Header))) {
+        qCWarning(KSCREEN) << "Layout store" << path << "is truncated";
+        unmap();
+        return false;
+    }
+    data = file.map(0, size);
+    if (!data) {
+        qCWarning(KSCREEN) << "Cannot map layout store" << path << file.errorString();
+        unmap();
+        return false;
+    }
+
+    const auto header = reinterpret_cast<const Header *>(data);
+    if (header->magic != s_magic || header->version != s_version || sizeof(Header) + quint64(header->count) * sizeof(Entry) > quint64(size)) {
+        qCWarning(KSCREEN) << "Layout store" << path << "has an unsupported format";
+        unmap();
+        return false;
+    }
+    inode = info.st_ino;
+    modified = mtime;
+    return true;
+}
+
+void LayoutStore::Private::unmap()
+{
+    if (data) {
+        file.unmap(data);
+        data = nullptr;
+    }
+    file.close();
+    size = 0;
+    inode = 0;
+    modified = 0;
+}
+
+std::span<const Entry> LayoutStore::Private::entries() const
+{
+    if (!data) {
+        return {};
+    }
+    const auto header = reinterpret_cast<const Header *>(data);
+    return std::span(reinterpret_cast<const Entry *>(data + sizeof(Header)), header->count);
+}
+
+const Entry *LayoutStore::Private::entry(quint64 fingerprint)
+{
+    if (!update()) {
+        return nullptr;
+    }
+    const auto index = entries();
+    const auto it = std::ranges::lower_bound(index, fingerprint, {}, &Entry::fingerprint);
+    if (it == index.end() || it->fingerprint != fingerprint) {
+        return nullptr;
+    }
+    if (quint64(it->offset) + it->size > quint64(size)) {
+        qCWarning(KSCREEN) << "Layout store" << path << "is truncated";
+        return nullptr;
+    }
+    return &*it;
+}
+
+QByteArray LayoutStore::Private::find(quint64 fingerprint)
+{
+    const Entry *found = entry(fingerprint);
+    if (!found) {
+        return QByteArray();
+    }
+    return QByteArray(reinterpret_cast<const char *>(data + found->offset), found->size);
+}
+
+QMap<quint64, QByteArray> LayoutStore::Private::readAll()
+{
+    QMap<quint64, QByteArray> layouts;
+    if (!update()) {
+        return layouts;
+    }
+    for (const Entry &entry : entries()) {
+        if (quint64(entry.offset) + entry.size <= quint64(size)) {
+            layouts.insert(entry.fingerprint, QByteArray(reinterpret_cast<const char *>(data + entry.offset), entry.size));
+        }
+    }
+    return layouts;
+}
+
+bool LayoutStore::Private::write(const QMap<quint64, QByteArray> &layouts)
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    // Readers keep their mapping of the replaced file, so it never changes underneath them
+    QSaveFile out(path);
+    if (!out.open(QIODevice::WriteOnly)) {
+        qCWarning(KSCREEN) << "Cannot write layout store" << path << out.errorString();
+        return false;
+    }
+
+    const Header header{
+        .magic = s_magic,
+        .version = s_version,
+        .count = quint32(layouts.size()),
+        .reserved = 0,
+    };
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    // QMap iterates in key order, which keeps the index sorted
+    quint32 offset = sizeof(Header) + layouts.size() * sizeof(Entry);
+    for (auto it = layouts.cbegin(); it != layouts.cend(); ++it) {
+        const Entry entry{
+            .fingerprint = it.key(),
+            .offset = offset,
+            .size = quint32(it.value().size()),
+        };
+        out.write(reinterpret_cast<const char *>(&entry), sizeof(entry));
+        offset += entry.size;
+    }
+    for (const QByteArray &layout : layouts) {
+        out.write(layout);
+    }
+
+    if (!out.commit()) {
+        qCWarning(KSCREEN) << "Cannot write layout store" << path << out.errorString();
+        return false;
+    }
+    unmap();
+    return true;
+}
+
+LayoutStore::LayoutStore(const QString &path)
+    : d(new Private(path))
+{
+}
+
+LayoutStore::~LayoutStore()
+{
+    d->unmap();
+    delete d;
+}
+
+QString LayoutStore::defaultPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + QStringLiteral("/kscreen/layouts");
+}
+
+QString LayoutStore::path() const
+{
+    return d->path;
+}
+
+quint64 LayoutStore::fingerprint(const ConfigPtr &config)
+{
+    QList<QString> hashes;
+    for (const OutputPtr &output : config->outputs()) {
+        if (output->isConnected()) {
+            hashes.append(output->hashMd5());
+        }
+    }
+    std::ranges::sort(hashes);
+
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    for (const QString &outputHash : std::as_const(hashes)) {
+        hash.addData(outputHash.toLatin1());
+        hash.addData(QByteArrayView(","));
+    }
+    return qFromLittleEndian<quint64>(hash.result().constData());
+}
+
+bool LayoutStore::contains(quint64 fingerprint) const
+{
+    return d->entry(fingerprint) != nullptr;
+}
+
+QList<quint64> LayoutStore::fingerprints() const
+{
+    QList<quint64> fingerprints;
+    if (d->update()) {
+        for (const Entry &entry : d->entries()) {
+            fingerprints.append(entry.fingerprint);
+        }
+    }
+    return fingerprints;
+}
+
+bool LayoutStore::save(const ConfigPtr &config)
+{
+    QJsonArray outputs;
+    for (const OutputPtr &output : config->outputs()) {
+        if (!output->isConnected()) {
+            continue;
+        }
+        QJsonObject object = ConfigSerializer::serializeOutput(output);
+        // Ids and the available modes belong to the running backend, not to the layout
+        object.remove(QLatin1String("id"));
+        object.remove(QLatin1String("modes"));
+        object.remove(QLatin1String("clones"));
+        object.remove(QLatin1String("replicationSource"));
+        object[QLatin1String("hash")] = output->hashMd5();
+        if (const ModePtr mode = output->currentMode()) {
+            object[QLatin1String("mode")] = ConfigSerializer::serializeMode(mode);
+        }
+        outputs.append(object);
+    }
+
+    QMap<quint64, QByteArray> layouts = d->readAll();
+    layouts.insert(fingerprint(config), QJsonDocument(QJsonObject{{QLatin1String("outputs"), outputs}}).toJson(QJsonDocument::Compact));
+    return d->write(layouts);
+}
+
+static ModePtr findMode(const OutputPtr &output, const QJsonObject &object)
+{
+    const QJsonObject size = object[QLatin1String("size")].toObject();
+    const QSize modeSize(size[QLatin1String("width")].toInt(), size[QLatin1String("height")].toInt());
+    const double refreshRate = object[QLatin1String("refreshRate")].toDouble();
+    const auto matches = [&modeSize, refreshRate](const ModePtr &mode) {
+        return mode->size() == modeSize && qAbs(mode->refreshRate() - refreshRate) < 0.01;
+    };
+
+    // Mode ids often survive, so try that before looking through all modes
+    if (const ModePtr mode = output->mode(object[QLatin1String("id")].toString()); mode && matches(mode)) {
+        return mode;
+    }
+    const ModeList modes = output->modes();
+    const auto it = std::ranges::find_if(modes, matches);
+    return it != modes.end() ? *it : ModePtr();
+}
+
+bool LayoutStore::restore(const ConfigPtr &config) const
+{
+    Trace::Span span("LayoutStore::restore");
+
+    const QByteArray layout = d->find(fingerprint(config));
+    if (layout.isNull()) {
+        return false;
+    }
+    QJsonParseError error;
+    const QJsonDocument document = QJsonDocument::fromJson(layout, &error);
+    if (error.error != QJsonParseError::NoError) {
+        qCWarning(KSCREEN) << "Ignoring corrupt layout in" << d->path << error.errorString();
+        return false;
+    }
+
+    // The same monitor model may be connected more than once, those are told apart by connector
+    OutputList candidates;
+    for (const OutputPtr &output : config->outputs()) {
+        if (output->isConnected()) {
+            candidates.insert(output->id(), output);
+        }
+    }
+    const QJsonArray outputs = document[QLatin1String("outputs")].toArray();
+    for (const QJsonValue &value : outputs) {
+        const QJsonObject object = value.toObject();
+        const QString hash = object[QLatin1String("hash")].toString();
+        const QString name = object[QLatin1String("name")].toString();
+        auto it = std::ranges::find_if(candidates, [&hash, &name](const OutputPtr &output) {
+            return output->hashMd5() == hash && output->name() == name;
+        });
+        if (it == candidates.end()) {
+            it = std::ranges::find_if(candidates, [&hash](const OutputPtr &output) {
+                return output->hashMd5() == hash;
+            });
+        }
+        if (it == candidates.end()) {
+            continue;
+        }
+        const OutputPtr output = *it;
+        candidates.erase(it);
+
+        output->setEnabled(object[QLatin1String("enabled")].toBool());
+        output->setPriority(object[QLatin1String("priority")].toInt());
+        const QJsonObject pos = object[QLatin1String("pos")].toObject();
+        output->setPos(QPoint(pos[QLatin1String("x")].toInt(), pos[QLatin1String("y")].toInt()));
+        output->setScale(object[QLatin1String("scale")].toDouble(1.0));
+        output->setRotation(Output::Rotation(object[QLatin1String("rotation")].toInt(Output::None)));
+        if (const ModePtr mode = findMode(output, object[QLatin1String("mode")].toObject())) {
+            output->setCurrentModeId(mode->id());
+        }
+    }
+    return true;
+}
+
+bool LayoutStore::remove(quint64 fingerprint)
+{
+    QMap<quint64, QByteArray> layouts = d->readAll();
+    if (!layouts.remove(fingerprint)) {
+        return false;
+    }
+    return d->write(layouts);
+}
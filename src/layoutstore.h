@@ -0,0 +1,80 @@
+/*
+ *  SPDX-FileCopyrightText: 2026 KScreen contributors
+ *
+ *  SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include <QList>
+#include <QString>
+
+#include "kscreen_export.h"
+#include "types.h"
+
+namespace KScreen
+{
+/**
+ * @brief Layouts saved per set of connected outputs.
+ *
+ * A layout holds the enabled state, priority, position, scale, rotation and
+ * mode of every connected output. It is stored under the fingerprint of the
+ * connected outputs, so e.g. the docked and undocked setup of a laptop each
+ * get their own layout.
+ *
+ * All layouts live in one file that starts with a sorted index of the
+ * fingerprints. The file is memory mapped, so finding the layout for a config
+ * is a binary search that needs no parsing. Only the layout found is parsed.
+ * Changes made by other processes are picked up on the next lookup.
+ *
+ * @since 6.8
+ */
+class KSCREEN_EXPORT LayoutStore
+{
+public:
+    /**
+     * Uses the layouts in the file at @p path, which is created on the first
+     * save.
+     */
+    explicit LayoutStore(const QString &path = defaultPath());
+    ~LayoutStore();
+
+    /**
+     * The file shared by all users of the default store.
+     */
+    static QString defaultPath();
+
+    QString path() const;
+
+    /**
+     * Identifies the set of connected outputs of @p config, regardless of
+     * their order and state. Outputs are told apart by their EDID, or by name
+     * without one.
+     */
+    static quint64 fingerprint(const KScreen::ConfigPtr &config);
+
+    bool contains(quint64 fingerprint) const;
+    QList<quint64> fingerprints() const;
+
+    /**
+     * Saves the layout of the connected outputs of @p config, replacing the
+     * one saved before for the same outputs.
+     */
+    bool save(const KScreen::ConfigPtr &config);
+
+    /**
+     * Changes the connected outputs of @p config to the layout saved for them.
+     * Returns false if there is none, leaving @p config untouched.
+     */
+    bool restore(const KScreen::ConfigPtr &config) const;
+
+    bool remove(quint64 fingerprint);
+
+private:
+    Q_DISABLE_COPY(LayoutStore)
+
+    class Private;
+    Private *const d;
+};
+
+}
@@ -0,0 +1,134 @@
+/*
+ *  SPDX-FileCopyrightText: 2026 KScreen contributors
+ *
+ *  SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "metrics.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <algorithm>
+#include <bit>
+
+using namespace KScreen;
+using namespace std::chrono_literals;
+
+// The first bucket ends at 1µs, so the last one starts at about 18 minutes
+static constexpr std::chrono::nanoseconds s_firstBucketBound = 1us;
+
+namespace
+{
+struct Storage {
+    QMutex mutex;
+    std::array<Metrics::Histogram, Metrics::StageCount> histograms;
+    std::array<quint64, Metrics::CounterCount> counters = {};
+};
+}
+
+Q_GLOBAL_STATIC(Storage, s_storage)
+
+quint64 Metrics::Histogram::count() const
+{
+    return m_count;
+}
+
+quint64 Metrics::Histogram::bucket(int index) const
+{
+    if (index < 0 || index >= BucketCount) {
+        return 0;
+    }
+    return m_buckets[index];
+}
+
+std::chrono::nanoseconds Metrics::Histogram::bucketUpperBound(int index)
+{
+    return s_firstBucketBound * (quint64(1) << std::clamp(index, 0, BucketCount - 1));
+}
+
+std::chrono::nanoseconds Metrics::Histogram::min() const
+{
+    return m_min;
+}
+
+std::chrono::nanoseconds Metrics::Histogram::max() const
+{
+    return m_max;
+}
+
+std::chrono::nanoseconds Metrics::Histogram::mean() const
+{
+    if (m_count == 0) {
+        return 0ns;
+    }
+    return m_sum / m_count;
+}
+
+std::chrono::nanoseconds Metrics::Histogram::percentile(double fraction) const
+{
+    if (m_count == 0) {
+        return 0ns;
+    }
+
+    const double rank = std::clamp(fraction, 0.0, 1.0) * m_count;
+    quint64 below = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        if (m_buckets[i] == 0 || below + m_buckets[i] < rank) {
+            below += m_buckets[i];
+            continue;
+        }
+        const double lower = i == 0 ? 0.0 : double(bucketUpperBound(i - 1).count());
+        const double upper = double(bucketUpperBound(i).count());
+        const double position = (rank - below) / m_buckets[i];
+        const auto estimate = std::chrono::nanoseconds(qint64(lower + (upper - lower) * position));
+        return std::clamp(estimate, m_min, m_max);
+    }
+    return m_max;
+}
+
+void Metrics::Histogram::add(std::chrono::nanoseconds duration)
+{
+    duration = std::max(duration, 0ns);
+
+    // Bucket i ends at 2^i µs
+    const quint64 units = quint64(duration / s_firstBucketBound);
+    const int index = std::min<int>(std::bit_width(units), BucketCount - 1);
+    ++m_buckets[index];
+
+    m_min = m_count == 0 ? duration : std::min(m_min, duration);
+    m_max = std::max(m_max, duration);
+    m_sum += duration;
+    ++m_count;
+}
+
+Metrics::Histogram Metrics::histogram(Stage stage)
+{
+    QMutexLocker locker(&s_storage->mutex);
+    return s_storage->histograms[int(stage)];
+}
+
+void Metrics::record(Stage stage, std::chrono::nanoseconds duration)
+{
+    QMutexLocker locker(&s_storage->mutex);
+    s_storage->histograms[int(stage)].add(duration);
+}
+
+quint64 Metrics::count(Counter counter)
+{
+    QMutexLocker locker(&s_storage->mutex);
+    return s_storage->counters[int(counter)];
+}
+
+void Metrics::increment(Counter counter, quint64 amount)
+{
+    QMutexLocker locker(&s_storage->mutex);
+    s_storage->counters[int(counter)] += amount;
+}
+
+void Metrics::reset()
+{
+    QMutexLocker locker(&s_storage->mutex);
+    s_storage->histograms.fill(Histogram());
+    s_storage->counters.fill(0);
+}
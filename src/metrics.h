@@ -0,0 +1,116 @@
+/*
+ *  SPDX-FileCopyrightText: 2026 KScreen contributors
+ *
+ *  SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include <QtGlobal>
+
+#include <array>
+#include <chrono>
+
+#include "kscreen_export.h"
+
+namespace KScreen
+{
+/**
+ * @brief Latency statistics of configuration changes in this process.
+ *
+ * The library times the stages a configuration goes through when it is
+ * applied, and how long it takes for changes reported by the backend to reach
+ * the configs watched by ConfigMonitor. Every stage has a histogram from which
+ * percentiles like the median or p99 can be read.
+ *
+ * @since 6.8
+ */
+class KSCREEN_EXPORT Metrics
+{
+public:
+    enum class Stage {
+        Preparation, ///< checks and fixups before the configuration is handed to the backend
+        Submission, ///< the backend translating the configuration into protocol requests
+        Acknowledgement, ///< requests sent until the compositor applied or rejected them
+        Propagation, ///< backend reported a change until ConfigMonitor updated the watched configs
+        Apply, ///< a SetConfigOperation from start until it finished
+        Hotplug, ///< an output was announced until the backend reported it
+        Startup, ///< the in-process backend was created until its initial state was known
+    };
+    static constexpr int StageCount = int(Stage::Startup) + 1;
+
+    enum class Counter {
+        ProtocolRequests, ///< requests the backend sent to the compositor to apply configurations
+        ConfigRebuilds, ///< configurations the backend reported, each one rebuilt from its state
+        ConfigChanges, ///< change notifications the backend sent, one for all changes of a dispatch
+    };
+    static constexpr int CounterCount = int(Counter::ConfigChanges) + 1;
+
+    /**
+     * Distribution of the durations recorded for a stage.
+     *
+     * Buckets grow exponentially: bucket @c i counts durations below
+     * bucketUpperBound(i) and at least bucketUpperBound(i - 1), the last one
+     * also counts everything longer.
+     */
+    class KSCREEN_EXPORT Histogram
+    {
+    public:
+        static constexpr int BucketCount = 32;
+
+        quint64 count() const;
+        quint64 bucket(int index) const;
+        static std::chrono::nanoseconds bucketUpperBound(int index);
+
+        std::chrono::nanoseconds min() const;
+        std::chrono::nanoseconds max() const;
+        std::chrono::nanoseconds mean() const;
+
+        /**
+         * Estimates the duration that @p fraction of the samples did not
+         * exceed, e.g. 0.5 for the median and 0.99 for p99.
+         *
+         * The estimate interpolates within the bucket and is clamped to the
+         * smallest and largest sample. Returns zero without samples.
+         */
+        std::chrono::nanoseconds percentile(double fraction) const;
+
+        void add(std::chrono::nanoseconds duration);
+
+    private:
+        std::array<quint64, BucketCount> m_buckets = {};
+        quint64 m_count = 0;
+        std::chrono::nanoseconds m_sum{0};
+        std::chrono::nanoseconds m_min{0};
+        std::chrono::nanoseconds m_max{0};
+    };
+
+    /**
+     * Returns a copy of the samples recorded for @p stage so far.
+     */
+    static Histogram histogram(Stage stage);
+
+    /**
+     * Adds a sample to @p stage. Used by the library and its backends, may be
+     * called from any thread.
+     */
+    static void record(Stage stage, std::chrono::nanoseconds duration);
+
+    /**
+     * Returns how often @p counter was incremented so far.
+     */
+    static quint64 count(Counter counter);
+
+    /**
+     * Adds @p amount to @p counter. Used by the library and its backends,
+     * may be called from any thread.
+     */
+    static void increment(Counter counter, quint64 amount = 1);
+
+    /**
+     * Forgets all samples and counts.
+     */
+    static void reset();
+};
+
+}
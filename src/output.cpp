@@ -8,6 +8,7 @@
 #include "output.h"
 #include "edid.h"
 #include "mode.h"
+#include "outputchanges_p.h"
 
 #include <QCryptographicHash>
 #include <QGuiApplication>
@@ -1176,11 +1177,21 @@ void Output::apply(const OutputPtr &other)
     }
 
     setPreferredModes(other->d->preferredModes);
+    // Modes that are still the same are kept instead of cloned, most updates don't touch them
+    bool modesReused = d->modeList.count() == other->d->modeList.count();
     ModeList modes;
-    for (const ModePtr &otherMode : other->modes()) {
-        modes.insert(otherMode->id(), otherMode->clone());
+    for (const ModePtr &otherMode : std::as_const(other->d->modeList)) {
+        const ModePtr mode = d->modeList.value(otherMode->id());
+        if (mode && mode->name() == otherMode->name() && *mode == *otherMode) {
+            modes.insert(otherMode->id(), mode);
+        } else {
+            modes.insert(otherMode->id(), otherMode->clone());
+            modesReused = false;
+        }
+    }
+    if (!modesReused) {
+        setModes(modes);
     }
-    setModes(modes);
 
     if (d->capabilities != other->d->capabilities) {
         changes << &Output::capabilitiesChanged;
@@ -1352,4 +1363,62 @@ QDebug operator<<(QDebug dbg, const KScreen::OutputPtr &output)
     return dbg;
 }
 
+void KScreen::applyOutputChanges(const OutputPtr &target, const OutputPtr &source, ConfigMonitor::OutputChanges changes)
+{
+    using OutputChange = ConfigMonitor::OutputChange;
+
+    if (changes.testFlag(OutputChange::Enabled)) {
+        target->setEnabled(source->isEnabled());
+    }
+    if (changes.testFlag(OutputChange::Priority)) {
+        target->setPriority(source->priority());
+    }
+    if (changes.testFlag(OutputChange::Geometry)) {
+        target->setPos(source->pos());
+        target->setSize(source->size());
+        target->setScale(source->scale());
+        target->setRotation(source->rotation());
+        target->setCurrentModeId(source->currentModeId());
+        target->setExplicitLogicalSize(source->explicitLogicalSize());
+    }
+    if (changes.testFlag(OutputChange::Modes)) {
+        target->setCustomModes(source->customModes());
+    }
+    if (changes.testFlag(OutputChange::Replication)) {
+        target->setClones(source->clones());
+        target->setReplicationSource(source->replicationSource());
+    }
+    if (changes.testFlag(OutputChange::Brightness)) {
+        target->setBrightness(source->brightness());
+        target->setDimming(source->dimming());
+        target->setSdrBrightness(source->sdrBrightness());
+        target->setAutomaticBrightness(source->automaticBrightness());
+        target->setMaxPeakBrightnessOverride(source->maxPeakBrightnessOverride());
+        target->setMaxAverageBrightnessOverride(source->maxAverageBrightnessOverride());
+        target->setMinBrightnessOverride(source->minBrightnessOverride());
+    }
+    if (changes.testFlag(OutputChange::Color)) {
+        target->setHdrEnabled(source->isHdrEnabled());
+        target->setWcgEnabled(source->isWcgEnabled());
+        target->setRgbRange(source->rgbRange());
+        target->setIccProfilePath(source->iccProfilePath());
+        target->setHdrIccProfilePath(source->hdrIccProfilePath());
+        target->setColorProfileSource(source->colorProfileSource());
+        target->setHdrColorProfileSource(source->hdrColorProfileSource());
+        target->setSdrGamutWideness(source->sdrGamutWideness());
+        target->setColorPowerPreference(source->colorPowerPreference());
+        target->setMaxBitsPerColor(source->maxBitsPerColor());
+        target->setEdrPolicy(source->edrPolicy());
+    }
+    if (changes.testFlag(OutputChange::Other)) {
+        target->setFollowPreferredMode(source->followPreferredMode());
+        target->setOverscan(source->overscan());
+        target->setVrrPolicy(source->vrrPolicy());
+        target->setAutoRotatePolicy(source->autoRotatePolicy());
+        target->setDdcCiAllowed(source->ddcCiAllowed());
+        target->setSharpness(source->sharpness());
+        target->setAbmLevel(source->abmLevel());
+    }
+}
+
 #include "moc_output.cpp"
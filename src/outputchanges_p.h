@@ -0,0 +1,33 @@
+/*
+ *  SPDX-FileCopyrightText: 2026 KScreen contributors
+ *
+ *  SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+/**
+ * WARNING: This header is *not* part of public API and is subject to change.
+ * There are not guarantees or API or ABI stability or compatibility between
+ * releases
+ */
+
+#pragma once
+
+#include "configmonitor.h"
+#include "kscreen_export.h"
+#include "types.h"
+
+namespace KScreen
+{
+/**
+ * Copies the properties of @p source in the groups @p changes to @p target,
+ * leaving the others alone. Read-only groups like Connected are ignored,
+ * Modes copies the custom modes.
+ */
+KSCREEN_EXPORT void applyOutputChanges(const KScreen::OutputPtr &target, const KScreen::OutputPtr &source, KScreen::ConfigMonitor::OutputChanges changes);
+
+/**
+ * The groups of properties that differ between @p before and @p after, the
+ * same ConfigMonitor reports.
+ */
+KSCREEN_EXPORT KScreen::ConfigMonitor::OutputChanges outputChanges(const KScreen::OutputPtr &before, const KScreen::OutputPtr &after);
+}
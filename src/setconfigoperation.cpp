@@ -12,10 +12,14 @@
 #include "config.h"
 #include "configoperation_p.h"
 #include "kscreen_debug.h"
+#include "metrics.h"
 #include "output.h"
+#include "trace_p.h"
 
 #include <QDir>
+#include <QElapsedTimer>
 #include <QFutureWatcher>
+#include <optional>
 #include <ranges>
 
 using namespace KScreen;
@@ -29,9 +33,11 @@ class SetConfigOperationPrivate : public ConfigOperationPrivate
 public:
     explicit SetConfigOperationPrivate(const KScreen::ConfigPtr &config, ConfigOperation *qq);
 
-    void fixPriorities();
-
     KScreen::ConfigPtr config;
+    // Unset to apply the whole config
+    std::optional<QHash<int, ConfigMonitor::OutputChanges>> changes;
+    quint64 expectedGeneration = 0;
+    bool stale = false;
 
 private:
     Q_DECLARE_PUBLIC(SetConfigOperation)
@@ -50,6 +56,13 @@ SetConfigOperation::SetConfigOperation(const ConfigPtr &config, QObject *parent)
 {
 }
 
+SetConfigOperation::SetConfigOperation(const ConfigPtr &config, const QHash<int, ConfigMonitor::OutputChanges> &changes, QObject *parent)
+    : SetConfigOperation(config, parent)
+{
+    Q_D(SetConfigOperation);
+    d->changes = changes;
+}
+
 SetConfigOperation::~SetConfigOperation()
 {
 }
@@ -60,29 +73,35 @@ ConfigPtr SetConfigOperation::config() const
     return d->config;
 }
 
-void SetConfigOperation::start()
+void SetConfigOperation::setExpectedGeneration(quint64 generation)
 {
     Q_D(SetConfigOperation);
-    d->fixPriorities();
-    auto backend = d->loadBackend();
-    if (!backend) {
-        return; // loadBackend() already set error and called emitResult() for us
-    }
-    QFutureWatcher<SetConfigResult> *watcher = new QFutureWatcher<SetConfigResult>(this);
-    connect(watcher, &QFutureWatcher<SetConfigResult>::finished, this, [this, watcher]() {
-        watcher->deleteLater();
-        const SetConfigResult result = watcher->result();
-        if (!result.has_value()) {
-            setError(result.error());
-        }
-        emitResult();
-    });
+    d->expectedGeneration = generation;
+}
 
-    QFuture<SetConfigResult> pendingResult = backend->setConfig(d->config);
-    watcher->setFuture(pendingResult);
+quint64 SetConfigOperation::expectedGeneration() const
+{
+    Q_D(const SetConfigOperation);
+    return d->expectedGeneration;
+}
+
+bool SetConfigOperation::isStale() const
+{
+    Q_D(const SetConfigOperation);
+    return d->stale;
+}
+
+static bool isStaleGeneration(quint64 expectedGeneration)
+{
+    return expectedGeneration != 0 && expectedGeneration != BackendManager::instance()->generation();
+}
+
+static QString staleError()
+{
+    return QStringLiteral("The configuration changed in the meantime");
 }
 
-void SetConfigOperationPrivate::fixPriorities()
+static void fixPriorities(const ConfigPtr &config)
 {
     if (!config) {
         return;
@@ -109,6 +128,108 @@ void SetConfigOperationPrivate::fixPriorities()
     }
 }
 
+QFuture<SetConfigResult> KScreen::setConfig(const ConfigPtr &config, quint64 expectedGeneration)
+{
+    QElapsedTimer preparation;
+    preparation.start();
+
+    fixPriorities(config);
+    auto backend = BackendManager::instance()->loadBackendInProcess();
+    if (!backend) {
+        return QtFuture::makeReadyValueFuture<SetConfigResult>(std::unexpected(QStringLiteral("Plugin does not provide valid KScreen backend")));
+    }
+    if (config && config->isCached()) {
+        qCDebug(KSCREEN) << "Not applying cached config, the backend state is not known yet";
+        return QtFuture::makeReadyValueFuture<SetConfigResult>(std::unexpected(staleError()));
+    }
+    if (isStaleGeneration(expectedGeneration)) {
+        qCDebug(KSCREEN) << "Not applying stale config of generation" << expectedGeneration << "current generation is"
+                         << BackendManager::instance()->generation();
+        return QtFuture::makeReadyValueFuture<SetConfigResult>(std::unexpected(staleError()));
+    }
+    Metrics::record(Metrics::Stage::Preparation, std::chrono::nanoseconds(preparation.nsecsElapsed()));
+    return backend->setConfig(config);
+}
+
+QFuture<SetConfigResult> KScreen::setConfig(const ConfigPtr &config, const QHash<int, ConfigMonitor::OutputChanges> &changes, quint64 expectedGeneration)
+{
+    QElapsedTimer preparation;
+    preparation.start();
+
+    BackendManager *manager = BackendManager::instance();
+    auto backend = manager->loadBackendInProcess();
+    if (!backend) {
+        return QtFuture::makeReadyValueFuture<SetConfigResult>(std::unexpected(QStringLiteral("Plugin does not provide valid KScreen backend")));
+    }
+    if (config && config->isCached()) {
+        qCDebug(KSCREEN) << "Not applying cached config, the backend state is not known yet";
+        return QtFuture::makeReadyValueFuture<SetConfigResult>(std::unexpected(staleError()));
+    }
+    if (isStaleGeneration(expectedGeneration)) {
+        qCDebug(KSCREEN) << "Not applying stale config of generation" << expectedGeneration << "current generation is" << manager->generation();
+        return QtFuture::makeReadyValueFuture<SetConfigResult>(std::unexpected(staleError()));
+    }
+    if (!config) {
+        return QtFuture::makeReadyValueFuture<SetConfigResult>(std::unexpected(QStringLiteral("No configuration to apply")));
+    }
+
+    // Only the named outputs are handed on, the backend takes their masked groups onto its own state,
+    // so changes made by others in the meantime survive
+    const ConfigPtr request(new Config);
+    for (auto it = changes.cbegin(); it != changes.cend(); ++it) {
+        const OutputPtr source = config->output(it.key());
+        if (!source) {
+            return QtFuture::makeReadyValueFuture<SetConfigResult>(std::unexpected(QStringLiteral("Cannot find output with id %1").arg(it.key())));
+        }
+        request->addOutput(source->clone());
+    }
+
+    Metrics::record(Metrics::Stage::Preparation, std::chrono::nanoseconds(preparation.nsecsElapsed()));
+    return backend->setPartialConfig(request, changes);
+}
+
+void SetConfigOperation::start()
+{
+    Q_D(SetConfigOperation);
+    QElapsedTimer timer;
+    timer.start();
+    const qint64 start = Trace::timestamp();
+
+    auto backend = d->loadBackend();
+    if (!backend) {
+        return; // loadBackend() already set error and called emitResult() for us
+    }
+    // A cached config is as good as one of an older generation, the backend state may have moved on
+    if ((d->config && d->config->isCached()) || isStaleGeneration(d->expectedGeneration)) {
+        d->stale = true;
+        setError(staleError());
+        emitResult();
+        return;
+    }
+
+    auto finish = [this, timer, start](const SetConfigResult &result) {
+        if (!result.has_value()) {
+            setError(result.error());
+        }
+        Metrics::record(Metrics::Stage::Apply, std::chrono::nanoseconds(timer.nsecsElapsed()));
+        Trace::complete("SetConfigOperation", start);
+        emitResult();
+    };
+
+    const QFuture<SetConfigResult> pendingResult = d->changes ? KScreen::setConfig(d->config, *d->changes) : KScreen::setConfig(d->config);
+    if (pendingResult.isFinished()) {
+        finish(pendingResult.result());
+        return;
+    }
+
+    QFutureWatcher<SetConfigResult> *watcher = new QFutureWatcher<SetConfigResult>(this);
+    connect(watcher, &QFutureWatcher<SetConfigResult>::finished, this, [watcher, finish]() {
+        watcher->deleteLater();
+        finish(watcher->result());
+    });
+    watcher->setFuture(pendingResult);
+}
+
 #include "setconfigoperation.moc"
 
 #include "moc_setconfigoperation.cpp"
@@ -7,10 +7,14 @@
 
 #pragma once
 
+#include "configmonitor.h"
 #include "configoperation.h"
 #include "kscreen_export.h"
 #include "types.h"
 
+#include <QFuture>
+#include <QHash>
+
 namespace KScreen
 {
 class SetConfigOperationPrivate;
@@ -20,10 +24,52 @@ class KSCREEN_EXPORT SetConfigOperation : public KScreen::ConfigOperation
     Q_OBJECT
 public:
     explicit SetConfigOperation(const KScreen::ConfigPtr &config, QObject *parent = nullptr);
+
+    /**
+     * Applies only some properties of some outputs of @p config.
+     *
+     * @p changes maps output ids to the groups of properties to take from
+     * @p config; everything else keeps the state the backend currently has.
+     * Only the named outputs are copied and handed to the backend, which
+     * checks and sends just those properties, so other outputs and
+     * properties changed concurrently by other clients are not reverted.
+     * Backends without support for partial changes apply a copy of their
+     * whole state with the changes taken over.
+     *
+     * Groups holding read-only properties, such as Connected or Added, are
+     * ignored. The Modes group applies the custom modes.
+     *
+     * @since 6.8
+     */
+    SetConfigOperation(const KScreen::ConfigPtr &config, const QHash<int, KScreen::ConfigMonitor::OutputChanges> &changes, QObject *parent = nullptr);
     ~SetConfigOperation() override;
 
     KScreen::ConfigPtr config() const override;
 
+    /**
+     * Only apply the config if the backend state is still at @p generation,
+     * usually the Config::generation() the config was derived from.
+     *
+     * If the state changed in the meantime (e.g. an output got unplugged), the
+     * operation fails right away, without sending anything to the compositor,
+     * and isStale() returns true. The caller can then fetch the current config
+     * and redo its changes on top of it.
+     *
+     * Zero, the default, applies the config unconditionally.
+     *
+     * @since 6.8
+     */
+    void setExpectedGeneration(quint64 generation);
+    quint64 expectedGeneration() const;
+
+    /**
+     * Whether the operation failed because the backend state moved past
+     * expectedGeneration(), or because the config was a cached one.
+     *
+     * @since 6.8
+     */
+    bool isStale() const;
+
 protected:
     void start() override;
 
@@ -31,4 +77,27 @@ private:
     Q_DECLARE_PRIVATE(SetConfigOperation)
 };
 
+/**
+ * Applies @p config to the system.
+ *
+ * Unlike SetConfigOperation this does not go through the event loop. The
+ * returned future finishes as soon as the backend is done; backends that
+ * apply synchronously hand back an already finished future. It can be chained
+ * with QFuture::then() or awaited with a coroutine library such as QCoro.
+ *
+ * @param expectedGeneration see SetConfigOperation::setExpectedGeneration()
+ * @since 6.8
+ */
+KSCREEN_EXPORT QFuture<KScreen::SetConfigResult> setConfig(const KScreen::ConfigPtr &config, quint64 expectedGeneration = 0);
+
+/**
+ * Applies only the properties of @p config named by @p changes, like the
+ * corresponding SetConfigOperation constructor.
+ *
+ * @param expectedGeneration see SetConfigOperation::setExpectedGeneration()
+ * @since 6.8
+ */
+KSCREEN_EXPORT QFuture<KScreen::SetConfigResult>
+setConfig(const KScreen::ConfigPtr &config, const QHash<int, KScreen::ConfigMonitor::OutputChanges> &changes, quint64 expectedGeneration = 0);
+
 }
@@ -0,0 +1,126 @@
+/*
+ *  SPDX-FileCopyrightText: 2026 KScreen contributors
+ *
+ *  SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "trace_p.h"
+#include "kscreen_debug.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+
+#include <atomic>
+#include <chrono>
+
+using namespace KScreen;
+
+namespace
+{
+class TraceFile
+{
+public:
+    TraceFile();
+    ~TraceFile();
+
+    void write(const char *name, qint64 start, qint64 end);
+    void flush();
+
+    bool enabled = false;
+
+private:
+    int threadId();
+
+    QMutex mutex;
+    QFile file;
+    qint64 pid = 0;
+    std::atomic<int> lastThreadId = 0;
+};
+}
+
+Q_GLOBAL_STATIC(TraceFile, s_traceFile)
+
+TraceFile::TraceFile()
+{
+    QString path = qEnvironmentVariable("KSCREEN_TRACE_FILE");
+    if (path.isEmpty()) {
+        return;
+    }
+
+    pid = QCoreApplication::applicationPid();
+    path.replace(QLatin1String("%p"), QString::number(pid));
+    file.setFileName(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qCWarning(KSCREEN) << "Cannot open trace file" << path << file.errorString();
+        return;
+    }
+
+    // The JSON array format doesn't need the closing bracket, so the file stays loadable whenever the process ends
+    const QByteArray processName = QCoreApplication::applicationName().toUtf8().replace('"', '\'').replace('\\', '/');
+    file.write("[\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" + QByteArray::number(pid) + ",\"args\":{\"name\":\"" + processName + "\"}},\n");
+    enabled = true;
+}
+
+TraceFile::~TraceFile()
+{
+    if (enabled) {
+        flush();
+    }
+}
+
+int TraceFile::threadId()
+{
+    thread_local int id = 0;
+    if (id == 0) {
+        id = ++lastThreadId;
+        QString name = QThread::currentThread()->objectName();
+        if (name.isEmpty()) {
+            name = QThread::isMainThread() ? QStringLiteral("main") : QStringLiteral("thread %1").arg(id);
+        }
+        file.write("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + QByteArray::number(pid) + ",\"tid\":" + QByteArray::number(id) + ",\"args\":{\"name\":\""
+                   + name.toUtf8().replace('"', '\'').replace('\\', '/') + "\"}},\n");
+    }
+    return id;
+}
+
+void TraceFile::write(const char *name, qint64 start, qint64 end)
+{
+    QMutexLocker locker(&mutex);
+    const int tid = threadId();
+    file.write("{\"name\":\"" + QByteArray(name) + "\",\"cat\":\"kscreen\",\"ph\":\"X\",\"ts\":" + QByteArray::number(start)
+               + ",\"dur\":" + QByteArray::number(end - start) + ",\"pid\":" + QByteArray::number(pid) + ",\"tid\":" + QByteArray::number(tid) + "},\n");
+}
+
+void TraceFile::flush()
+{
+    QMutexLocker locker(&mutex);
+    file.flush();
+}
+
+bool Trace::isEnabled()
+{
+    // Spans may still end while static objects get destroyed
+    return !s_traceFile.isDestroyed() && s_traceFile->enabled;
+}
+
+qint64 Trace::timestamp()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Trace::complete(const char *name, qint64 start)
+{
+    if (isEnabled()) {
+        s_traceFile->write(name, start, timestamp());
+    }
+}
+
+void Trace::flush()
+{
+    if (isEnabled()) {
+        s_traceFile->flush();
+    }
+}
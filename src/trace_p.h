@@ -0,0 +1,73 @@
+/*
+ *  SPDX-FileCopyrightText: 2026 KScreen contributors
+ *
+ *  SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#pragma once
+
+#include <QtGlobal>
+
+#include "kscreen_export.h"
+
+namespace KScreen
+{
+/**
+ * Opt-in recording of spans in the Chrome trace-event format.
+ *
+ * Setting KSCREEN_TRACE_FILE to a path makes the library write complete
+ * events for config operations, config propagation and EDID parsing to that
+ * file, which chrome://tracing and Perfetto load directly. A "%p" in the path
+ * is replaced by the process id, so several processes can trace at once.
+ *
+ * Timestamps are microseconds of the monotonic clock, the one compositor
+ * traces use as well, so both can be viewed side by side.
+ *
+ * WARNING: This class is *not* part of public API, it is only exported for
+ * the unit-tests.
+ */
+class KSCREEN_EXPORT Trace
+{
+public:
+    static bool isEnabled();
+
+    static qint64 timestamp();
+
+    /**
+     * Records a span named @p name from @p start until now. @p name must be
+     * a string literal without characters that need escaping in JSON.
+     */
+    static void complete(const char *name, qint64 start);
+
+    /**
+     * Writes buffered events to the file. Happens on exit as well.
+     */
+    static void flush();
+
+    /**
+     * Records a span for its lifetime.
+     */
+    class Span
+    {
+    public:
+        explicit Span(const char *name)
+            : m_name(name)
+            , m_start(isEnabled() ? timestamp() : -1)
+        {
+        }
+        ~Span()
+        {
+            if (m_start >= 0) {
+                complete(m_name, m_start);
+            }
+        }
+
+    private:
+        Q_DISABLE_COPY(Span)
+
+        const char *m_name;
+        qint64 m_start;
+    };
+};
+
+}
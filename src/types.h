@@ -8,6 +8,9 @@
 
 #include <QMap>
 #include <QSharedPointer>
+#include <QString>
+
+#include <expected>
 
 namespace KScreen
 {
@@ -23,4 +26,6 @@ class Mode;
 typedef QSharedPointer<KScreen::Mode> ModePtr;
 typedef QMap<QString, KScreen::ModePtr> ModeList;
 
+typedef std::expected<void, QString> SetConfigResult;
+
 }